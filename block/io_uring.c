@@ -16,7 +16,10 @@
 #include "block/raw-aio.h"
 #include "qemu/coroutine.h"
 #include "qemu/defer-call.h"
+#include "qemu/atomic.h"
+#include "qemu/thread.h"
 #include "qapi/error.h"
+#include "exec/memory.h" /* for ram_block_discard_disable() */
 #include "sysemu/block-backend.h"
 #include "trace.h"
 
@@ -26,6 +29,12 @@
 /* io_uring ring size */
 #define MAX_ENTRIES 128
 
+/* Number of slots in each ring's fixed file table */
+#define MAX_FIXED_FILES 64
+
+/* The kernel refuses to register buffers larger than this */
+#define MAX_FIXED_BUF_SIZE (1ULL << 30)
+
 typedef struct LuringAIOCB {
     Coroutine *co;
     struct io_uring_sqe sqeq;
@@ -58,8 +67,219 @@ struct LuringState {
     LuringQueue io_q;
 
     QEMUBH *completion_bh;
+
+    /* Drops stale registered buffers, see luring_unregister_buf() */
+    QEMUBH *sync_bh;
+
+    /*
+     * Fixed file table.  Slots are filled in lazily from the AioContext home
+     * thread by luring_fixed_file() and cleared by luring_unregister_fd()
+     * before the file descriptor is closed.  -1 marks a free slot.
+     */
+    bool has_fixed_files;
+    int fixed_fds[MAX_FIXED_FILES];
+
+    /*
+     * Copy of luring_bufs as registered with this ring, split into chunks
+     * of at most MAX_FIXED_BUF_SIZE and sorted by address.  The array index
+     * is the buf_index used for IORING_OP_READ_FIXED/WRITE_FIXED.
+     */
+    struct iovec *fixed_bufs;
+    unsigned int nr_fixed_bufs;
+    unsigned int fixed_bufs_gen;
+
+    QLIST_ENTRY(LuringState) next;
 };
 
+/* Memory registered via luring_register_buf() */
+typedef struct LuringBuf {
+    void *host;
+    size_t size;
+    unsigned int refcnt;
+} LuringBuf;
+
+/*
+ * luring_lock protects luring_states, luring_bufs and the rings' sync_bh.
+ * luring_bufs_gen is bumped on every change of luring_bufs so that rings
+ * notice they have to refresh their registered buffers before the next
+ * submission.
+ *
+ * Registered buffers stay pinned by the kernel, so discarding guest RAM
+ * (balloon, virtio-mem) would leave fixed requests on stale pages.
+ * luring_bufs is therefore only non-empty while a
+ * ram_block_discard_disable() reference is held.
+ */
+static QemuMutex luring_lock;
+static QLIST_HEAD(, LuringState) luring_states =
+    QLIST_HEAD_INITIALIZER(luring_states);
+static GArray *luring_bufs;
+static unsigned int luring_bufs_gen;
+
+static void __attribute__((__constructor__)) luring_init_globals(void)
+{
+    qemu_mutex_init(&luring_lock);
+    luring_bufs = g_array_new(false, false, sizeof(LuringBuf));
+}
+
+static gint luring_iovec_compare(gconstpointer a, gconstpointer b)
+{
+    const struct iovec *iov_a = a;
+    const struct iovec *iov_b = b;
+
+    if (iov_a->iov_base < iov_b->iov_base) {
+        return -1;
+    }
+    return iov_a->iov_base > iov_b->iov_base;
+}
+
+static void luring_drop_fixed_bufs(LuringState *s)
+{
+    if (s->nr_fixed_bufs) {
+        io_uring_unregister_buffers(&s->ring);
+        s->nr_fixed_bufs = 0;
+    }
+    g_free(s->fixed_bufs);
+    s->fixed_bufs = NULL;
+}
+
+/*
+ * Unpin buffers that were unregistered, even if the ring is idle.  The
+ * remaining ones are registered again lazily by the next submission.
+ */
+static void luring_sync_bh(void *opaque)
+{
+    LuringState *s = opaque;
+
+    if (qatomic_load_acquire(&luring_bufs_gen) != s->fixed_bufs_gen) {
+        luring_drop_fixed_bufs(s);
+    }
+}
+
+/**
+ * luring_sync_fixed_bufs:
+ *
+ * Replace the buffers registered with the ring by the current contents of
+ * luring_bufs.  Called from the AioContext home thread before a submission
+ * looks up fixed buffers, so that memory that has been unregistered is never
+ * referenced by a new request.
+ */
+static void luring_sync_fixed_bufs(LuringState *s)
+{
+    GArray *iovs = g_array_new(false, false, sizeof(struct iovec));
+    unsigned int i;
+    int ret;
+
+    qemu_mutex_lock(&luring_lock);
+    s->fixed_bufs_gen = luring_bufs_gen;
+    for (i = 0; i < luring_bufs->len; i++) {
+        LuringBuf *buf = &g_array_index(luring_bufs, LuringBuf, i);
+        size_t offset;
+
+        for (offset = 0; offset < buf->size; offset += MAX_FIXED_BUF_SIZE) {
+            struct iovec iov = {
+                .iov_base = buf->host + offset,
+                .iov_len = MIN(buf->size - offset, MAX_FIXED_BUF_SIZE),
+            };
+            g_array_append_val(iovs, iov);
+        }
+    }
+    qemu_mutex_unlock(&luring_lock);
+
+    g_array_sort(iovs, luring_iovec_compare);
+
+    luring_drop_fixed_bufs(s);
+
+    /*
+     * Each ring pins its buffers separately and may run into
+     * RLIMIT_MEMLOCK; requests then use plain readv/writev.
+     */
+    if (iovs->len) {
+        ret = io_uring_register_buffers(&s->ring,
+                                        (struct iovec *)iovs->data, iovs->len);
+        trace_luring_register_buffers(s, iovs->len, ret);
+        if (ret == 0) {
+            s->nr_fixed_bufs = iovs->len;
+            s->fixed_bufs = (struct iovec *)g_array_free(iovs, false);
+            return;
+        }
+    }
+    g_array_free(iovs, true);
+}
+
+/**
+ * luring_fixed_buf_index:
+ *
+ * Returns the index of the registered buffer that contains @len bytes at
+ * @base, or -1 if the range is not entirely inside one registered buffer.
+ */
+static int luring_fixed_buf_index(LuringState *s, void *base, size_t len)
+{
+    unsigned int lo = 0, hi;
+
+    if (qatomic_load_acquire(&luring_bufs_gen) != s->fixed_bufs_gen) {
+        luring_sync_fixed_bufs(s);
+    }
+
+    /* Find the last buffer starting at or below @base */
+    hi = s->nr_fixed_bufs;
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+
+        if (s->fixed_bufs[mid].iov_base <= base) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return -1;
+    }
+    lo--;
+
+    if (base + len > s->fixed_bufs[lo].iov_base + s->fixed_bufs[lo].iov_len) {
+        return -1;
+    }
+    return lo;
+}
+
+/**
+ * luring_fixed_file:
+ *
+ * Returns the fixed file slot for @fd, registering it with the ring if it has
+ * not been seen before, or -1 if @fd must be used as a normal file descriptor.
+ */
+static int luring_fixed_file(LuringState *s, int fd)
+{
+    int free_slot = -1;
+    int i, ret;
+
+    if (!s->has_fixed_files) {
+        return -1;
+    }
+
+    for (i = 0; i < MAX_FIXED_FILES; i++) {
+        int slot_fd = qatomic_read(&s->fixed_fds[i]);
+
+        if (slot_fd == fd) {
+            return i;
+        }
+        if (slot_fd == -1 && free_slot == -1) {
+            free_slot = i;
+        }
+    }
+    if (free_slot == -1) {
+        return -1;
+    }
+
+    ret = io_uring_register_files_update(&s->ring, free_slot, &fd, 1);
+    trace_luring_register_file(s, fd, free_slot, ret);
+    if (ret < 0) {
+        return -1;
+    }
+    qatomic_set(&s->fixed_fds[free_slot], fd);
+    return free_slot;
+}
+
 /**
  * luring_resubmit:
  *
@@ -90,6 +310,15 @@ static void luring_resubmit_short_read(LuringState *s, LuringAIOCB *luringcb,
     luringcb->total_read += nread;
     remaining = luringcb->qiov->size - luringcb->total_read;
 
+    /* Fixed buffer reads just continue further into the same buffer */
+    if (luringcb->sqeq.opcode == IORING_OP_READ_FIXED) {
+        luringcb->sqeq.off += nread;
+        luringcb->sqeq.addr += nread;
+        luringcb->sqeq.len = remaining;
+        luring_resubmit(s, luringcb);
+        return;
+    }
+
     /* Shorten qiov */
     resubmit_qiov = &luringcb->resubmit_qiov;
     if (resubmit_qiov->iov == NULL) {
@@ -330,28 +559,48 @@ static void luring_deferred_fn(void *opaque)
  * @s: AIO state
  * @offset: offset for request
  * @type: type of request
+ * @flags: request flags
  *
  * Fetches sqes from ring, adds to pending queue and preps them
  *
+ * Single-buffer requests with BDRV_REQ_REGISTERED_BUF that lie entirely
+ * inside memory registered with luring_register_buf() are submitted as
+ * IORING_OP_READ_FIXED/WRITE_FIXED, and @fd is used through the ring's fixed
+ * file table when a slot is available.
  */
 static int luring_do_submit(int fd, LuringAIOCB *luringcb, LuringState *s,
-                            uint64_t offset, int type)
+                            uint64_t offset, int type,
+                            BdrvRequestFlags flags)
 {
     int ret;
+    int buf_index = -1;
+    int fixed_fd;
     struct io_uring_sqe *sqes = &luringcb->sqeq;
+    struct iovec *iov = luringcb->qiov ? luringcb->qiov->iov : NULL;
+
+    if ((flags & BDRV_REQ_REGISTERED_BUF) && iov && luringcb->qiov->niov == 1) {
+        buf_index = luring_fixed_buf_index(s, iov->iov_base, iov->iov_len);
+    }
 
     switch (type) {
     case QEMU_AIO_WRITE:
-        io_uring_prep_writev(sqes, fd, luringcb->qiov->iov,
-                             luringcb->qiov->niov, offset);
-        break;
     case QEMU_AIO_ZONE_APPEND:
-        io_uring_prep_writev(sqes, fd, luringcb->qiov->iov,
-                             luringcb->qiov->niov, offset);
+        if (buf_index >= 0) {
+            io_uring_prep_write_fixed(sqes, fd, iov->iov_base, iov->iov_len,
+                                      offset, buf_index);
+        } else {
+            io_uring_prep_writev(sqes, fd, luringcb->qiov->iov,
+                                 luringcb->qiov->niov, offset);
+        }
         break;
     case QEMU_AIO_READ:
-        io_uring_prep_readv(sqes, fd, luringcb->qiov->iov,
-                            luringcb->qiov->niov, offset);
+        if (buf_index >= 0) {
+            io_uring_prep_read_fixed(sqes, fd, iov->iov_base, iov->iov_len,
+                                     offset, buf_index);
+        } else {
+            io_uring_prep_readv(sqes, fd, luringcb->qiov->iov,
+                                luringcb->qiov->niov, offset);
+        }
         break;
     case QEMU_AIO_FLUSH:
         io_uring_prep_fsync(sqes, fd, IORING_FSYNC_DATASYNC);
@@ -363,6 +612,12 @@ static int luring_do_submit(int fd, LuringAIOCB *luringcb, LuringState *s,
     }
     io_uring_sqe_set_data(sqes, luringcb);
 
+    fixed_fd = luring_fixed_file(s, fd);
+    if (fixed_fd >= 0) {
+        sqes->fd = fixed_fd;
+        sqes->flags |= IOSQE_FIXED_FILE;
+    }
+
     QSIMPLEQ_INSERT_TAIL(&s->io_q.submit_queue, luringcb, next);
     s->io_q.in_queue++;
     trace_luring_do_submit(s, s->io_q.blocked, s->io_q.in_queue,
@@ -380,7 +635,8 @@ static int luring_do_submit(int fd, LuringAIOCB *luringcb, LuringState *s,
 }
 
 int coroutine_fn luring_co_submit(BlockDriverState *bs, int fd, uint64_t offset,
-                                  QEMUIOVector *qiov, int type)
+                                  QEMUIOVector *qiov, int type,
+                                  BdrvRequestFlags flags)
 {
     int ret;
     AioContext *ctx = qemu_get_current_aio_context();
@@ -393,7 +649,7 @@ int coroutine_fn luring_co_submit(BlockDriverState *bs, int fd, uint64_t offset,
     };
     trace_luring_co_submit(bs, s, &luringcb, fd, offset, qiov ? qiov->size : 0,
                            type);
-    ret = luring_do_submit(fd, &luringcb, s, offset, type);
+    ret = luring_do_submit(fd, &luringcb, s, offset, type, flags);
 
     if (ret < 0) {
         return ret;
@@ -410,6 +666,10 @@ void luring_detach_aio_context(LuringState *s, AioContext *old_context)
     aio_set_fd_handler(old_context, s->ring.ring_fd,
                        NULL, NULL, NULL, NULL, s);
     qemu_bh_delete(s->completion_bh);
+    qemu_mutex_lock(&luring_lock);
+    qemu_bh_delete(s->sync_bh);
+    s->sync_bh = NULL;
+    qemu_mutex_unlock(&luring_lock);
     s->aio_context = NULL;
 }
 
@@ -417,6 +677,9 @@ void luring_attach_aio_context(LuringState *s, AioContext *new_context)
 {
     s->aio_context = new_context;
     s->completion_bh = aio_bh_new(new_context, qemu_luring_completion_bh, s);
+    qemu_mutex_lock(&luring_lock);
+    s->sync_bh = aio_bh_new(new_context, luring_sync_bh, s);
+    qemu_mutex_unlock(&luring_lock);
     aio_set_fd_handler(s->aio_context, s->ring.ring_fd,
                        qemu_luring_completion_cb, NULL,
                        qemu_luring_poll_cb, qemu_luring_poll_ready, s);
@@ -424,7 +687,7 @@ void luring_attach_aio_context(LuringState *s, AioContext *new_context)
 
 LuringState *luring_init(Error **errp)
 {
-    int rc;
+    int rc, i;
     LuringState *s = g_new0(LuringState, 1);
     struct io_uring *ring = &s->ring;
 
@@ -438,13 +701,124 @@ LuringState *luring_init(Error **errp)
     }
 
     ioq_init(&s->io_q);
+
+    /*
+     * Register an empty fixed file table that is filled in on demand.  Older
+     * kernels may not support it, in which case plain fds are used.
+     */
+    for (i = 0; i < MAX_FIXED_FILES; i++) {
+        s->fixed_fds[i] = -1;
+    }
+    rc = io_uring_register_files(ring, s->fixed_fds, MAX_FIXED_FILES);
+    s->has_fixed_files = (rc == 0);
+
+    /* Registered buffers are synced on first use */
+    s->fixed_bufs_gen = qatomic_read(&luring_bufs_gen) - 1;
+
+    qemu_mutex_lock(&luring_lock);
+    QLIST_INSERT_HEAD(&luring_states, s, next);
+    qemu_mutex_unlock(&luring_lock);
     return s;
 
 }
 
 void luring_cleanup(LuringState *s)
 {
+    qemu_mutex_lock(&luring_lock);
+    QLIST_REMOVE(s, next);
+    qemu_mutex_unlock(&luring_lock);
+
     io_uring_queue_exit(&s->ring);
+    g_free(s->fixed_bufs);
     trace_luring_cleanup_state(s);
     g_free(s);
 }
+
+bool luring_register_buf(void *host, size_t size, Error **errp)
+{
+    unsigned int i;
+    int ret;
+
+    qemu_mutex_lock(&luring_lock);
+    for (i = 0; i < luring_bufs->len; i++) {
+        LuringBuf *buf = &g_array_index(luring_bufs, LuringBuf, i);
+
+        if (buf->host == host && buf->size == size) {
+            buf->refcnt++;
+            qemu_mutex_unlock(&luring_lock);
+            return true;
+        }
+    }
+
+    /* Pinned guest RAM must not be discarded behind the kernel's back */
+    if (luring_bufs->len == 0) {
+        ret = ram_block_discard_disable(true);
+        if (ret < 0) {
+            qemu_mutex_unlock(&luring_lock);
+            error_setg_errno(errp, -ret, "Cannot use io_uring fixed buffers "
+                             "while RAM discard is in use");
+            return false;
+        }
+    }
+
+    g_array_append_val(luring_bufs, ((LuringBuf) {
+        .host = host,
+        .size = size,
+        .refcnt = 1,
+    }));
+    qatomic_store_release(&luring_bufs_gen, luring_bufs_gen + 1);
+    qemu_mutex_unlock(&luring_lock);
+    return true;
+}
+
+void luring_unregister_buf(void *host, size_t size)
+{
+    LuringState *s;
+    unsigned int i;
+
+    qemu_mutex_lock(&luring_lock);
+    for (i = 0; i < luring_bufs->len; i++) {
+        LuringBuf *buf = &g_array_index(luring_bufs, LuringBuf, i);
+
+        if (buf->host == host && buf->size == size) {
+            if (--buf->refcnt == 0) {
+                g_array_remove_index_fast(luring_bufs, i);
+                qatomic_store_release(&luring_bufs_gen, luring_bufs_gen + 1);
+                QLIST_FOREACH(s, &luring_states, next) {
+                    if (s->sync_bh) {
+                        qemu_bh_schedule(s->sync_bh);
+                    }
+                }
+                if (luring_bufs->len == 0) {
+                    ram_block_discard_disable(false);
+                }
+            }
+            break;
+        }
+    }
+    qemu_mutex_unlock(&luring_lock);
+}
+
+void luring_unregister_fd(int fd)
+{
+    LuringState *s;
+    int i;
+
+    qemu_mutex_lock(&luring_lock);
+    QLIST_FOREACH(s, &luring_states, next) {
+        for (i = 0; i < MAX_FIXED_FILES; i++) {
+            if (qatomic_read(&s->fixed_fds[i]) == fd) {
+                int unused = -1;
+
+                /*
+                 * Drop the kernel's reference before freeing the slot so
+                 * that the home thread can't reuse it while it still points
+                 * to the old file.
+                 */
+                io_uring_register_files_update(&s->ring, i, &unused, 1);
+                qatomic_set(&s->fixed_fds[i], -1);
+            }
+        }
+    }
+    qemu_mutex_unlock(&luring_lock);
+}
@@ -687,6 +687,8 @@ static int xml_parse(char *filename, struct dynsoc_board_info *b_info)
                     b_info->dev[i].type = DYNSOC_MCA;
                 } else if (!strcmp(tmp, "FFT")) {
                     b_info->dev[i].type = DYNSOC_FFT;
+                } else if (!strcmp(tmp, "CUSTOM")) {
+                    b_info->dev[i].type = DYNSOC_CUSTOM;
                 } else if (!strcmp(tmp, "INTC")) {
                     b_info->dev[i].type = DYNSOC_INTC;
                     b_info->set_intc = 1;
@@ -707,6 +709,11 @@ static int xml_parse(char *filename, struct dynsoc_board_info *b_info)
                 } else {
                     b_info->dev[i].irq = strtoul((char *)xc, NULL, 10);
                 }
+                /* worker threads of a CUSTOM device, optional */
+                xc = xmlGetProp(cur1, BAD_CAST"workers");
+                if (xc != NULL) {
+                    b_info->dev[i].workers = strtoul((char *)xc, NULL, 10);
+                }
             }
 
             if (b_info->set_intc == 0) {
@@ -848,6 +855,7 @@ static int check_cpu_info(struct dynsoc_board_info *b_info)
 }
 
 #define DEV_ALIGN_SIZE 0x100
+#define DEV_MAX_WORKERS 64
 static int check_device(struct dynsoc_board_info *b_info)
 {
     int i = 0,
@@ -905,6 +913,13 @@ static int check_device(struct dynsoc_board_info *b_info)
             }
         }
 
+        if (b_info->dev[i].workers > DEV_MAX_WORKERS) {
+            printf("Error: Device %s workers=%u is out of range[0-%d].\n",
+                   b_info->dev[i].name, b_info->dev[i].workers,
+                   DEV_MAX_WORKERS);
+            ret = 1;
+        }
+
         /* check address/irq conflict */
         j = i + 1;
         while (b_info->dev[j].type != DYNSOC_EMPTY) {
@@ -12,6 +12,8 @@
 #define CPUINFO_AES             (1u << 3)
 #define CPUINFO_PMULL           (1u << 4)
 #define CPUINFO_BTI             (1u << 5)
+#define CPUINFO_ASIMD           (1u << 6)
+#define CPUINFO_SHA2            (1u << 7)
 
 /* Initialized with a constructor. */
 extern unsigned cpuinfo;
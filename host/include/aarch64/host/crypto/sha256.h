@@ -0,0 +1,53 @@
+/*
+ * AArch64 specific SHA-256 acceleration.
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef AARCH64_HOST_CRYPTO_SHA256_H
+#define AARCH64_HOST_CRYPTO_SHA256_H
+
+#include "host/cpuinfo.h"
+#include <arm_neon.h>
+
+/*
+ * SHA256H/SHA256H2 perform four rounds on an {ABCD, EFGH} split state,
+ * which does not decompose into the two-round step, so only the message
+ * schedule is accelerated.
+ */
+#define HAVE_SHA256_ROUND_ACCEL  false
+
+#ifdef __ARM_FEATURE_SHA2
+# define HAVE_SHA256_SCHED_ACCEL  true
+#else
+# define HAVE_SHA256_SCHED_ACCEL  likely(cpuinfo & CPUINFO_SHA2)
+#endif
+#if !defined(__ARM_FEATURE_SHA2) && defined(CONFIG_ARM_AES_BUILTIN)
+# define ATTR_SHA256_ACCEL  __attribute__((target("+crypto")))
+#else
+# define ATTR_SHA256_ACCEL
+#endif
+
+void sha256_2rounds_accel(uint32_t *, const uint32_t *, const uint32_t *)
+    QEMU_ERROR("unsupported accel");
+
+static inline void ATTR_SHA256_ACCEL
+sha256_sched_accel(uint32_t *w0, const uint32_t *w4, const uint32_t *w12)
+{
+    uint32x4_t a = vld1q_u32(w0);
+    uint32x4_t b = vld1q_u32(w4);
+    uint32x4_t c = vld1q_u32(w12);
+
+    /* SHA256SU1 only reads lanes 1..3 of its W[8..11] operand. */
+#ifdef CONFIG_ARM_AES_BUILTIN
+    a = vsha256su0q_u32(a, b);
+    a = vsha256su1q_u32(a, b, c);
+#else
+    asm(".arch_extension sha2\n\t"
+        "sha256su0 %0.4s, %1.4s\n\t"
+        "sha256su1 %0.4s, %1.4s, %2.4s"
+        : "+w"(a) : "w"(b), "w"(c));
+#endif
+    vst1q_u32(w0, a);
+}
+
+#endif /* AARCH64_HOST_CRYPTO_SHA256_H */
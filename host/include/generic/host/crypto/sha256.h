@@ -0,0 +1,18 @@
+/*
+ * No host specific SHA-256 acceleration.
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GENERIC_HOST_CRYPTO_SHA256_H
+#define GENERIC_HOST_CRYPTO_SHA256_H
+
+#define HAVE_SHA256_ROUND_ACCEL  false
+#define HAVE_SHA256_SCHED_ACCEL  false
+#define ATTR_SHA256_ACCEL
+
+void sha256_2rounds_accel(uint32_t *, const uint32_t *, const uint32_t *)
+    QEMU_ERROR("unsupported accel");
+void sha256_sched_accel(uint32_t *, const uint32_t *, const uint32_t *)
+    QEMU_ERROR("unsupported accel");
+
+#endif /* GENERIC_HOST_CRYPTO_SHA256_H */
@@ -0,0 +1,46 @@
+/*
+ * x86 specific SHA-256 acceleration.
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef X86_HOST_CRYPTO_SHA256_H
+#define X86_HOST_CRYPTO_SHA256_H
+
+#include "host/cpuinfo.h"
+#include <immintrin.h>
+
+/* The message schedule requires PALIGNR as well. */
+#if defined(__SHA__) && defined(__SSSE3__)
+# define HAVE_SHA256_ROUND_ACCEL  true
+# define HAVE_SHA256_SCHED_ACCEL  true
+# define ATTR_SHA256_ACCEL
+#else
+# define HAVE_SHA256_ROUND_ACCEL  likely(cpuinfo & CPUINFO_SHA)
+# define HAVE_SHA256_SCHED_ACCEL  likely(cpuinfo & CPUINFO_SHA)
+# define ATTR_SHA256_ACCEL  __attribute__((target("sha,ssse3")))
+#endif
+
+static inline void ATTR_SHA256_ACCEL
+sha256_2rounds_accel(uint32_t *cdgh, const uint32_t *abef, const uint32_t *wk)
+{
+    __m128i s0 = _mm_loadu_si128((const __m128i *)abef);
+    __m128i s1 = _mm_loadu_si128((const __m128i *)cdgh);
+    __m128i k = _mm_loadl_epi64((const __m128i *)wk);
+
+    _mm_storeu_si128((__m128i *)cdgh, _mm_sha256rnds2_epu32(s1, s0, k));
+}
+
+static inline void ATTR_SHA256_ACCEL
+sha256_sched_accel(uint32_t *w0, const uint32_t *w4, const uint32_t *w12)
+{
+    __m128i a = _mm_loadu_si128((const __m128i *)w0);
+    __m128i b = _mm_loadu_si128((const __m128i *)w4);
+    __m128i c = _mm_loadu_si128((const __m128i *)w12);
+    __m128i t;
+
+    t = _mm_sha256msg1_epu32(a, b);
+    t = _mm_add_epi32(t, _mm_alignr_epi8(c, b, 4));
+    _mm_storeu_si128((__m128i *)w0, _mm_sha256msg2_epu32(t, c));
+}
+
+#endif /* X86_HOST_CRYPTO_SHA256_H */
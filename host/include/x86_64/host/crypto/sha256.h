@@ -0,0 +1 @@
+#include "host/include/i386/host/crypto/sha256.h"
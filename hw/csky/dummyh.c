@@ -32,6 +32,7 @@
 #include "exec/address-spaces.h"
 #include "qemu/error-report.h"
 #include "hw/csky/dynsoc.h"
+#include "hw/misc/dynsoc_device.h"
 #include "hw/char/csky_uart.h"
 #include "hw/timer/csky_timer.h"
 #include "hw/intc/csky_intc.h"
@@ -188,9 +189,14 @@ static void dummyh_init(MachineState *machine)
 
             break;
         case DYNSOC_USB:
-        case DYNSOC_CUSTOM:
                 /* todo */
             break;
+        case DYNSOC_CUSTOM:
+            dynsoc_device_create(b_info->dev[i].name, b_info->dev[i].addr,
+                                 b_info->dev[i].workers,
+                                 b_info->dev[i].irq != 0xdeadbeef ?
+                                 intc[b_info->dev[i].irq] : NULL);
+            break;
         default:
             fprintf(stderr, "not support device type\n");
             exit(1);
@@ -26,6 +26,7 @@
 #include "qemu/error-report.h"
 #include "qemu/log.h"
 #include "qemu/module.h"
+#include "qemu/main-loop.h"
 #include "hw/sysbus.h"
 #include "target/riscv/cpu.h"
 #include "hw/qdev-properties.h"
@@ -57,6 +58,10 @@ static uint64_t cpu_riscv_read_rtc(void *opaque)
 /*
  * Called when timecmp is written to update the QEMU timer or immediately
  * trigger timer interrupt if mtimecmp <= current timer value.
+ *
+ * The MMIO regions are dispatched without the BQL; take it here so that the
+ * interrupt lines and the QEMU timer are updated atomically with respect to
+ * riscv_aclint_mtimer_cb().
  */
 static void riscv_aclint_mtimer_write_timecmp(RISCVAclintMTimerState *mtimer,
                                               RISCVCPU *cpu,
@@ -66,13 +71,15 @@ static void riscv_aclint_mtimer_write_timecmp(RISCVAclintMTimerState *mtimer,
     uint32_t timebase_freq = mtimer->timebase_freq;
     uint64_t next;
     uint64_t diff;
+    uint64_t rtc;
 
-    uint64_t rtc = cpu_riscv_read_rtc(mtimer);
+    BQL_LOCK_GUARD();
+    rtc = cpu_riscv_read_rtc(mtimer);
 
     /* Compute the relative hartid w.r.t the socket */
     hartid = hartid - mtimer->hartid_base;
 
-    mtimer->timecmp[hartid] = value;
+    qatomic_set_u64(&mtimer->timecmp[hartid], value);
     if (mtimer->timecmp[hartid] <= rtc) {
         /*
          * If we're setting an MTIMECMP value in the "past",
@@ -149,11 +156,11 @@ static uint64_t riscv_aclint_mtimer_read(void *opaque, hwaddr addr,
                           "aclint-mtimer: invalid hartid: %zu", hartid);
         } else if ((addr & 0x7) == 0) {
             /* timecmp_lo for RV32/RV64 or timecmp for RV64 */
-            uint64_t timecmp = mtimer->timecmp[hartid];
+            uint64_t timecmp = qatomic_read_u64(&mtimer->timecmp[hartid]);
             return (size == 4) ? (timecmp & 0xFFFFFFFF) : timecmp;
         } else if ((addr & 0x7) == 4) {
             /* timecmp_hi */
-            uint64_t timecmp = mtimer->timecmp[hartid];
+            uint64_t timecmp = qatomic_read_u64(&mtimer->timecmp[hartid]);
             return (timecmp >> 32) & 0xFFFFFFFF;
         } else {
             qemu_log_mask(LOG_UNIMP,
@@ -221,8 +228,12 @@ static void riscv_aclint_mtimer_write(void *opaque, hwaddr addr,
         return;
     } else if ((mtimer->time_base != UINT32_MAX) &&
                (addr == mtimer->time_base || addr == mtimer->time_base + 4)) {
-        uint64_t rtc_r = cpu_riscv_read_rtc_raw(mtimer->timebase_freq);
-        uint64_t rtc = cpu_riscv_read_rtc(mtimer);
+        uint64_t rtc_r, rtc;
+
+        /* Rare, and every hart's timer is reprogrammed: take the BQL. */
+        BQL_LOCK_GUARD();
+        rtc_r = cpu_riscv_read_rtc_raw(mtimer->timebase_freq);
+        rtc = cpu_riscv_read_rtc(mtimer);
 
         if (addr == mtimer->time_base) {
             if (size == 4) {
@@ -298,6 +309,7 @@ static void riscv_aclint_mtimer_realize(DeviceState *dev, Error **errp)
 
     memory_region_init_io(&s->mmio, OBJECT(dev), &riscv_aclint_mtimer_ops,
                           s, TYPE_RISCV_ACLINT_MTIMER, s->aperture_size);
+    memory_region_enable_lockless_io(&s->mmio);
     sysbus_init_mmio(SYS_BUS_DEVICE(dev), &s->mmio);
 
     s->timer_irqs = g_new(qemu_irq, s->num_harts * 2);
@@ -441,7 +453,8 @@ static uint64_t riscv_aclint_swi_read(void *opaque, hwaddr addr,
             qemu_log_mask(LOG_GUEST_ERROR,
                           "aclint-swi: invalid hartid: %zu", hartid);
         } else if ((addr & 0x3) == 0) {
-            return (swi->sswi) ? 0 : ((env->mip & MIP_MSIP) > 0);
+            return (swi->sswi) ? 0 :
+                   ((qatomic_read_u64(&env->mip) & MIP_MSIP) > 0);
         }
     }
 
@@ -464,21 +477,38 @@ static void riscv_aclint_swi_write(void *opaque, hwaddr addr, uint64_t value,
             qemu_log_mask(LOG_GUEST_ERROR,
                           "aclint-swi: invalid hartid: %zu", hartid);
         } else if ((addr & 0x3) == 0) {
+            size_t i = hartid - swi->hartid_base;
+            qemu_irq clic_irq = swi->soft_irqs[swi->num_harts + i];
+            uint64_t bit = swi->sswi ? MIP_SSIP : MIP_MSIP;
+            bool level;
+
+            /*
+             * IPIs are sent and acknowledged without the BQL; only take it
+             * when the interrupt line actually changes.  The barrier orders
+             * the guest's earlier stores before the mip read; it pairs with
+             * the atomic update of interrupt_request that follows every mip
+             * update in riscv_cpu_update_mip().
+             *
+             * CLIC lines are edge triggered and re-pended on each raise, and
+             * mip is not maintained in CLIC mode, so they always take the
+             * slow path.
+             */
+            smp_mb();
+            level = qatomic_read_u64(&env->mip) & bit;
+            if (!clic_irq && ((value & 0x1) ? level : (swi->sswi || !level))) {
+                return;
+            }
+
+            BQL_LOCK_GUARD();
             if (value & 0x1) {
-                qemu_irq_raise(swi->soft_irqs[hartid - swi->hartid_base]);
-                if (swi->soft_irqs[swi->num_harts + hartid -
-                    swi->hartid_base]) {
-                    qemu_irq_raise(swi->soft_irqs[swi->num_harts + hartid -
-                                                  swi->hartid_base]);
+                qemu_irq_raise(swi->soft_irqs[i]);
+                if (clic_irq) {
+                    qemu_irq_raise(clic_irq);
                 }
-            } else {
-                if (!swi->sswi) {
-                    qemu_irq_lower(swi->soft_irqs[hartid - swi->hartid_base]);
-                    if (swi->soft_irqs[swi->num_harts + hartid -
-                        swi->hartid_base]) {
-                        qemu_irq_lower(swi->soft_irqs[swi->num_harts + hartid -
-                                                      swi->hartid_base]);
-                    }
+            } else if (!swi->sswi) {
+                qemu_irq_lower(swi->soft_irqs[i]);
+                if (clic_irq) {
+                    qemu_irq_lower(clic_irq);
                 }
             }
             return;
@@ -515,6 +545,7 @@ static void riscv_aclint_swi_realize(DeviceState *dev, Error **errp)
 
     memory_region_init_io(&swi->mmio, OBJECT(dev), &riscv_aclint_swi_ops, swi,
                           TYPE_RISCV_ACLINT_SWI, swi->swi_size);
+    memory_region_enable_lockless_io(&swi->mmio);
     sysbus_init_mmio(SYS_BUS_DEVICE(dev), &swi->mmio);
 
     swi->soft_irqs = g_new(qemu_irq, 2 * swi->num_harts);
@@ -22,6 +22,7 @@
 #include "qemu/module.h"
 #include "qemu/error-report.h"
 #include "qemu/bswap.h"
+#include "qemu/bitmap.h"
 #include "exec/address-spaces.h"
 #include "hw/sysbus.h"
 #include "hw/pci/msi.h"
@@ -159,6 +160,64 @@ static bool is_kvm_aia(bool msimode)
     return kvm_irqchip_in_kernel() && msimode;
 }
 
+static unsigned long *riscv_aplic_idc_prio_map(RISCVAPLICState *aplic,
+                                              uint32_t idc)
+{
+    return &aplic->idc_ready_prio[idc * aplic->idc_ready_prio_longs];
+}
+
+/* Add or remove @irq from the ready set of the IDC it targets */
+static void riscv_aplic_idc_ready(RISCVAPLICState *aplic, uint32_t irq,
+                                  bool ready)
+{
+    uint32_t idc, iprio;
+    unsigned long **map;
+
+    if (aplic->msimode) {
+        return;
+    }
+
+    idc = aplic->target[irq] >> APLIC_TARGET_HART_IDX_SHIFT;
+    idc &= APLIC_TARGET_HART_IDX_MASK;
+    if (aplic->num_harts <= idc) {
+        return;
+    }
+
+    iprio = aplic->target[irq] & aplic->iprio_mask;
+    map = &aplic->idc_ready[idc * (aplic->iprio_mask + 1) + iprio];
+    if (ready) {
+        if (!*map) {
+            *map = bitmap_new(aplic->num_irqs);
+        }
+        set_bit(irq, *map);
+        set_bit(iprio, riscv_aplic_idc_prio_map(aplic, idc));
+    } else if (*map) {
+        clear_bit(irq, *map);
+        if (bitmap_empty(*map, aplic->num_irqs)) {
+            clear_bit(iprio, riscv_aplic_idc_prio_map(aplic, idc));
+        }
+    }
+}
+
+static void riscv_aplic_set_state(RISCVAPLICState *aplic, uint32_t irq,
+                                  uint32_t mask, bool set)
+{
+    uint32_t old = aplic->state[irq];
+    bool was_ready, ready;
+
+    if (set) {
+        aplic->state[irq] |= mask;
+    } else {
+        aplic->state[irq] &= ~mask;
+    }
+
+    was_ready = (old & APLIC_ISTATE_ENPEND) == APLIC_ISTATE_ENPEND;
+    ready = (aplic->state[irq] & APLIC_ISTATE_ENPEND) == APLIC_ISTATE_ENPEND;
+    if (was_ready != ready) {
+        riscv_aplic_idc_ready(aplic, irq, ready);
+    }
+}
+
 static uint32_t riscv_aplic_read_input_word(RISCVAPLICState *aplic,
                                             uint32_t word)
 {
@@ -209,11 +268,7 @@ static uint32_t riscv_aplic_read_pending_word(RISCVAPLICState *aplic,
 static void riscv_aplic_set_pending_raw(RISCVAPLICState *aplic,
                                         uint32_t irq, bool pending)
 {
-    if (pending) {
-        aplic->state[irq] |= APLIC_ISTATE_PENDING;
-    } else {
-        aplic->state[irq] &= ~APLIC_ISTATE_PENDING;
-    }
+    riscv_aplic_set_state(aplic, irq, APLIC_ISTATE_PENDING, pending);
 }
 
 static void riscv_aplic_set_pending(RISCVAPLICState *aplic,
@@ -291,11 +346,7 @@ static uint32_t riscv_aplic_read_enabled_word(RISCVAPLICState *aplic,
 static void riscv_aplic_set_enabled_raw(RISCVAPLICState *aplic,
                                         uint32_t irq, bool enabled)
 {
-    if (enabled) {
-        aplic->state[irq] |= APLIC_ISTATE_ENABLED;
-    } else {
-        aplic->state[irq] &= ~APLIC_ISTATE_ENABLED;
-    }
+    riscv_aplic_set_state(aplic, irq, APLIC_ISTATE_ENABLED, enabled);
 }
 
 static void riscv_aplic_set_enabled(RISCVAPLICState *aplic,
@@ -425,43 +476,27 @@ static void riscv_aplic_msi_irq_update(RISCVAPLICState *aplic, uint32_t irq)
 
 static uint32_t riscv_aplic_idc_topi(RISCVAPLICState *aplic, uint32_t idc)
 {
-    uint32_t best_irq, best_iprio;
-    uint32_t irq, iprio, ihartidx, ithres;
+    uint32_t nprio = aplic->iprio_mask + 1;
+    uint32_t irq, iprio, ithres;
 
-    if (aplic->num_harts <= idc) {
+    if (aplic->msimode || aplic->num_harts <= idc) {
         return 0;
     }
 
+    /*
+     * The lowest non-empty priority level holds the best candidate;
+     * within a level the lowest source number wins.
+     */
+    iprio = find_first_bit(riscv_aplic_idc_prio_map(aplic, idc), nprio);
     ithres = aplic->ithreshold[idc];
-    best_irq = best_iprio = UINT32_MAX;
-    for (irq = 1; irq < aplic->num_irqs; irq++) {
-        if ((aplic->state[irq] & APLIC_ISTATE_ENPEND) !=
-            APLIC_ISTATE_ENPEND) {
-            continue;
-        }
-
-        ihartidx = aplic->target[irq] >> APLIC_TARGET_HART_IDX_SHIFT;
-        ihartidx &= APLIC_TARGET_HART_IDX_MASK;
-        if (ihartidx != idc) {
-            continue;
-        }
-
-        iprio = aplic->target[irq] & aplic->iprio_mask;
-        if (ithres && iprio >= ithres) {
-            continue;
-        }
-
-        if (iprio < best_iprio) {
-            best_irq = irq;
-            best_iprio = iprio;
-        }
+    if (iprio >= nprio || (ithres && iprio >= ithres)) {
+        return 0;
     }
 
-    if (best_irq < aplic->num_irqs && best_iprio <= aplic->iprio_mask) {
-        return (best_irq << APLIC_IDC_TOPI_ID_SHIFT) | best_iprio;
-    }
+    irq = find_first_bit(aplic->idc_ready[idc * nprio + iprio],
+                         aplic->num_irqs);
 
-    return 0;
+    return (irq << APLIC_IDC_TOPI_ID_SHIFT) | iprio;
 }
 
 static void riscv_aplic_idc_update(RISCVAPLICState *aplic, uint32_t idc)
@@ -557,11 +592,7 @@ static void riscv_aplic_request(void *opaque, int irq, int level)
         break;
     }
 
-    if (level <= 0) {
-        aplic->state[irq] &= ~APLIC_ISTATE_INPUT;
-    } else {
-        aplic->state[irq] |= APLIC_ISTATE_INPUT;
-    }
+    riscv_aplic_set_state(aplic, irq, APLIC_ISTATE_INPUT, level > 0);
 
     if (update) {
         if (aplic->msimode) {
@@ -777,9 +808,19 @@ static void riscv_aplic_write(void *opaque, hwaddr addr, uint64_t value,
         if (aplic->msimode) {
             aplic->target[irq] = value;
         } else {
+            bool ready = (aplic->state[irq] & APLIC_ISTATE_ENPEND) ==
+                         APLIC_ISTATE_ENPEND;
+
+            /* Move the source to its new IDC and priority level */
+            if (ready) {
+                riscv_aplic_idc_ready(aplic, irq, false);
+            }
             aplic->target[irq] = (value & ~APLIC_TARGET_IPRIO_MASK) |
                                  ((value & aplic->iprio_mask) ?
                                   (value & aplic->iprio_mask) : 1);
+            if (ready) {
+                riscv_aplic_idc_ready(aplic, irq, true);
+            }
         }
     } else if (!aplic->msimode && (APLIC_IDC_BASE <= addr) &&
             (addr < (APLIC_IDC_BASE + aplic->num_harts * APLIC_IDC_SIZE))) {
@@ -851,6 +892,13 @@ static void riscv_aplic_realize(DeviceState *dev, Error **errp)
         aplic->idelivery = g_new0(uint32_t, aplic->num_harts);
         aplic->iforce = g_new0(uint32_t, aplic->num_harts);
         aplic->ithreshold = g_new0(uint32_t, aplic->num_harts);
+        if (!aplic->msimode) {
+            aplic->idc_ready = g_new0(unsigned long *, aplic->num_harts *
+                                      (aplic->iprio_mask + 1));
+            aplic->idc_ready_prio_longs = BITS_TO_LONGS(aplic->iprio_mask + 1);
+            aplic->idc_ready_prio = g_new0(unsigned long, aplic->num_harts *
+                                           aplic->idc_ready_prio_longs);
+        }
 
         memory_region_init_io(&aplic->mmio, OBJECT(dev), &riscv_aplic_ops,
                               aplic, TYPE_RISCV_APLIC, aplic->aperture_size);
@@ -900,10 +948,39 @@ static Property riscv_aplic_properties[] = {
     DEFINE_PROP_END_OF_LIST(),
 };
 
+static int riscv_aplic_post_load(void *opaque, int version_id)
+{
+    RISCVAPLICState *aplic = opaque;
+    uint32_t i, irq;
+
+    if (aplic->msimode) {
+        return 0;
+    }
+
+    /* Rebuild the per-IDC ready sets from the migrated source state */
+    for (i = 0; i < aplic->num_harts * (aplic->iprio_mask + 1); i++) {
+        if (aplic->idc_ready[i]) {
+            bitmap_zero(aplic->idc_ready[i], aplic->num_irqs);
+        }
+    }
+    bitmap_zero(aplic->idc_ready_prio,
+                aplic->num_harts * aplic->idc_ready_prio_longs *
+                BITS_PER_LONG);
+    for (irq = 1; irq < aplic->num_irqs; irq++) {
+        if ((aplic->state[irq] & APLIC_ISTATE_ENPEND) ==
+            APLIC_ISTATE_ENPEND) {
+            riscv_aplic_idc_ready(aplic, irq, true);
+        }
+    }
+
+    return 0;
+}
+
 static const VMStateDescription vmstate_riscv_aplic = {
     .name = "riscv_aplic",
     .version_id = 1,
     .minimum_version_id = 1,
+    .post_load = riscv_aplic_post_load,
     .fields = (const VMStateField[]) {
             VMSTATE_UINT32(domaincfg, RISCVAPLICState),
             VMSTATE_UINT32(mmsicfgaddr, RISCVAPLICState),
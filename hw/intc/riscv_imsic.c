@@ -22,6 +22,7 @@
 #include "qemu/module.h"
 #include "qemu/error-report.h"
 #include "qemu/bswap.h"
+#include "qemu/host-utils.h"
 #include "exec/address-spaces.h"
 #include "hw/sysbus.h"
 #include "hw/pci/msi.h"
@@ -43,30 +44,43 @@
 
 #define IMSIC_EISTATE_PENDING          (1U << 0)
 #define IMSIC_EISTATE_ENABLED          (1U << 1)
-#define IMSIC_EISTATE_ENPEND           (IMSIC_EISTATE_ENABLED | \
-                                        IMSIC_EISTATE_PENDING)
 
-static uint32_t riscv_imsic_topei(RISCVIMSICState *imsic, uint32_t page)
+#define IMSIC_EIX_WORDS(__imsic)       ((__imsic)->num_irqs / 32)
+
+/*
+ * Find the lowest (i.e. highest priority) identity that is both pending
+ * and enabled and below the threshold, or 0 if there is none.
+ */
+static uint32_t riscv_imsic_find_top(RISCVIMSICState *imsic, uint32_t page)
 {
-    uint32_t i, max_irq, base;
+    uint32_t w, bits, max_irq, base;
 
-    base = page * imsic->num_irqs;
+    base = page * IMSIC_EIX_WORDS(imsic);
     max_irq = (imsic->eithreshold[page] &&
                (imsic->eithreshold[page] <= imsic->num_irqs)) ?
                imsic->eithreshold[page] : imsic->num_irqs;
-    for (i = 1; i < max_irq; i++) {
-        if ((imsic->eistate[base + i] & IMSIC_EISTATE_ENPEND) ==
-                IMSIC_EISTATE_ENPEND) {
-            return (i << IMSIC_TOPEI_IID_SHIFT) | i;
+    for (w = 0; w * 32 < max_irq; w++) {
+        bits = imsic->eip[base + w] & imsic->eie[base + w];
+        if (bits) {
+            bits = w * 32 + ctz32(bits);
+            return bits < max_irq ? bits : 0;
         }
     }
 
     return 0;
 }
 
+static uint32_t riscv_imsic_topei(RISCVIMSICState *imsic, uint32_t page)
+{
+    uint32_t id = imsic->topid[page];
+
+    return id ? (id << IMSIC_TOPEI_IID_SHIFT) | id : 0;
+}
+
 static void riscv_imsic_update(RISCVIMSICState *imsic, uint32_t page)
 {
-    if (imsic->eidelivery[page] && riscv_imsic_topei(imsic, page)) {
+    imsic->topid[page] = riscv_imsic_find_top(imsic, page);
+    if (imsic->eidelivery[page] && imsic->topid[page]) {
         qemu_irq_raise(imsic->external_irqs[page]);
     } else {
         qemu_irq_lower(imsic->external_irqs[page]);
@@ -113,21 +127,17 @@ static int riscv_imsic_topei_rmw(RISCVIMSICState *imsic, uint32_t page,
                                  target_ulong *val, target_ulong new_val,
                                  target_ulong wr_mask)
 {
-    uint32_t base, topei = riscv_imsic_topei(imsic, page);
+    uint32_t topid = imsic->topid[page];
 
     /* Read pending and enabled interrupt with highest priority */
     if (val) {
-        *val = topei;
+        *val = riscv_imsic_topei(imsic, page);
     }
 
     /* Writes ignore value and clear top pending interrupt */
-    if (topei && wr_mask) {
-        topei >>= IMSIC_TOPEI_IID_SHIFT;
-        base = page * imsic->num_irqs;
-        if (topei) {
-            imsic->eistate[base + topei] &= ~IMSIC_EISTATE_PENDING;
-        }
-
+    if (topid && wr_mask) {
+        imsic->eip[page * IMSIC_EIX_WORDS(imsic) + topid / 32] &=
+            ~(1U << (topid % 32));
         riscv_imsic_update(imsic, page);
     }
 
@@ -139,9 +149,8 @@ static int riscv_imsic_eix_rmw(RISCVIMSICState *imsic,
                                uint32_t num, bool pend, target_ulong *val,
                                target_ulong new_val, target_ulong wr_mask)
 {
-    uint32_t i, base;
-    target_ulong mask;
-    uint32_t state = (pend) ? IMSIC_EISTATE_PENDING : IMSIC_EISTATE_ENABLED;
+    uint32_t *bits;
+    uint64_t old_val, wr_val;
 
     if (xlen != 32) {
         if (num & 0x1) {
@@ -153,30 +162,25 @@ static int riscv_imsic_eix_rmw(RISCVIMSICState *imsic,
         return -EINVAL;
     }
 
-    base = (page * imsic->num_irqs) + (num * xlen);
+    bits = (pend) ? imsic->eip : imsic->eie;
+    bits += (page * IMSIC_EIX_WORDS(imsic)) + (num * (xlen / 32));
 
+    old_val = bits[0];
+    if (xlen != 32) {
+        old_val |= (uint64_t)bits[1] << 32;
+    }
     if (val) {
-        *val = 0;
-        for (i = 0; i < xlen; i++) {
-            mask = (target_ulong)1 << i;
-            *val |= (imsic->eistate[base + i] & state) ? mask : 0;
-        }
+        *val = old_val;
     }
 
-    for (i = 0; i < xlen; i++) {
-        /* Bit0 of eip0 and eie0 are read-only zero */
-        if (!num && !i) {
-            continue;
-        }
-
-        mask = (target_ulong)1 << i;
-        if (wr_mask & mask) {
-            if (new_val & mask) {
-                imsic->eistate[base + i] |= state;
-            } else {
-                imsic->eistate[base + i] &= ~state;
-            }
-        }
+    /* Bit0 of eip0 and eie0 are read-only zero */
+    if (!num) {
+        wr_mask &= ~(target_ulong)1;
+    }
+    wr_val = (old_val & ~(uint64_t)wr_mask) | (new_val & wr_mask);
+    bits[0] = wr_val;
+    if (xlen != 32) {
+        bits[1] = wr_val >> 32;
     }
 
     riscv_imsic_update(imsic, page);
@@ -245,6 +249,23 @@ err:
     return -EINVAL;
 }
 
+/*
+ * An MSI can only change the output if it makes a new identity the top
+ * one; everything else is a single bit set.
+ */
+static void riscv_imsic_set_pending(RISCVIMSICState *imsic, uint32_t page,
+                                    uint32_t id)
+{
+    uint32_t w = page * IMSIC_EIX_WORDS(imsic) + id / 32;
+    uint32_t bit = 1U << (id % 32);
+    uint32_t topid = imsic->topid[page];
+
+    imsic->eip[w] |= bit;
+    if ((imsic->eie[w] & bit) && (!topid || id < topid)) {
+        riscv_imsic_update(imsic, page);
+    }
+}
+
 static uint64_t riscv_imsic_read(void *opaque, hwaddr addr, unsigned size)
 {
     RISCVIMSICState *imsic = opaque;
@@ -302,14 +323,10 @@ static void riscv_imsic_write(void *opaque, hwaddr addr, uint64_t value,
     page = addr >> IMSIC_MMIO_PAGE_SHIFT;
     if ((addr & (IMSIC_MMIO_PAGE_SZ - 1)) == IMSIC_MMIO_PAGE_LE) {
         if (value && (value < imsic->num_irqs)) {
-            imsic->eistate[(page * imsic->num_irqs) + value] |=
-                                                    IMSIC_EISTATE_PENDING;
+            riscv_imsic_set_pending(imsic, page, value);
         }
     }
 
-    /* Update CPU external interrupt status */
-    riscv_imsic_update(imsic, page);
-
     return;
 
 err:
@@ -340,6 +357,11 @@ static void riscv_imsic_realize(DeviceState *dev, Error **errp)
         imsic->eidelivery = g_new0(uint32_t, imsic->num_pages);
         imsic->eithreshold = g_new0(uint32_t, imsic->num_pages);
         imsic->eistate = g_new0(uint32_t, imsic->num_eistate);
+        imsic->eip = g_new0(uint32_t,
+                            imsic->num_pages * IMSIC_EIX_WORDS(imsic));
+        imsic->eie = g_new0(uint32_t,
+                            imsic->num_pages * IMSIC_EIX_WORDS(imsic));
+        imsic->topid = g_new0(uint32_t, imsic->num_pages);
     }
 
     memory_region_init_io(&imsic->mmio, OBJECT(dev), &riscv_imsic_ops,
@@ -382,10 +404,62 @@ static Property riscv_imsic_properties[] = {
     DEFINE_PROP_END_OF_LIST(),
 };
 
+static int riscv_imsic_pre_save(void *opaque)
+{
+    RISCVIMSICState *imsic = opaque;
+    uint32_t i, w, bit;
+
+    for (i = 0; imsic->eistate && i < imsic->num_eistate; i++) {
+        w = (i / imsic->num_irqs) * IMSIC_EIX_WORDS(imsic) +
+            (i % imsic->num_irqs) / 32;
+        bit = 1U << (i % 32);
+        imsic->eistate[i] =
+            ((imsic->eip[w] & bit) ? IMSIC_EISTATE_PENDING : 0) |
+            ((imsic->eie[w] & bit) ? IMSIC_EISTATE_ENABLED : 0);
+    }
+
+    return 0;
+}
+
+static int riscv_imsic_post_load(void *opaque, int version_id)
+{
+    RISCVIMSICState *imsic = opaque;
+    uint32_t i, w, bit, page;
+
+    if (!imsic->eistate) {
+        return 0;
+    }
+
+    for (i = 0; i < imsic->num_eistate; i++) {
+        w = (i / imsic->num_irqs) * IMSIC_EIX_WORDS(imsic) +
+            (i % imsic->num_irqs) / 32;
+        bit = 1U << (i % 32);
+        if (imsic->eistate[i] & IMSIC_EISTATE_PENDING) {
+            imsic->eip[w] |= bit;
+        } else {
+            imsic->eip[w] &= ~bit;
+        }
+        if (imsic->eistate[i] & IMSIC_EISTATE_ENABLED) {
+            imsic->eie[w] |= bit;
+        } else {
+            imsic->eie[w] &= ~bit;
+        }
+    }
+
+    /* The CPU's mip is migrated on its own; only refresh the cache. */
+    for (page = 0; page < imsic->num_pages; page++) {
+        imsic->topid[page] = riscv_imsic_find_top(imsic, page);
+    }
+
+    return 0;
+}
+
 static const VMStateDescription vmstate_riscv_imsic = {
     .name = "riscv_imsic",
     .version_id = 1,
     .minimum_version_id = 1,
+    .pre_save = riscv_imsic_pre_save,
+    .post_load = riscv_imsic_post_load,
     .fields = (const VMStateField[]) {
             VMSTATE_VARRAY_UINT32(eidelivery, RISCVIMSICState,
                                   num_pages, 0,
@@ -22,6 +22,7 @@
 #include "qemu/log.h"
 #include "qapi/error.h"
 #include "qemu/module.h"
+#include "qemu/main-loop.h"
 #include "hw/sysbus.h"
 #include "target/riscv/cpu.h"
 #include "hw/qdev-properties.h"
@@ -48,12 +49,13 @@ static void thead_clint_write_timecmp(THEADCLINTState *s, int hartid,
                                       uint64_t value)
 {
     uint64_t rtc = cpu_riscv_read_rtc(s);
-    uint64_t cmp = s->mtimecmp[hartid] = value;
+    uint64_t cmp = value;
     uint64_t diff = cmp - rtc;
     uint64_t next_ns = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) +
                                          muldiv64(diff, NANOSECONDS_PER_SECOND,
                                                   10000000);
 
+    qatomic_set_u64(&s->mtimecmp[hartid], cmp);
     qemu_set_irq(s->pirq[2 * hartid + 1], 0);
     if (cmp <= rtc) {
         /*
@@ -81,17 +83,19 @@ static uint64_t thead_clint_read(void *opaque, hwaddr addr, unsigned size)
 
     switch (addr) {
     case 0:
-        return clint->msip[0];
+        return qatomic_read(&clint->msip[0]);
     case 4:
-        return clint->msip[1];
+        return qatomic_read(&clint->msip[1]);
     case 0x4000:
     case 0x4008: { /* timecmp_lo */
-            uint64_t timecmp = clint->mtimecmp[(addr - 0x4000) >> 3];
+            uint64_t timecmp =
+                qatomic_read_u64(&clint->mtimecmp[(addr - 0x4000) >> 3]);
             return timecmp & 0xFFFFFFFF;
         }
     case 0x4004:
     case 0x400c: { /* timecmp_hi */
-            uint64_t timecmp = clint->mtimecmp[(addr - 0x4004) >> 3];
+            uint64_t timecmp =
+                qatomic_read_u64(&clint->mtimecmp[(addr - 0x4004) >> 3]);
             return (timecmp >> 32) & 0xFFFFFFFF;
         }
     case 0xbff8: /* time_lo */
@@ -113,6 +117,12 @@ static void thead_clint_write(void *opaque, hwaddr addr, uint64_t value,
 {
     THEADCLINTState *clint = opaque;
     int hartid;
+    /*
+     * Reads are served without the BQL, but the interrupt lines may be
+     * routed to any interrupt controller: keep writes under the BQL.
+     */
+    BQL_LOCK_GUARD();
+
     /* writes must be 4 byte aligned words */
     if ((addr & 0x3) != 0 || size != 4) {
         qemu_log_mask(LOG_GUEST_ERROR,
@@ -124,7 +134,7 @@ static void thead_clint_write(void *opaque, hwaddr addr, uint64_t value,
     case 4:
         hartid = addr / 4;
         qemu_irq_pulse(clint->pirq[hartid * 2]);
-        clint->msip[hartid] = 0x1;
+        qatomic_set(&clint->msip[hartid], 0x1);
         break;
 
     case 0x4000:
@@ -175,6 +185,7 @@ static void thead_clint_init(Object *obj)
 
     memory_region_init_io(&s->mmio, obj, &thead_clint_ops, s,
                           TYPE_THEAD_CLINT, 0x10000);
+    memory_region_enable_lockless_io(&s->mmio);
     sysbus_init_mmio(sbd, &s->mmio);
 }
 
@@ -0,0 +1,278 @@
+/*
+ * Base type for dynsoc device modules
+ *
+ * Devices loaded by the dynsoc board description derive from this type
+ * to get two things the plain sysbus device does not give them: MMIO
+ * dispatch outside the BQL when they declare themselves thread-safe,
+ * and a small per-device worker pool for operations that take too long
+ * to run on the vCPU thread, completed through the device's IRQ.
+ *
+ * Copyright (c) 2024 Alibaba Group. All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qemu/osdep.h"
+#include "qapi/error.h"
+#include "qemu/lockable.h"
+#include "qemu/main-loop.h"
+#include "qemu/module.h"
+#include "qemu/rcu.h"
+#include "hw/irq.h"
+#include "hw/qdev-properties.h"
+#include "hw/misc/dynsoc_device.h"
+
+#define DYNSOC_MAX_WORKERS  64
+
+struct DynSocJob {
+    DynSocWorkFunc *work;
+    DynSocDoneFunc *done;
+    void *opaque;
+    int ret;
+    QSIMPLEQ_ENTRY(DynSocJob) next;
+};
+
+DeviceState *dynsoc_device_create(const char *type, hwaddr addr,
+                                  uint32_t workers, qemu_irq irq)
+{
+    DeviceState *dev = qdev_new(type);
+
+    if (workers && object_dynamic_cast(OBJECT(dev), TYPE_DYNSOC_DEVICE)) {
+        qdev_prop_set_uint32(dev, "workers", workers);
+    }
+    sysbus_realize_and_unref(SYS_BUS_DEVICE(dev), &error_fatal);
+    sysbus_mmio_map(SYS_BUS_DEVICE(dev), 0, addr);
+    if (irq) {
+        sysbus_connect_irq(SYS_BUS_DEVICE(dev), 0, irq);
+    }
+    return dev;
+}
+
+void dynsoc_device_init_mmio(DynSocDevice *s, MemoryRegion *mr,
+                             const MemoryRegionOps *ops, void *opaque,
+                             const char *name, uint64_t size)
+{
+    memory_region_init_io(mr, OBJECT(s), ops, opaque, name, size);
+    if (DYNSOC_DEVICE_GET_CLASS(s)->thread_safe) {
+        memory_region_enable_lockless_io(mr);
+    }
+    sysbus_init_mmio(SYS_BUS_DEVICE(s), mr);
+}
+
+void dynsoc_device_set_irq(DynSocDevice *s, int level)
+{
+    BQL_LOCK_GUARD();
+    qemu_set_irq(s->irq, level);
+}
+
+static void dynsoc_device_complete(DynSocDevice *s, DynSocJob *job)
+{
+    if (!job->done || job->done(job->opaque, job->ret)) {
+        qemu_irq_raise(s->irq);
+    }
+    g_free(job);
+}
+
+/* Called with s->lock held */
+static void dynsoc_device_run_completed(DynSocDevice *s)
+{
+    DynSocJob *job;
+
+    while ((job = QSIMPLEQ_FIRST(&s->completed))) {
+        QSIMPLEQ_REMOVE_HEAD(&s->completed, next);
+        qemu_mutex_unlock(&s->lock);
+        dynsoc_device_complete(s, job);
+        qemu_mutex_lock(&s->lock);
+    }
+}
+
+static void dynsoc_device_bh(void *opaque)
+{
+    DynSocDevice *s = opaque;
+
+    qemu_mutex_lock(&s->lock);
+    dynsoc_device_run_completed(s);
+    qemu_mutex_unlock(&s->lock);
+}
+
+static void *dynsoc_device_worker(void *opaque)
+{
+    DynSocDevice *s = opaque;
+    DynSocJob *job;
+
+    rcu_register_thread();
+
+    qemu_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->stopping && QSIMPLEQ_EMPTY(&s->pending)) {
+            qemu_cond_wait(&s->cond, &s->lock);
+        }
+        if (s->stopping) {
+            break;
+        }
+
+        job = QSIMPLEQ_FIRST(&s->pending);
+        QSIMPLEQ_REMOVE_HEAD(&s->pending, next);
+        qemu_mutex_unlock(&s->lock);
+
+        job->ret = job->work(job->opaque);
+
+        qemu_mutex_lock(&s->lock);
+        QSIMPLEQ_INSERT_TAIL(&s->completed, job, next);
+        s->inflight--;
+        qemu_cond_broadcast(&s->cond);
+        qemu_bh_schedule(s->bh);
+    }
+    qemu_mutex_unlock(&s->lock);
+
+    rcu_unregister_thread();
+    return NULL;
+}
+
+void dynsoc_device_submit(DynSocDevice *s, DynSocWorkFunc *work,
+                          DynSocDoneFunc *done, void *opaque)
+{
+    DynSocJob *job = g_new0(DynSocJob, 1);
+
+    job->work = work;
+    job->done = done;
+    job->opaque = opaque;
+
+    QEMU_LOCK_GUARD(&s->lock);
+    QSIMPLEQ_INSERT_TAIL(&s->pending, job, next);
+    s->inflight++;
+    qemu_cond_signal(&s->cond);
+}
+
+void dynsoc_device_drain(DynSocDevice *s)
+{
+    assert(bql_locked());
+
+    qemu_mutex_lock(&s->lock);
+    while (s->inflight) {
+        qemu_cond_wait(&s->cond, &s->lock);
+    }
+    dynsoc_device_run_completed(s);
+    qemu_mutex_unlock(&s->lock);
+}
+
+static void dynsoc_device_realize(DeviceState *dev, Error **errp)
+{
+    DynSocDevice *s = DYNSOC_DEVICE(dev);
+    g_autofree char *name = NULL;
+    uint32_t i;
+
+    if (!s->nb_workers || s->nb_workers > DYNSOC_MAX_WORKERS) {
+        error_setg(errp, "workers must be between 1 and %d",
+                   DYNSOC_MAX_WORKERS);
+        return;
+    }
+
+    /*
+     * The re-entrancy guard is not used by lockless MMIO, and its flag
+     * may not be shared with accesses running outside the BQL.
+     */
+    if (DYNSOC_DEVICE_GET_CLASS(s)->thread_safe) {
+        s->bh = qemu_bh_new(dynsoc_device_bh, s);
+    } else {
+        s->bh = qemu_bh_new_guarded(dynsoc_device_bh, s,
+                                    &dev->mem_reentrancy_guard);
+    }
+    s->workers = g_new0(QemuThread, s->nb_workers);
+    for (i = 0; i < s->nb_workers; i++) {
+        g_free(name);
+        name = g_strdup_printf("dynsoc-%s/%u",
+                               object_get_typename(OBJECT(dev)), i);
+        qemu_thread_create(&s->workers[i], name, dynsoc_device_worker, s,
+                           QEMU_THREAD_JOINABLE);
+    }
+}
+
+static void dynsoc_device_unrealize(DeviceState *dev)
+{
+    DynSocDevice *s = DYNSOC_DEVICE(dev);
+    DynSocJob *job;
+    uint32_t i;
+
+    dynsoc_device_drain(s);
+
+    qemu_mutex_lock(&s->lock);
+    s->stopping = true;
+    qemu_cond_broadcast(&s->cond);
+    qemu_mutex_unlock(&s->lock);
+
+    for (i = 0; i < s->nb_workers; i++) {
+        qemu_thread_join(&s->workers[i]);
+    }
+    g_free(s->workers);
+    s->workers = NULL;
+
+    while ((job = QSIMPLEQ_FIRST(&s->pending))) {
+        QSIMPLEQ_REMOVE_HEAD(&s->pending, next);
+        g_free(job);
+    }
+    qemu_bh_delete(s->bh);
+    s->bh = NULL;
+}
+
+static void dynsoc_device_init(Object *obj)
+{
+    DynSocDevice *s = DYNSOC_DEVICE(obj);
+
+    qemu_mutex_init(&s->lock);
+    qemu_cond_init(&s->cond);
+    QSIMPLEQ_INIT(&s->pending);
+    QSIMPLEQ_INIT(&s->completed);
+    sysbus_init_irq(SYS_BUS_DEVICE(obj), &s->irq);
+}
+
+static void dynsoc_device_finalize(Object *obj)
+{
+    DynSocDevice *s = DYNSOC_DEVICE(obj);
+
+    qemu_cond_destroy(&s->cond);
+    qemu_mutex_destroy(&s->lock);
+}
+
+static Property dynsoc_device_properties[] = {
+    DEFINE_PROP_UINT32("workers", DynSocDevice, nb_workers, 1),
+    DEFINE_PROP_END_OF_LIST(),
+};
+
+static void dynsoc_device_class_init(ObjectClass *klass, void *data)
+{
+    DeviceClass *dc = DEVICE_CLASS(klass);
+
+    dc->realize = dynsoc_device_realize;
+    dc->unrealize = dynsoc_device_unrealize;
+    device_class_set_props(dc, dynsoc_device_properties);
+}
+
+static const TypeInfo dynsoc_device_info = {
+    .name          = TYPE_DYNSOC_DEVICE,
+    .parent        = TYPE_SYS_BUS_DEVICE,
+    .instance_size = sizeof(DynSocDevice),
+    .instance_init = dynsoc_device_init,
+    .instance_finalize = dynsoc_device_finalize,
+    .class_size    = sizeof(DynSocDeviceClass),
+    .class_init    = dynsoc_device_class_init,
+    .abstract      = true,
+};
+
+static void dynsoc_device_register_types(void)
+{
+    type_register_static(&dynsoc_device_info);
+}
+
+type_init(dynsoc_device_register_types)
@@ -21,14 +21,19 @@
 #include "qemu/datadir.h"
 #include "qemu/units.h"
 #include "qemu/error-report.h"
+#include "qemu/main-loop.h"
+#include "qapi/error.h"
 #include "exec/cpu-defs.h"
 #include "hw/boards.h"
 #include "hw/loader.h"
 #include "hw/riscv/boot.h"
 #include "hw/riscv/boot_opensbi.h"
 #include "elf.h"
+#include "migration/snapshot.h"
+#include "semihosting/semihost.h"
 #include "sysemu/device_tree.h"
 #include "sysemu/qtest.h"
+#include "sysemu/runstate.h"
 #include "sysemu/kvm.h"
 #include "sysemu/reset.h"
 
@@ -473,3 +478,73 @@ void riscv_setup_firmware_boot(MachineState *machine)
         }
     }
 }
+
+/*
+ * Boot checkpoints: the first run boots until the guest issues the
+ * SYS_QEMU_CHECKPOINT semihosting call and saves the machine to a file;
+ * later runs restore that file during the initial reset and resume
+ * right after the call.
+ */
+static char *boot_checkpoint_file;
+static bool boot_checkpoint_restore;
+static VMChangeStateEntry *boot_checkpoint_vmse;
+
+static void riscv_boot_checkpoint_save(void *opaque)
+{
+    Error *err = NULL;
+
+    if (!save_checkpoint(boot_checkpoint_file, &err)) {
+        error_reportf_err(err, "Cannot write boot checkpoint: ");
+    } else {
+        info_report("Boot checkpoint written to '%s'", boot_checkpoint_file);
+    }
+    vm_start();
+}
+
+static void riscv_boot_checkpoint_stopped(void *opaque, bool running,
+                                          RunState state)
+{
+    if (running || state != RUN_STATE_SAVE_VM) {
+        return;
+    }
+    /* All vCPUs are paused now; save from outside the state notifier. */
+    qemu_del_vm_change_state_handler(boot_checkpoint_vmse);
+    boot_checkpoint_vmse = NULL;
+    aio_bh_schedule_oneshot(qemu_get_aio_context(),
+                            riscv_boot_checkpoint_save, NULL);
+}
+
+static void riscv_boot_checkpoint_request(void *opaque)
+{
+    /*
+     * Called from the vCPU thread: stop it right after the semihosting
+     * call, so that the checkpoint resumes there, and save once the
+     * other vCPUs have stopped too. Only the first marker counts.
+     */
+    semihosting_set_checkpoint_handler(NULL, NULL);
+    boot_checkpoint_vmse =
+        qemu_add_vm_change_state_handler(riscv_boot_checkpoint_stopped, NULL);
+    vm_stop(RUN_STATE_SAVE_VM);
+}
+
+/*
+ * MachineClass::reset for boards supporting boot checkpoints. The
+ * checkpoint is loaded after all devices (and ROM blobs) have been
+ * reset, and before the vCPU clocks start ticking.
+ */
+void riscv_boot_checkpoint_reset(MachineState *machine, ShutdownCause reason)
+{
+    Error *err = NULL;
+
+    qemu_devices_reset(reason);
+
+    if (!boot_checkpoint_restore) {
+        return;
+    }
+    boot_checkpoint_restore = false;
+    if (!load_checkpoint(boot_checkpoint_file, &err)) {
+        error_reportf_err(err, "Cannot restore boot checkpoint '%s': ",
+                          boot_checkpoint_file);
+        exit(1);
+    }
+}
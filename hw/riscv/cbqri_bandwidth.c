@@ -24,6 +24,8 @@
 #include "qemu/error-report.h"
 #include "qemu/log.h"
 #include "qemu/module.h"
+#include "qemu/atomic.h"
+#include "hw/boards.h"
 #include "hw/qdev-properties.h"
 #include "hw/sysbus.h"
 #include "target/riscv/cpu.h"
@@ -116,6 +118,7 @@ FIELD(BC_BW_ALLOC, useShared, 31, 1);
 
 typedef struct MonitorCounter {
     uint64_t ctr_val;
+    uint64_t base;
     int at;
     int evt_id;
     bool active;
@@ -164,6 +167,13 @@ typedef struct RiscvCbqriBandwidthState {
     bool supports_mon_evt_id_rdwr_count;
     bool supports_mon_evt_id_rdonly_count;
     bool supports_mon_evt_id_wronly_count;
+
+    bool bandwidth_model;
+    uint32_t sample_period;
+
+    /* bandwidth model, see riscv_cbqri_bc_sample() */
+    uint64_t *model_bytes;
+    unsigned int model_cpus;
 } RiscvCbqriBandwidthState;
 
 #define RISCV_CBQRI_BC(obj) \
@@ -209,6 +219,68 @@ static uint32_t bandwidth_read(RiscvCbqriBandwidthState *bc,
     return BC_ALLOC_STATUS_SUCCESS;
 }
 
+/*
+ * Bandwidth model
+ *
+ * TCG feeds one in every sample_period data accesses of each hart, and
+ * each sample is accounted as that many accesses of its size to the
+ * hart's MCID. Byte counts are kept per hart, read and write apart, so
+ * that each has a single writer; counters sum them when read. The
+ * bandwidth limits themselves are not enforced.
+ */
+static void riscv_cbqri_bc_sample(void *opaque, CPURISCVState *env,
+                                  hwaddr paddr, unsigned size, bool is_store,
+                                  uint32_t weight)
+{
+    RiscvCbqriBandwidthState *bc = opaque;
+    unsigned int cpu = env_cpu(env)->cpu_index;
+    uint32_t mcid = get_field(env->sqoscfg, SQOSCFG_MCID);
+    uint64_t *bytes;
+
+    if (mcid >= bc->nb_mcids || cpu >= bc->model_cpus) {
+        return;
+    }
+
+    bytes = &bc->model_bytes[(cpu * bc->nb_mcids + mcid) * 2 + is_store];
+    qatomic_set_u64(bytes, qatomic_read_u64(bytes) + (uint64_t)size * weight);
+}
+
+static uint64_t riscv_cbqri_bc_bytes(RiscvCbqriBandwidthState *bc,
+                                     uint32_t mcid, uint32_t evt_id)
+{
+    uint64_t *bytes, total = 0;
+    unsigned int cpu;
+
+    for (cpu = 0; cpu < bc->model_cpus; cpu++) {
+        bytes = &bc->model_bytes[(cpu * bc->nb_mcids + mcid) * 2];
+        if (evt_id != BC_EVT_ID_WRONLY_count) {
+            total += qatomic_read_u64(&bytes[0]);
+        }
+        if (evt_id != BC_EVT_ID_RDONLY_count) {
+            total += qatomic_read_u64(&bytes[1]);
+        }
+    }
+    return total;
+}
+
+static uint64_t riscv_cbqri_bc_counter(RiscvCbqriBandwidthState *bc,
+                                       uint32_t mcid)
+{
+    MonitorCounter *counter = &bc->mon_counters[mcid];
+    uint64_t count, value = 0;
+
+    if (counter->at == BC_AT_CODE) {
+        /* only data accesses are sampled */
+        return 0;
+    }
+
+    count = riscv_cbqri_bc_bytes(bc, mcid, counter->evt_id) - counter->base;
+    value = FIELD_DP64(value, BC_MON_CTR_VAL, CTR, count);
+    value = FIELD_DP64(value, BC_MON_CTR_VAL, OVF,
+                       count > R_BC_MON_CTR_VAL_CTR_MASK);
+    return value;
+}
+
 static bool is_valid_at(RiscvCbqriBandwidthState *bc, uint32_t at)
 {
     switch (at) {
@@ -277,6 +349,10 @@ static void riscv_cbqri_bc_write_mon_ctl(RiscvCbqriBandwidthState *bc,
                 bc->mon_counters[mcid].evt_id = evt_id;
                 bc->mon_counters[mcid].at = atv ? at : -1;
                 bc->mon_counters[mcid].active = true;
+                if (bc->bandwidth_model) {
+                    bc->mon_counters[mcid].base =
+                        riscv_cbqri_bc_bytes(bc, mcid, evt_id);
+                }
                 status = BC_MON_CTL_STATUS_SUCCESS;
             }
         } else {
@@ -284,6 +360,9 @@ static void riscv_cbqri_bc_write_mon_ctl(RiscvCbqriBandwidthState *bc,
         }
     } else if (op == BC_MON_OP_READ_COUNTER &&
                bc->supports_mon_op_read_counter) {
+        if (bc->bandwidth_model && bc->mon_counters[mcid].active) {
+            bc->mon_counters[mcid].ctr_val = riscv_cbqri_bc_counter(bc, mcid);
+        }
         bc->bc_mon_ctr_val = bc->mon_counters[mcid].ctr_val;
         status = BC_MON_CTL_STATUS_SUCCESS;
     } else {
@@ -487,6 +566,20 @@ static void riscv_cbqri_bc_realize(DeviceState *dev, Error **errp)
     unsigned int bw_alloc_size = bw_alloc_end - bc->bw_allocations;
     bc->bw_allocations = g_new0(BandwidthAllocation, bw_alloc_size);
 
+    if (bc->bandwidth_model) {
+        if (bc->sample_period == 0 || bc->sample_period > INT32_MAX) {
+            error_setg(errp, "invalid sample-period %u", bc->sample_period);
+            return;
+        }
+
+        if (!riscv_cpu_add_mem_sampler(riscv_cbqri_bc_sample, bc,
+                                       bc->sample_period, errp)) {
+            return;
+        }
+        bc->model_cpus = current_machine->smp.max_cpus;
+        bc->model_bytes = g_new0(uint64_t, bc->model_cpus * bc->nb_mcids * 2);
+    }
+
     memory_region_init_io(&bc->mmio, OBJECT(dev), &riscv_cbqri_bc_ops,
                           bc, TYPE_RISCV_CBQRI_BC".mmio", 4 * 1024);
     sysbus_init_mmio(SYS_BUS_DEVICE(dev), &bc->mmio);
@@ -499,6 +592,14 @@ static void riscv_cbqri_bc_reset(DeviceState *dev)
 
     bc->bc_mon_ctl = 0;
     bc->bc_alloc_ctl = 0;
+
+    if (bc->bandwidth_model) {
+        memset(bc->model_bytes, 0,
+               bc->model_cpus * bc->nb_mcids * 2 * sizeof(*bc->model_bytes));
+        for (unsigned int mcid = 0; mcid < bc->nb_mcids; mcid++) {
+            bc->mon_counters[mcid].base = 0;
+        }
+    }
 }
 
 static Property riscv_cbqri_bc_properties[] = {
@@ -534,6 +635,11 @@ static Property riscv_cbqri_bc_properties[] = {
     DEFINE_PROP_BOOL("mon_evt_id_wronly_count", RiscvCbqriBandwidthState,
                      supports_mon_evt_id_wronly_count, true),
 
+    DEFINE_PROP_BOOL("bandwidth-model", RiscvCbqriBandwidthState,
+                     bandwidth_model, false),
+    DEFINE_PROP_UINT32("sample-period", RiscvCbqriBandwidthState,
+                       sample_period, 64),
+
     DEFINE_PROP_END_OF_LIST(),
 };
 
@@ -25,6 +25,8 @@
 #include "qemu/log.h"
 #include "qemu/module.h"
 #include "qemu/bitmap.h"
+#include "qemu/atomic.h"
+#include "hw/boards.h"
 #include "hw/qdev-properties.h"
 #include "hw/sysbus.h"
 #include "target/riscv/cpu.h"
@@ -106,6 +108,12 @@ enum {
 
 REG64(CC_BLOCK_MASK, 32);
 
+/* Occupancy model tag entries */
+#define CC_MODEL_LINE_BITS      6
+#define CC_MODEL_TAG_VALID      (1u << 31)
+#define CC_MODEL_TAG_SHIFT      12
+#define CC_MODEL_TAG_BITS       19
+#define CC_MODEL_MCID_MASK      0xfff
 
 typedef struct MonitorCounter {
     uint64_t ctr_val;
@@ -150,6 +158,16 @@ typedef struct RiscvCbqriCapacityState {
 
     bool supports_mon_evt_id_none;
     bool supports_mon_evt_id_occupancy;
+
+    bool occupancy_model;
+    uint32_t sample_period;
+    uint32_t model_sets;
+
+    /* occupancy model, see riscv_cbqri_cc_sample() */
+    uint32_t *model_tags;
+    int32_t *model_lines;
+    uint32_t *model_rand;
+    unsigned int model_cpus;
 } RiscvCbqriCapacityState;
 
 #define RISCV_CBQRI_CC(obj) \
@@ -222,6 +240,109 @@ static uint32_t alloc_blockmask_init(RiscvCbqriCapacityState *cc,
     return CC_ALLOC_STATUS_SUCCESS;
 }
 
+/*
+ * Occupancy model
+ *
+ * The controller's capacity is modelled as a cache of model_sets sets
+ * with one way per capacity block, indexed by physical address. TCG
+ * feeds it one in every sample_period data accesses of each hart; a
+ * miss allocates a way allowed by the data blockmask of the hart's
+ * RCID and tags it with its MCID. This is an approximation: sampled
+ * accesses stand in for all of them, and RCID flushes are not modelled.
+ *
+ * Samples from different harts race on the tag array, which is only
+ * ever updated with cmpxchg; a lost race just drops the sample. The
+ * per-MCID line counts are kept per hart so that each has a single
+ * writer, and summed when the guest reads a counter.
+ */
+static void riscv_cbqri_cc_sample(void *opaque, CPURISCVState *env,
+                                  hwaddr paddr, unsigned size, bool is_store,
+                                  uint32_t weight)
+{
+    RiscvCbqriCapacityState *cc = opaque;
+    unsigned int cpu = env_cpu(env)->cpu_index;
+    uint32_t rcid = get_field(env->sqoscfg, SQOSCFG_RCID);
+    uint32_t mcid = get_field(env->sqoscfg, SQOSCFG_MCID);
+    uint64_t line = paddr >> CC_MODEL_LINE_BITS;
+    uint32_t *ways, tag, old, victim, r;
+    int32_t *lines;
+    uint64_t allowed, invalid;
+    unsigned int i;
+
+    if (rcid >= cc->nb_rcids || mcid >= cc->nb_mcids ||
+        cpu >= cc->model_cpus) {
+        return;
+    }
+
+    ways = cc->model_tags + (line & (cc->model_sets - 1)) * cc->ncblks;
+    tag = (line >> ctz32(cc->model_sets)) * 0x9e3779b97f4a7c15ULL >>
+          (64 - CC_MODEL_TAG_BITS);
+    tag = CC_MODEL_TAG_VALID | (tag << CC_MODEL_TAG_SHIFT);
+
+    /* Lookups hit in any way, whoever allocated it */
+    invalid = 0;
+    for (i = 0; i < cc->ncblks; i++) {
+        old = qatomic_read(&ways[i]);
+        if ((old & ~CC_MODEL_MCID_MASK) == tag) {
+            return;
+        }
+        if (!(old & CC_MODEL_TAG_VALID)) {
+            invalid |= 1ULL << i;
+        }
+    }
+
+    allowed = qatomic_read_u64(get_blockmask_location(cc, rcid, CC_AT_DATA));
+    allowed &= MAKE_64BIT_MASK(0, cc->ncblks);
+    if (!allowed) {
+        return;
+    }
+
+    if (allowed & invalid) {
+        victim = ctz64(allowed & invalid);
+    } else {
+        /* xorshift32, one generator per hart */
+        r = cc->model_rand[cpu];
+        r ^= r << 13;
+        r ^= r >> 17;
+        r ^= r << 5;
+        cc->model_rand[cpu] = r;
+        for (i = r % ctpop64(allowed); i; i--) {
+            allowed &= allowed - 1;
+        }
+        victim = ctz64(allowed);
+    }
+
+    old = qatomic_read(&ways[victim]);
+    if (qatomic_cmpxchg(&ways[victim], old, tag | mcid) != old) {
+        return;
+    }
+
+    lines = cc->model_lines + cpu * cc->nb_mcids;
+    if (old & CC_MODEL_TAG_VALID) {
+        i = old & CC_MODEL_MCID_MASK;
+        qatomic_set(&lines[i], qatomic_read(&lines[i]) - 1);
+    }
+    qatomic_set(&lines[mcid], qatomic_read(&lines[mcid]) + 1);
+}
+
+/* Occupancy of @mcid, in capacity blocks */
+static uint64_t riscv_cbqri_cc_occupancy(RiscvCbqriCapacityState *cc,
+                                         uint32_t mcid)
+{
+    int64_t lines = 0;
+    unsigned int cpu;
+
+    if (cc->mon_counters[mcid].at == CC_AT_CODE) {
+        /* only data accesses are sampled */
+        return 0;
+    }
+
+    for (cpu = 0; cpu < cc->model_cpus; cpu++) {
+        lines += qatomic_read(&cc->model_lines[cpu * cc->nb_mcids + mcid]);
+    }
+    return MAX(lines, 0) / cc->model_sets;
+}
+
 static bool is_valid_at(RiscvCbqriCapacityState *cc, uint32_t at)
 {
     switch (at) {
@@ -293,6 +414,11 @@ static void riscv_cbqri_cc_write_mon_ctl(RiscvCbqriCapacityState *cc,
         }
     } else if (op == CC_MON_OP_READ_COUNTER &&
                cc->supports_mon_op_read_counter) {
+        if (cc->occupancy_model && cc->mon_counters[mcid].active) {
+            cc->mon_counters[mcid].ctr_val =
+                FIELD_DP64(0, CC_MON_CTR_VAL, CTR,
+                           riscv_cbqri_cc_occupancy(cc, mcid));
+        }
         cc->cc_mon_ctr_val = cc->mon_counters[mcid].ctr_val;
         status = CC_MON_CTL_STATUS_SUCCESS;
     } else {
@@ -487,6 +613,35 @@ static void riscv_cbqri_cc_realize(DeviceState *dev, Error **errp)
     unsigned int blockmasks_size = end - cc->alloc_blockmasks;
     cc->alloc_blockmasks = g_new0(uint64_t, blockmasks_size);
 
+    if (cc->occupancy_model) {
+        if (cc->ncblks == 0 || cc->ncblks > 64) {
+            error_setg(errp, "occupancy-model needs 1 to 64 capacity blocks");
+            return;
+        }
+        if (cc->nb_mcids > CC_MODEL_MCID_MASK + 1) {
+            error_setg(errp, "occupancy-model supports at most %d MCIDs",
+                       CC_MODEL_MCID_MASK + 1);
+            return;
+        }
+        if (!is_power_of_2(cc->model_sets)) {
+            error_setg(errp, "model-sets must be a power of 2");
+            return;
+        }
+        if (cc->sample_period == 0 || cc->sample_period > INT32_MAX) {
+            error_setg(errp, "invalid sample-period %u", cc->sample_period);
+            return;
+        }
+
+        if (!riscv_cpu_add_mem_sampler(riscv_cbqri_cc_sample, cc,
+                                       cc->sample_period, errp)) {
+            return;
+        }
+        cc->model_cpus = current_machine->smp.max_cpus;
+        cc->model_tags = g_new0(uint32_t, cc->model_sets * cc->ncblks);
+        cc->model_lines = g_new0(int32_t, cc->model_cpus * cc->nb_mcids);
+        cc->model_rand = g_new0(uint32_t, cc->model_cpus);
+    }
+
     memory_region_init_io(&cc->mmio, OBJECT(dev), &riscv_cbqri_cc_ops,
                           cc, TYPE_RISCV_CBQRI_CC".mmio", 4 * 1024);
     sysbus_init_mmio(SYS_BUS_DEVICE(dev), &cc->mmio);
@@ -519,6 +674,16 @@ static void riscv_cbqri_cc_reset(DeviceState *dev)
                                  rcid == 0, NULL);
         }
     }
+
+    if (cc->occupancy_model) {
+        memset(cc->model_tags, 0,
+               cc->model_sets * cc->ncblks * sizeof(*cc->model_tags));
+        memset(cc->model_lines, 0,
+               cc->model_cpus * cc->nb_mcids * sizeof(*cc->model_lines));
+        for (unsigned int cpu = 0; cpu < cc->model_cpus; cpu++) {
+            cc->model_rand[cpu] = cpu + 1;
+        }
+    }
 }
 
 static Property riscv_cbqri_cc_properties[] = {
@@ -551,6 +716,13 @@ static Property riscv_cbqri_cc_properties[] = {
     DEFINE_PROP_BOOL("mon_evt_id_occupancy", RiscvCbqriCapacityState,
                      supports_mon_evt_id_occupancy, true),
 
+    DEFINE_PROP_BOOL("occupancy-model", RiscvCbqriCapacityState,
+                     occupancy_model, false),
+    DEFINE_PROP_UINT32("sample-period", RiscvCbqriCapacityState,
+                       sample_period, 64),
+    DEFINE_PROP_UINT32("model-sets", RiscvCbqriCapacityState,
+                       model_sets, 1024),
+
     DEFINE_PROP_END_OF_LIST(),
 };
 
@@ -36,6 +36,7 @@
 #include "hw/timer/csky_coret.h"
 #include "hw/timer/csky_timer.h"
 #include "hw/csky/dynsoc.h"
+#include "hw/misc/dynsoc_device.h"
 #include "elf.h"
 #include "hw/intc/riscv_aclint.h"
 #include "hw/intc/sifive_plic.h"
@@ -258,9 +259,19 @@ static void dummyh_init(MachineState *machine)
             /* todo */
             break;
         case DYNSOC_USB:
-        case DYNSOC_CUSTOM:
             /* todo */
             break;
+        case DYNSOC_CUSTOM: {
+            qemu_irq irq = NULL;
+
+            if (b_info->dev[i].irq != 0xdeadbeef) {
+                irq = plic_irqs[b_info->dev[i].irq] ?:
+                      clic_irqs[b_info->dev[i].irq];
+            }
+            dynsoc_device_create(b_info->dev[i].name, b_info->dev[i].addr,
+                                 b_info->dev[i].workers, irq);
+            break;
+        }
         default:
             fprintf(stderr, "not support device type\n");
             exit(1);
@@ -102,7 +102,7 @@ void dynsoc_load_modules(int shmkey)
 
     module_load("hw-csky-", b_info->name, false);
 
-    for (i = 0; i < 10; i++) {
+    for (i = 0; i < ARRAY_SIZE(b_info->dev); i++) {
         if (b_info->dev[i].name[0] != 0) {
             module_load("", b_info->dev[i].filename, false);
         }
@@ -23,7 +23,12 @@
 #include "hw/boards.h"
 #include "hw/qdev-properties.h"
 #include "hw/riscv/numa.h"
+#include "hw/core/cpu.h"
+#include "qemu/bitmap.h"
+#include "qemu/cutils.h"
 #include "sysemu/device_tree.h"
+#include "sysemu/hostmem.h"
+#include "sysemu/tcg.h"
 
 static bool numa_enabled(const MachineState *ms)
 {
@@ -193,6 +198,101 @@ void riscv_socket_fdt_write_distance_matrix(const MachineState *ms)
     }
 }
 
+#ifdef CONFIG_LINUX
+/*
+ * Add the host CPUs of host NUMA node @node, as listed in sysfs
+ * (e.g. "0-15,32-47"), to @host_cpus.
+ */
+static bool riscv_numa_host_node_cpus(int node, unsigned long *host_cpus,
+                                      int nbits)
+{
+    g_autofree char *path = NULL;
+    g_autofree char *list = NULL;
+    const char *p;
+    unsigned long first, last;
+
+    path = g_strdup_printf("/sys/devices/system/node/node%d/cpulist", node);
+    if (!g_file_get_contents(path, &list, NULL, NULL)) {
+        return false;
+    }
+
+    for (p = list; *p && *p != '\n'; p++) {
+        if (qemu_strtoul(p, &p, 10, &first)) {
+            return false;
+        }
+        last = first;
+        if (*p == '-' && qemu_strtoul(p + 1, &p, 10, &last)) {
+            return false;
+        }
+        for (; first <= last && first < nbits; first++) {
+            set_bit(first, host_cpus);
+        }
+        if (*p != ',') {
+            break;
+        }
+    }
+
+    return true;
+}
+#endif
+
+void riscv_socket_bind_host_nodes(const MachineState *ms)
+{
+#ifdef CONFIG_LINUX
+    int nbits = MAX(sysconf(_SC_NPROCESSORS_CONF), 1);
+    HostMemoryBackend *backend;
+    unsigned long *host_cpus;
+    CPUState *cpu;
+    int socket, node, ret;
+
+    if (!numa_enabled(ms)) {
+        return;
+    }
+    if (tcg_enabled() && !qemu_tcg_mttcg_enabled()) {
+        warn_report("NUMA host affinity needs one thread per vCPU, "
+                    "ignoring it");
+        return;
+    }
+
+    host_cpus = bitmap_new(nbits);
+    for (socket = 0; socket < ms->numa_state->num_nodes; socket++) {
+        backend = ms->numa_state->nodes[socket].node_memdev;
+        if (!backend || backend->policy != HOST_MEM_POLICY_BIND) {
+            warn_report("NUMA node %d memory is not bound to host nodes, "
+                        "leaving its vCPUs unpinned", socket);
+            continue;
+        }
+
+        bitmap_zero(host_cpus, nbits);
+        for (node = find_first_bit(backend->host_nodes, MAX_NODES);
+             node < MAX_NODES;
+             node = find_next_bit(backend->host_nodes, MAX_NODES, node + 1)) {
+            if (!riscv_numa_host_node_cpus(node, host_cpus, nbits)) {
+                warn_report("Cannot read the CPUs of host NUMA node %d", node);
+            }
+        }
+        if (bitmap_empty(host_cpus, nbits)) {
+            continue;
+        }
+
+        CPU_FOREACH(cpu) {
+            if (ms->possible_cpus->cpus[cpu->cpu_index].props.node_id !=
+                socket || !cpu->thread) {
+                continue;
+            }
+            ret = qemu_thread_set_affinity(cpu->thread, host_cpus, nbits);
+            if (ret) {
+                warn_report("Setting the affinity of vCPU %d failed: %s",
+                            cpu->cpu_index, strerror(ret));
+            }
+        }
+    }
+    g_free(host_cpus);
+#else
+    warn_report("NUMA host affinity is not supported on this host");
+#endif
+}
+
 CpuInstanceProperties
 riscv_numa_cpu_index_to_props(MachineState *ms, unsigned cpu_index)
 {
@@ -76,8 +76,16 @@ struct RISCVIOMMUEntry {
     uint64_t gscid:16;          /* Guest Soft-Context identifier */
     uint64_t perm:2;            /* IOMMU_RW flags */
     uint64_t __rfu:2;
+    QLIST_ENTRY(RISCVIOMMUEntry) ctx_list;  /* RISCVIOMMUIotCtx entries */
+    QTAILQ_ENTRY(RISCVIOMMUEntry) lru;      /* RISCVIOMMUState iot_lru */
 };
 
+/* Address translation cache entries sharing one GSCID/PSCID pair */
+typedef struct RISCVIOMMUIotCtx {
+    uint64_t id;                /* GSCID << 20 | PSCID */
+    QLIST_HEAD(, RISCVIOMMUEntry) entries;
+} RISCVIOMMUIotCtx;
+
 /* IOMMU index for transactions without PASID specified. */
 #define RISCV_IOMMU_NOPASID 0
 
@@ -1111,111 +1119,207 @@ static guint __iot_hash(gconstpointer v)
     return (guint)t->iova;
 }
 
-/* GV: 1 PSCV: 1 AV: 1 */
-static void __iot_inval_pscid_iova(gpointer key, gpointer value, gpointer data)
+#define IOT_CTX_ID(gscid, pscid)    (((uint64_t)(gscid) << 20) | (pscid))
+
+/*
+ * The IOT cache is protected by iot_lock.  Entries are linked into the
+ * iot_cache hash table (owner), the per GSCID/PSCID index and the LRU list.
+ */
+static void riscv_iommu_iot_remove(RISCVIOMMUState *s, RISCVIOMMUEntry *iot)
 {
-    RISCVIOMMUEntry *iot = (RISCVIOMMUEntry *) value;
-    RISCVIOMMUEntry *arg = (RISCVIOMMUEntry *) data;
-    if (iot->gscid == arg->gscid &&
-        iot->pscid == arg->pscid &&
-        iot->iova == arg->iova) {
-        iot->perm = IOMMU_NONE;
+    QLIST_REMOVE(iot, ctx_list);
+    QTAILQ_REMOVE(&s->iot_lru, iot, lru);
+    g_hash_table_remove(s->iot_cache, iot);
+}
+
+static void riscv_iommu_iot_remove_ctx(RISCVIOMMUState *s,
+    RISCVIOMMUIotCtx *grp)
+{
+    RISCVIOMMUEntry *iot, *next;
+
+    QLIST_FOREACH_SAFE(iot, &grp->entries, ctx_list, next) {
+        riscv_iommu_iot_remove(s, iot);
+        s->iot_invals++;
     }
 }
 
-/* GV: 1 PSCV: 1 AV: 0 */
-static void __iot_inval_pscid(gpointer key, gpointer value, gpointer data)
+struct iot_inval_gscid_arg {
+    RISCVIOMMUState *s;
+    uint32_t gscid;
+};
+
+static gboolean __iot_ctx_remove_gscid(gpointer key, gpointer value,
+                                       gpointer data)
 {
-    RISCVIOMMUEntry *iot = (RISCVIOMMUEntry *) value;
-    RISCVIOMMUEntry *arg = (RISCVIOMMUEntry *) data;
-    if (iot->gscid == arg->gscid &&
-        iot->pscid == arg->pscid) {
-        iot->perm = IOMMU_NONE;
+    RISCVIOMMUIotCtx *grp = (RISCVIOMMUIotCtx *) value;
+    struct iot_inval_gscid_arg *arg = data;
+
+    if ((grp->id >> 20) != arg->gscid) {
+        return FALSE;
     }
+    riscv_iommu_iot_remove_ctx(arg->s, grp);
+    return TRUE;
 }
 
-/* GV: 1 GVMA: 1 */
-static void __iot_inval_gscid_gpa(gpointer key, gpointer value, gpointer data)
+typedef void RISCVIOMMUIotInvalFunc(RISCVIOMMUState *s, RISCVIOMMUEntry *arg);
+
+/* GV: 1 PSCV: 1 AV: 1 */
+static void __iot_inval_pscid_iova(RISCVIOMMUState *s, RISCVIOMMUEntry *arg)
 {
-    RISCVIOMMUEntry *iot = (RISCVIOMMUEntry *) value;
-    RISCVIOMMUEntry *arg = (RISCVIOMMUEntry *) data;
-    if (iot->gscid == arg->gscid) {
-        /* simplified cache, no GPA matching */
-        iot->perm = IOMMU_NONE;
+    RISCVIOMMUEntry *iot = g_hash_table_lookup(s->iot_cache, arg);
+    RISCVIOMMUIotCtx *grp;
+    uint64_t id;
+
+    if (iot) {
+        riscv_iommu_iot_remove(s, iot);
+        s->iot_invals++;
+        id = IOT_CTX_ID(arg->gscid, arg->pscid);
+        grp = g_hash_table_lookup(s->iot_ctx, &id);
+        if (grp && QLIST_EMPTY(&grp->entries)) {
+            g_hash_table_remove(s->iot_ctx, &id);
+        }
     }
 }
 
-/* GV: 1 GVMA: 0 */
-static void __iot_inval_gscid(gpointer key, gpointer value, gpointer data)
+/* GV: 1 PSCV: 1 AV: 0 */
+static void __iot_inval_pscid(RISCVIOMMUState *s, RISCVIOMMUEntry *arg)
 {
-    RISCVIOMMUEntry *iot = (RISCVIOMMUEntry *) value;
-    RISCVIOMMUEntry *arg = (RISCVIOMMUEntry *) data;
-    if (iot->gscid == arg->gscid) {
-        iot->perm = IOMMU_NONE;
+    uint64_t id = IOT_CTX_ID(arg->gscid, arg->pscid);
+    RISCVIOMMUIotCtx *grp = g_hash_table_lookup(s->iot_ctx, &id);
+
+    if (grp) {
+        riscv_iommu_iot_remove_ctx(s, grp);
+        g_hash_table_remove(s->iot_ctx, &id);
     }
 }
 
+/* GV: 1 GVMA: 0 */
+static void __iot_inval_gscid(RISCVIOMMUState *s, RISCVIOMMUEntry *arg)
+{
+    struct iot_inval_gscid_arg data = { .s = s, .gscid = arg->gscid };
+
+    g_hash_table_foreach_remove(s->iot_ctx, __iot_ctx_remove_gscid, &data);
+}
+
+/* GV: 1 GVMA: 1 */
+static void __iot_inval_gscid_gpa(RISCVIOMMUState *s, RISCVIOMMUEntry *arg)
+{
+    /* simplified cache, no GPA matching */
+    __iot_inval_gscid(s, arg);
+}
+
 /* GV: 0 */
-static void __iot_inval_all(gpointer key, gpointer value, gpointer data)
+static void __iot_inval_all(RISCVIOMMUState *s, RISCVIOMMUEntry *arg)
 {
-    RISCVIOMMUEntry *iot = (RISCVIOMMUEntry *) value;
-    iot->perm = IOMMU_NONE;
+    s->iot_invals += g_hash_table_size(s->iot_cache);
+    g_hash_table_remove_all(s->iot_ctx);
+    QTAILQ_INIT(&s->iot_lru);
+    g_hash_table_remove_all(s->iot_cache);
 }
 
-/* caller should keep ref-count for iot_cache object */
-static RISCVIOMMUEntry *riscv_iommu_iot_lookup(RISCVIOMMUContext *ctx,
-    GHashTable *iot_cache, hwaddr iova)
+/*
+ * Look up a cached translation and, on a hit, copy it to @out and mark the
+ * entry most recently used.
+ */
+static bool riscv_iommu_iot_lookup(RISCVIOMMUState *s, RISCVIOMMUContext *ctx,
+    hwaddr iova, RISCVIOMMUEntry *out)
 {
+    RISCVIOMMUEntry *iot;
     RISCVIOMMUEntry key = {
         .gscid = get_field(ctx->gatp, RISCV_IOMMU_DC_IOHGATP_GSCID),
         .pscid = get_field(ctx->ta, RISCV_IOMMU_DC_TA_PSCID),
         .iova  = PPN_DOWN(iova),
     };
-    return g_hash_table_lookup(iot_cache, &key);
+
+    qemu_mutex_lock(&s->iot_lock);
+    iot = g_hash_table_lookup(s->iot_cache, &key);
+    if (iot) {
+        QTAILQ_REMOVE(&s->iot_lru, iot, lru);
+        QTAILQ_INSERT_TAIL(&s->iot_lru, iot, lru);
+        out->phys = iot->phys;
+        out->perm = iot->perm;
+        s->iot_hits++;
+    } else {
+        s->iot_misses++;
+    }
+    qemu_mutex_unlock(&s->iot_lock);
+
+    return iot != NULL;
 }
 
-/* caller should keep ref-count for iot_cache object */
-static void riscv_iommu_iot_update(RISCVIOMMUState *s,
-    GHashTable *iot_cache, RISCVIOMMUEntry *iot)
+static void riscv_iommu_iot_update(RISCVIOMMUState *s, RISCVIOMMUEntry *data)
 {
+    RISCVIOMMUEntry *iot;
+    RISCVIOMMUIotCtx *grp;
+    uint64_t id;
+
     if (!s->iot_limit) {
         return;
     }
 
+    qemu_mutex_lock(&s->iot_lock);
+
+    /* Raced with another translation of the same page, refresh it. */
+    iot = g_hash_table_lookup(s->iot_cache, data);
+    if (iot) {
+        iot->phys = data->phys;
+        iot->perm = data->perm;
+        qemu_mutex_unlock(&s->iot_lock);
+        return;
+    }
+
+    /* Evict the least recently used entry, if the cache is full. */
     if (g_hash_table_size(s->iot_cache) >= s->iot_limit) {
-        iot_cache = g_hash_table_new_full(__iot_hash, __iot_equal,
-                                          g_free, NULL);
-        g_hash_table_unref(qatomic_xchg(&s->iot_cache, iot_cache));
+        iot = QTAILQ_FIRST(&s->iot_lru);
+        id = IOT_CTX_ID(iot->gscid, iot->pscid);
+        riscv_iommu_iot_remove(s, iot);
+        grp = g_hash_table_lookup(s->iot_ctx, &id);
+        if (grp && QLIST_EMPTY(&grp->entries)) {
+            g_hash_table_remove(s->iot_ctx, &id);
+        }
     }
-    g_hash_table_add(iot_cache, iot);
+
+    id = IOT_CTX_ID(data->gscid, data->pscid);
+    grp = g_hash_table_lookup(s->iot_ctx, &id);
+    if (!grp) {
+        grp = g_new0(RISCVIOMMUIotCtx, 1);
+        grp->id = id;
+        QLIST_INIT(&grp->entries);
+        g_hash_table_insert(s->iot_ctx, &grp->id, grp);
+    }
+
+    iot = g_memdup2(data, sizeof(*data));
+    QLIST_INSERT_HEAD(&grp->entries, iot, ctx_list);
+    QTAILQ_INSERT_TAIL(&s->iot_lru, iot, lru);
+    g_hash_table_add(s->iot_cache, iot);
+
+    qemu_mutex_unlock(&s->iot_lock);
 }
 
-static void riscv_iommu_iot_inval(RISCVIOMMUState *s, GHFunc func,
-    uint32_t gscid, uint32_t pscid, hwaddr iova)
+static void riscv_iommu_iot_inval(RISCVIOMMUState *s,
+    RISCVIOMMUIotInvalFunc *func, uint32_t gscid, uint32_t pscid, hwaddr iova)
 {
-    GHashTable *iot_cache;
     RISCVIOMMUEntry key = {
         .gscid = gscid,
         .pscid = pscid,
         .iova  = PPN_DOWN(iova),
     };
 
-    iot_cache = g_hash_table_ref(s->iot_cache);
-    g_hash_table_foreach(iot_cache, func, &key);
-    g_hash_table_unref(iot_cache);
+    qemu_mutex_lock(&s->iot_lock);
+    func(s, &key);
+    trace_riscv_iommu_iot_inval(s->parent_obj.id, gscid, pscid, iova,
+                                s->iot_hits, s->iot_misses, s->iot_invals);
+    qemu_mutex_unlock(&s->iot_lock);
 }
 
 static int riscv_iommu_translate(RISCVIOMMUState *s, RISCVIOMMUContext *ctx,
     IOMMUTLBEntry *iotlb, bool enable_cache)
 {
-    RISCVIOMMUEntry *iot;
-    IOMMUAccessFlags perm;
+    RISCVIOMMUEntry iot = { 0 };
     bool enable_pasid;
     bool enable_pri;
-    GHashTable *iot_cache;
     int fault;
 
-    iot_cache = g_hash_table_ref(s->iot_cache);
     /*
      * TC[32] is reserved for custom extensions, used here to temporarily
      * enable automatic page-request generation for ATS queries.
@@ -1233,12 +1337,11 @@ static int riscv_iommu_translate(RISCVIOMMUState *s, RISCVIOMMUContext *ctx,
         }
     }
 
-    iot = riscv_iommu_iot_lookup(ctx, iot_cache, iotlb->iova);
-    perm = iot ? iot->perm : IOMMU_NONE;
-    if (perm != IOMMU_NONE) {
-        iotlb->translated_addr = PPN_PHYS(iot->phys);
+    if (riscv_iommu_iot_lookup(s, ctx, iotlb->iova, &iot) &&
+        iot.perm != IOMMU_NONE) {
+        iotlb->translated_addr = PPN_PHYS(iot.phys);
         iotlb->addr_mask = ~TARGET_PAGE_MASK;
-        iotlb->perm = perm;
+        iotlb->perm = iot.perm;
         fault = 0;
         goto done;
     }
@@ -1252,18 +1355,15 @@ static int riscv_iommu_translate(RISCVIOMMUState *s, RISCVIOMMUContext *ctx,
     }
 
     if (!fault && iotlb->translated_addr != iotlb->iova && enable_cache) {
-        iot = g_new0(RISCVIOMMUEntry, 1);
-        iot->iova = PPN_DOWN(iotlb->iova);
-        iot->phys = PPN_DOWN(iotlb->translated_addr);
-        iot->gscid = get_field(ctx->gatp, RISCV_IOMMU_DC_IOHGATP_GSCID);
-        iot->pscid = get_field(ctx->ta, RISCV_IOMMU_DC_TA_PSCID);
-        iot->perm = iotlb->perm;
-        riscv_iommu_iot_update(s, iot_cache, iot);
+        iot.iova = PPN_DOWN(iotlb->iova);
+        iot.phys = PPN_DOWN(iotlb->translated_addr);
+        iot.gscid = get_field(ctx->gatp, RISCV_IOMMU_DC_IOHGATP_GSCID);
+        iot.pscid = get_field(ctx->ta, RISCV_IOMMU_DC_TA_PSCID);
+        iot.perm = iotlb->perm;
+        riscv_iommu_iot_update(s, &iot);
     }
 
 done:
-    g_hash_table_unref(iot_cache);
-
     if (enable_pri && fault) {
         struct riscv_iommu_pq_record pr = {0};
         if (enable_pasid) {
@@ -1429,6 +1529,7 @@ static void riscv_iommu_process_cq_tail(RISCVIOMMUState *s)
     uint32_t tail, head, ctrl;
     uint64_t cmd_opcode;
     GHFunc func;
+    RISCVIOMMUIotInvalFunc *iot_func;
 
     ctrl = riscv_iommu_reg_get32(s, RISCV_IOMMU_REG_CQCSR);
     tail = riscv_iommu_reg_get32(s, RISCV_IOMMU_REG_CQT) & s->cq_mask;
@@ -1477,15 +1578,15 @@ static void riscv_iommu_process_cq_tail(RISCVIOMMUState *s)
                 goto cmd_ill;
             } else if (!(cmd.dword0 & RISCV_IOMMU_CMD_IOTINVAL_GV)) {
                 /* invalidate all cache mappings */
-                func = __iot_inval_all;
+                iot_func = __iot_inval_all;
             } else if (!(cmd.dword0 & RISCV_IOMMU_CMD_IOTINVAL_AV)) {
                 /* invalidate cache matching GSCID */
-                func = __iot_inval_gscid;
+                iot_func = __iot_inval_gscid;
             } else {
                 /* invalidate cache matching GSCID and ADDR (GPA) */
-                func = __iot_inval_gscid_gpa;
+                iot_func = __iot_inval_gscid_gpa;
             }
-            riscv_iommu_iot_inval(s, func,
+            riscv_iommu_iot_inval(s, iot_func,
                 get_field(cmd.dword0, RISCV_IOMMU_CMD_IOTINVAL_GSCID), 0,
                 cmd.dword1 & TARGET_PAGE_MASK);
             break;
@@ -1494,18 +1595,18 @@ static void riscv_iommu_process_cq_tail(RISCVIOMMUState *s)
                              RISCV_IOMMU_CMD_IOTINVAL_OPCODE):
             if (!(cmd.dword0 & RISCV_IOMMU_CMD_IOTINVAL_GV)) {
                 /* invalidate all cache mappings, simplified model */
-                func = __iot_inval_all;
+                iot_func = __iot_inval_all;
             } else if (!(cmd.dword0 & RISCV_IOMMU_CMD_IOTINVAL_PSCV)) {
                 /* invalidate cache matching GSCID, simplified model */
-                func = __iot_inval_gscid;
+                iot_func = __iot_inval_gscid;
             } else if (!(cmd.dword0 & RISCV_IOMMU_CMD_IOTINVAL_AV)) {
                 /* invalidate cache matching GSCID and PSCID */
-                func = __iot_inval_pscid;
+                iot_func = __iot_inval_pscid;
             } else {
                 /* invalidate cache matching GSCID and PSCID and ADDR (IOVA) */
-                func = __iot_inval_pscid_iova;
+                iot_func = __iot_inval_pscid_iova;
             }
-            riscv_iommu_iot_inval(s, func,
+            riscv_iommu_iot_inval(s, iot_func,
                 get_field(cmd.dword0, RISCV_IOMMU_CMD_IOTINVAL_GSCID),
                 get_field(cmd.dword0, RISCV_IOMMU_CMD_IOTINVAL_PSCID),
                 cmd.dword1 & TARGET_PAGE_MASK);
@@ -2096,6 +2197,10 @@ static void riscv_iommu_realize(DeviceState *dev, Error **errp)
                                          g_free, NULL);
     s->iot_cache = g_hash_table_new_full(__iot_hash, __iot_equal,
                                          g_free, NULL);
+    s->iot_ctx = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                       NULL, g_free);
+    QTAILQ_INIT(&s->iot_lru);
+    qemu_mutex_init(&s->iot_lock);
 
     s->iommus.le_next = NULL;
     s->iommus.le_prev = NULL;
@@ -2109,6 +2214,8 @@ static void riscv_iommu_unrealize(DeviceState *dev)
     RISCVIOMMUState *s = RISCV_IOMMU(dev);
 
     qemu_mutex_destroy(&s->core_lock);
+    qemu_mutex_destroy(&s->iot_lock);
+    g_hash_table_unref(s->iot_ctx);
     g_hash_table_unref(s->iot_cache);
     g_hash_table_unref(s->ctx_cache);
 }
@@ -72,7 +72,13 @@ struct RISCVIOMMUState {
 
     GHashTable *ctx_cache;          /* Device translation Context Cache */
     GHashTable *iot_cache;          /* IO Translated Address Cache */
+    GHashTable *iot_ctx;            /* IOT entries by GSCID/PSCID pair */
+    QTAILQ_HEAD(, RISCVIOMMUEntry) iot_lru; /* IOT entries, LRU first */
+    QemuMutex iot_lock;             /* IO Translation Cache lock */
     unsigned iot_limit;             /* IO Translation Cache size limit */
+    uint64_t iot_hits;              /* IO Translation Cache statistics */
+    uint64_t iot_misses;
+    uint64_t iot_invals;
 
     /* MMIO Hardware Interface */
     MemoryRegion regs_mr;
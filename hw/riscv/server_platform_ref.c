@@ -83,6 +83,7 @@ struct RVSPMachineState {
 
     /*< public >*/
     Notifier machine_done;
+    bool numa_host_affinity;
     RISCVHartArrayState soc[RVSP_SOCKETS_MAX];
     DeviceState *irqchip[RVSP_SOCKETS_MAX];
     PFlashCFI01 *flash[2];
@@ -1005,6 +1006,10 @@ static void rvsp_ref_machine_done(Notifier *notifier, void *data)
     uint64_t kernel_entry = 0;
     BlockBackend *pflash_blk0;
 
+    if (s->numa_host_affinity) {
+        riscv_socket_bind_host_nodes(machine);
+    }
+
     /* load/create device tree */
     if (machine->dtb) {
         machine->fdt = load_device_tree(machine->dtb, &s->fdt_size);
@@ -1201,6 +1206,21 @@ static void rvsp_ref_set_aia_guests(Object *obj, const char *val, Error **errp)
     }
 }
 
+static bool rvsp_ref_get_numa_host_affinity(Object *obj, Error **errp)
+{
+    RVSPMachineState *s = RVSP_REF_MACHINE(obj);
+
+    return s->numa_host_affinity;
+}
+
+static void rvsp_ref_set_numa_host_affinity(Object *obj, bool value,
+                                            Error **errp)
+{
+    RVSPMachineState *s = RVSP_REF_MACHINE(obj);
+
+    s->numa_host_affinity = value;
+}
+
 static void rvsp_ref_machine_class_init(ObjectClass *oc, void *data)
 {
     char str[128];
@@ -1230,6 +1250,14 @@ static void rvsp_ref_machine_class_init(ObjectClass *oc, void *data)
     sprintf(str, "Set number of guest MMIO pages for AIA IMSIC. Valid value "
                  "should be between 0 and %d.", RVSP_IRQCHIP_MAX_GUESTS);
     object_class_property_set_description(oc, "aia-guests", str);
+
+    object_class_property_add_bool(oc, "numa-host-affinity",
+                                   rvsp_ref_get_numa_host_affinity,
+                                   rvsp_ref_set_numa_host_affinity);
+    object_class_property_set_description(oc, "numa-host-affinity",
+                                          "Set on/off to pin the vCPUs of "
+                                          "each NUMA node to the host nodes "
+                                          "its memory backend is bound to");
 }
 
 static const TypeInfo rvsp_ref_typeinfo = {
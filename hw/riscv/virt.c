@@ -1367,6 +1367,10 @@ static void virt_machine_done(Notifier *notifier, void *data)
     uint64_t kernel_entry = 0;
     BlockBackend *pflash_blk0;
 
+    if (s->numa_host_affinity) {
+        riscv_socket_bind_host_nodes(machine);
+    }
+
     /*
      * An user provided dtb must include everything, including
      * dynamic sysbus devices. Our FDT needs to be finalized.
@@ -1666,6 +1670,10 @@ static void virt_machine_init(MachineState *machine)
         create_fdt(s, memmap);
     }
 
+    if (s->checkpoint) {
+        riscv_boot_checkpoint_init(s->checkpoint);
+    }
+
     s->machine_done.notify = virt_machine_done;
     qemu_add_machine_init_done_notifier(&s->machine_done);
 }
@@ -1753,6 +1761,36 @@ static void virt_set_aclint(Object *obj, bool value, Error **errp)
     s->have_aclint = value;
 }
 
+static char *virt_get_checkpoint(Object *obj, Error **errp)
+{
+    RISCVVirtState *s = RISCV_VIRT_MACHINE(obj);
+
+    return g_strdup(s->checkpoint);
+}
+
+static void virt_set_checkpoint(Object *obj, const char *val, Error **errp)
+{
+    RISCVVirtState *s = RISCV_VIRT_MACHINE(obj);
+
+    g_free(s->checkpoint);
+    s->checkpoint = g_strdup(val);
+}
+
+static bool virt_get_numa_host_affinity(Object *obj, Error **errp)
+{
+    RISCVVirtState *s = RISCV_VIRT_MACHINE(obj);
+
+    return s->numa_host_affinity;
+}
+
+static void virt_set_numa_host_affinity(Object *obj, bool value,
+                                        Error **errp)
+{
+    RISCVVirtState *s = RISCV_VIRT_MACHINE(obj);
+
+    s->numa_host_affinity = value;
+}
+
 static bool virt_get_iopmp(Object *obj, Error **errp)
 {
     RISCVVirtState *s = RISCV_VIRT_MACHINE(obj);
@@ -1835,6 +1873,7 @@ static void virt_machine_class_init(ObjectClass *oc, void *data)
 
     mc->desc = "RISC-V VirtIO board";
     mc->init = virt_machine_init;
+    mc->reset = riscv_boot_checkpoint_reset;
     mc->max_cpus = VIRT_CPUS_MAX;
     mc->default_cpu_type = TYPE_RISCV_CPU_BASE;
     mc->pci_allow_0_address = true;
@@ -1887,6 +1926,22 @@ static void virt_machine_class_init(ObjectClass *oc, void *data)
     object_class_property_set_description(oc, "iopmp",
                                           "Set on/off to enable/disable "
                                           "iopmp device");
+
+    object_class_property_add_bool(oc, "numa-host-affinity",
+                                   virt_get_numa_host_affinity,
+                                   virt_set_numa_host_affinity);
+    object_class_property_set_description(oc, "numa-host-affinity",
+                                          "Set on/off to pin the vCPUs of "
+                                          "each NUMA node to the host nodes "
+                                          "its memory backend is bound to");
+
+    object_class_property_add_str(oc, "checkpoint", virt_get_checkpoint,
+                                  virt_set_checkpoint);
+    object_class_property_set_description(oc, "checkpoint",
+                                          "Boot checkpoint file: resume "
+                                          "from it if it exists, otherwise "
+                                          "create it when the guest issues "
+                                          "the checkpoint semihosting call");
 }
 
 static const TypeInfo virt_machine_typeinfo = {
@@ -63,6 +63,7 @@ typedef struct RISCVXiaohuiState {
     /*< public >*/
     RISCVHartArrayState soc;
     bool boot_linux;
+    char *checkpoint;
 
     int fdt_size;
 } RISCVXiaohuiState;
@@ -414,6 +415,10 @@ static void xiaohui_init(MachineState *machine)
         sysbus_create_simple("xiaohui_cpr",
                              xiaohui_memmap[XIAOHUI_AHB_CPR].base, NULL);
     }
+
+    if (s->checkpoint) {
+        riscv_boot_checkpoint_init(s->checkpoint);
+    }
 }
 
 static bool xiaohui_get_linux(Object *obj, Error **errp)
@@ -429,6 +434,21 @@ static void xiaohui_set_linux(Object *obj, bool value, Error **errp)
     s->boot_linux = value;
 }
 
+static char *xiaohui_get_checkpoint(Object *obj, Error **errp)
+{
+    RISCVXiaohuiState *s = RISCV_XIAOHUI_MACHINE(obj);
+    return g_strdup(s->checkpoint);
+}
+
+static void xiaohui_set_checkpoint(Object *obj, const char *val,
+                                   Error **errp)
+{
+    RISCVXiaohuiState *s = RISCV_XIAOHUI_MACHINE(obj);
+
+    g_free(s->checkpoint);
+    s->checkpoint = g_strdup(val);
+}
+
 static void xiaohui_class_init(ObjectClass *oc, void *data)
 {
     MachineClass *mc = MACHINE_CLASS(oc);
@@ -436,6 +456,7 @@ static void xiaohui_class_init(ObjectClass *oc, void *data)
     mc->desc = "RISC-V xiaohui";
     mc->default_ram_id = "riscv.xiaohui.dram";
     mc->init = xiaohui_init;
+    mc->reset = riscv_boot_checkpoint_reset;
     mc->max_cpus = 8; /* hardcoded limit in BBL */
     mc->default_cpu_type = RISCV_CPU_TYPE_NAME("c907fdvm");
 
@@ -444,6 +465,13 @@ static void xiaohui_class_init(ObjectClass *oc, void *data)
     object_class_property_set_description(oc, "linux",
                                           "Set on/off to show whether to "
                                           "boot linux or not");
+
+    object_class_property_add_str(oc, "checkpoint", xiaohui_get_checkpoint,
+                                  xiaohui_set_checkpoint);
+    object_class_property_set_description(oc, "checkpoint",
+                                          "Boot checkpoint file to resume "
+                                          "from, or to create at the "
+                                          "checkpoint semihosting call");
 }
 
 static const TypeInfo xiaohui_type = {
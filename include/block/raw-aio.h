@@ -17,6 +17,7 @@
 #define QEMU_RAW_AIO_H
 
 #include "block/aio.h"
+#include "block/block-common.h"
 #include "qemu/iov.h"
 
 /* AIO request types */
@@ -70,9 +71,23 @@ void luring_cleanup(LuringState *s);
 
 /* luring_co_submit: submit I/O requests in the thread's current AioContext. */
 int coroutine_fn luring_co_submit(BlockDriverState *bs, int fd, uint64_t offset,
-                                  QEMUIOVector *qiov, int type);
+                                  QEMUIOVector *qiov, int type,
+                                  BdrvRequestFlags flags);
 void luring_detach_aio_context(LuringState *s, AioContext *old_context);
 void luring_attach_aio_context(LuringState *s, AioContext *new_context);
+
+/*
+ * Memory registered with luring_register_buf() is registered as fixed
+ * buffers with every ring, and requests with BDRV_REQ_REGISTERED_BUF that
+ * fall inside it use IORING_OP_READ_FIXED/WRITE_FIXED.  Discarding guest
+ * RAM is disabled while any memory is registered; registration fails if
+ * that is refused (e.g. because virtio-mem or a balloon is in use).
+ */
+bool luring_register_buf(void *host, size_t size, Error **errp);
+void luring_unregister_buf(void *host, size_t size);
+
+/* Drop @fd from the fixed file tables; must be called before closing @fd */
+void luring_unregister_fd(int fd);
 #endif
 
 #ifdef _WIN32
@@ -0,0 +1,25 @@
+/*
+ * SHA-256 round and message schedule fragments.
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef CRYPTO_SHA256_H
+#define CRYPTO_SHA256_H
+
+/*
+ * The host primitives operate on four 32-bit words in host order, with
+ * element 0 the least significant lane; there is no generic fallback,
+ * callers must test the HAVE_* macros and provide their own.
+ *
+ * sha256_2rounds_accel(cdgh, abef, wk):
+ *   Perform two compression rounds on the state split as {ABEF, CDGH}
+ *   (element 3 holds A resp. C), using the pre-added message + constant
+ *   words wk[0], wk[1].  The new ABEF is written to @cdgh.
+ *
+ * sha256_sched_accel(w0, w4, w12):
+ *   Compute W[16..19] into @w0 from W[0..3] in @w0, W[4] and W[9..11]
+ *   in @w4 and W[12..15] in @w12.
+ */
+#include "host/crypto/sha256.h"
+
+#endif /* CRYPTO_SHA256_H */
@@ -795,6 +795,7 @@ struct MemoryRegion {
     bool nonvolatile;
     bool rom_device;
     bool flush_coalesced_mmio;
+    bool lockless_io;
     bool unmergeable;
     uint8_t dirty_log_mask;
     bool is_iommu;
@@ -2256,6 +2257,22 @@ void memory_region_set_flush_coalesced(MemoryRegion *mr);
  */
 void memory_region_clear_flush_coalesced(MemoryRegion *mr);
 
+/**
+ * memory_region_enable_lockless_io: Dispatch accesses without the BQL.
+ *
+ * By default MMIO accesses are dispatched with the Big QEMU Lock held.
+ * A device that protects its own state (per-vCPU registers, atomics or a
+ * private lock) can opt out of that, so that concurrent vCPUs do not
+ * serialize on the BQL.  The device must do all of its own locking:
+ * its callbacks may run concurrently on several vCPU threads, and must
+ * take the BQL themselves for anything that still needs it, e.g. raising
+ * interrupts.  The device re-entrancy guard is disabled for @mr, since
+ * it is not thread-safe.
+ *
+ * @mr: the memory region to be updated.
+ */
+void memory_region_enable_lockless_io(MemoryRegion *mr);
+
 /**
  * memory_region_add_eventfd: Request an eventfd to be triggered when a word
  *                            is written to a location.
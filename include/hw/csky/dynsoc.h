@@ -59,6 +59,8 @@ struct dynsoc_device {
     char        filename[32];
     uint64_t    addr;
     int         irq;
+    /* worker threads of a custom device, 0 for its default */
+    uint32_t    workers;
 };
 
 struct dynsoc_memory {
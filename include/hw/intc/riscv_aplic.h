@@ -54,6 +54,15 @@ struct RISCVAPLICState {
     uint32_t *iforce;
     uint32_t *ithreshold;
 
+    /*
+     * Direct mode: enabled and pending sources of each IDC, one bitmap
+     * per priority level (allocated on first use), plus a bitmap of the
+     * non-empty levels so topi is found without scanning all sources.
+     */
+    unsigned long **idc_ready;
+    unsigned long *idc_ready_prio;
+    uint32_t idc_ready_prio_longs;
+
     /* topology */
 #define QEMU_APLIC_MAX_CHILDREN        16
     struct RISCVAPLICState *parent;
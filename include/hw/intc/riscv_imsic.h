@@ -53,6 +53,12 @@ struct RISCVIMSICState {
     uint32_t num_eistate;
     uint32_t *eidelivery;
     uint32_t *eithreshold;
+    /* Pending and enabled bits, num_irqs / 32 words per interrupt file */
+    uint32_t *eip;
+    uint32_t *eie;
+    /* Cached highest priority pending and enabled identity per file */
+    uint32_t *topid;
+    /* Migration format: one IMSIC_EISTATE_* word per interrupt */
     uint32_t *eistate;
 
     /* config */
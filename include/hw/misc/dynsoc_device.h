@@ -0,0 +1,116 @@
+/*
+ * Base type for dynsoc device modules
+ *
+ * Copyright (c) 2024 Alibaba Group. All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HW_MISC_DYNSOC_DEVICE_H
+#define HW_MISC_DYNSOC_DEVICE_H
+
+#include "hw/sysbus.h"
+#include "qemu/queue.h"
+#include "qemu/thread.h"
+#include "qom/object.h"
+
+#define TYPE_DYNSOC_DEVICE "dynsoc-device"
+OBJECT_DECLARE_TYPE(DynSocDevice, DynSocDeviceClass, DYNSOC_DEVICE)
+
+/*
+ * Runs on a worker thread registered with RCU, so it may access guest
+ * RAM.  It must not take the BQL, and so must not access MMIO regions:
+ * reset and migration wait for pending work with the BQL held.
+ */
+typedef int DynSocWorkFunc(void *opaque);
+/* Runs in the main loop with the BQL; return true to raise the IRQ */
+typedef bool DynSocDoneFunc(void *opaque, int ret);
+
+typedef struct DynSocJob DynSocJob;
+
+struct DynSocDeviceClass {
+    SysBusDeviceClass parent_class;
+
+    DeviceRealize parent_realize;
+
+    /*
+     * The device's MMIO callbacks protect its state themselves, so
+     * dynsoc_device_init_mmio() dispatches them without the BQL.
+     */
+    bool thread_safe;
+};
+
+struct DynSocDevice {
+    SysBusDevice parent_obj;
+
+    qemu_irq irq;
+    uint32_t nb_workers;
+
+    QemuThread *workers;
+    QemuMutex lock;
+    QemuCond cond;
+    QSIMPLEQ_HEAD(, DynSocJob) pending;
+    QSIMPLEQ_HEAD(, DynSocJob) completed;
+    unsigned int inflight;
+    bool stopping;
+    QEMUBH *bh;
+};
+
+/**
+ * dynsoc_device_create: Create a device of the board description.
+ *
+ * @type may be any sysbus device type; "workers" is only set for types
+ * deriving from TYPE_DYNSOC_DEVICE, and only when @workers is not 0.
+ * The first MMIO region is mapped at @addr and the first IRQ connected
+ * to @irq when it is not NULL.
+ */
+DeviceState *dynsoc_device_create(const char *type, hwaddr addr,
+                                  uint32_t workers, qemu_irq irq);
+
+/**
+ * dynsoc_device_init_mmio: Create and register the device's MMIO region.
+ *
+ * Like memory_region_init_io() followed by sysbus_init_mmio(), except
+ * that the region bypasses the BQL when the device class is thread_safe.
+ */
+void dynsoc_device_init_mmio(DynSocDevice *s, MemoryRegion *mr,
+                             const MemoryRegionOps *ops, void *opaque,
+                             const char *name, uint64_t size);
+
+/**
+ * dynsoc_device_submit: Run @work on the device's worker threads.
+ *
+ * Safe to call from any thread.  Once @work returns, @done (if any) is
+ * called from the main loop with its result, and the completion IRQ is
+ * raised unless @done returns false.  Jobs of one device may complete in
+ * any order when it has more than one worker.
+ */
+void dynsoc_device_submit(DynSocDevice *s, DynSocWorkFunc *work,
+                          DynSocDoneFunc *done, void *opaque);
+
+/**
+ * dynsoc_device_drain: Wait for all submitted jobs and complete them.
+ *
+ * Must be called with the BQL held, e.g. from the device's reset.
+ */
+void dynsoc_device_drain(DynSocDevice *s);
+
+/**
+ * dynsoc_device_set_irq: Set the completion IRQ.
+ *
+ * For MMIO callbacks of thread_safe devices, which run without the BQL.
+ */
+void dynsoc_device_set_irq(DynSocDevice *s, int level);
+
+#endif
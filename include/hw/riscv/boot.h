@@ -23,6 +23,7 @@
 #include "exec/cpu-defs.h"
 #include "hw/loader.h"
 #include "hw/riscv/riscv_hart.h"
+#include "qapi/qapi-types-run-state.h"
 
 #define RISCV32_BIOS_BIN    "opensbi-riscv32-generic-fw_dynamic.bin"
 #define RISCV64_BIOS_BIN    "opensbi-riscv64-generic-fw_dynamic.bin"
@@ -62,5 +63,7 @@ void riscv_rom_copy_firmware_info(MachineState *machine, hwaddr rom_base,
                                   uint64_t kernel_entry);
 void riscv_setup_direct_kernel(hwaddr kernel_addr, hwaddr fdt_addr);
 void riscv_setup_firmware_boot(MachineState *machine);
+void riscv_boot_checkpoint_init(const char *filename);
+void riscv_boot_checkpoint_reset(MachineState *machine, ShutdownCause reason);
 
 #endif /* RISCV_BOOT_H */
@@ -104,6 +104,16 @@ void riscv_socket_fdt_write_id(const MachineState *ms, const char *node_name,
  */
 void riscv_socket_fdt_write_distance_matrix(const MachineState *ms);
 
+/**
+ * riscv_socket_bind_host_nodes:
+ * @ms: pointer to machine state
+ *
+ * Pin the vCPU threads of each socket whose memory backend is bound to
+ * host NUMA nodes (policy=bind,host-nodes=...) to the host CPUs of those
+ * nodes, so that a socket's harts run next to its RAM.
+ */
+void riscv_socket_bind_host_nodes(const MachineState *ms);
+
 CpuInstanceProperties
 riscv_numa_cpu_index_to_props(MachineState *ms, unsigned cpu_index);
 
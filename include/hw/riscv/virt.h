@@ -56,10 +56,12 @@ struct RISCVVirtState {
     int fdt_size;
     bool have_aclint;
     bool have_iopmp;
+    bool numa_host_affinity;
     RISCVVirtAIAType aia_type;
     int aia_guests;
     char *oem_id;
     char *oem_table_id;
+    char *checkpoint;
     OnOffAuto acpi;
     const MemMapEntry *memmap;
     struct GPEXHost *gpex_host;
@@ -68,4 +68,29 @@ bool delete_snapshot(const char *name,
  */
 void load_snapshot_resume(RunState state);
 
+/**
+ * save_checkpoint: Write a boot checkpoint.
+ * @filename: checkpoint file to create
+ * @errp: pointer to error object
+ *
+ * Save all migratable RAM and the device state to @filename, which does
+ * not need a block device.  The VM is stopped while saving and resumed
+ * afterwards if it was running.
+ * On success, return %true.
+ * On failure, store an error through @errp and return %false.
+ */
+bool save_checkpoint(const char *filename, Error **errp);
+
+/**
+ * load_checkpoint: Restore a boot checkpoint.
+ * @filename: checkpoint file written by save_checkpoint()
+ * @errp: pointer to error object
+ *
+ * Must be called with the VM stopped, typically from the initial machine
+ * reset.  RAM contents are copied from the file into guest memory.
+ * On success, return %true.
+ * On failure, store an error through @errp and return %false.
+ */
+bool load_checkpoint(const char *filename, Error **errp);
+
 #endif
@@ -86,9 +86,10 @@ struct QEMUTimer {
     QEMUTimerList *timer_list;
     QEMUTimerCB *cb;
     void *opaque;
-    QEMUTimer *next;
     int attributes;
     int scale;
+    unsigned heap_index;        /* position in the timer list's heap */
+    uint64_t heap_seq;          /* orders timers with equal expire_time */
 };
 
 extern QEMUTimerListGroup main_loop_tlg;
@@ -51,6 +51,11 @@ static inline const char *semihosting_get_cmdline(void)
 {
     return NULL;
 }
+
+static inline bool semihosting_checkpoint(void)
+{
+    return false;
+}
 #else /* !CONFIG_USER_ONLY */
 /**
  * semihosting_enabled:
@@ -64,6 +69,27 @@ const char *semihosting_get_arg(int i);
 int semihosting_get_argc(void);
 const char *semihosting_get_cmdline(void);
 void semihosting_arg_fallback(const char *file, const char *cmd);
+
+typedef void SemihostingCheckpointFn(void *opaque);
+
+/**
+ * semihosting_set_checkpoint_handler:
+ * @fn: handler to call, or NULL to remove the current one
+ * @opaque: argument passed to @fn
+ *
+ * Register the board hook run when the guest issues the QEMU specific
+ * SYS_QEMU_CHECKPOINT semihosting call.
+ */
+void semihosting_set_checkpoint_handler(SemihostingCheckpointFn *fn,
+                                        void *opaque);
+
+/**
+ * semihosting_checkpoint:
+ *
+ * Run the registered checkpoint handler, if any.
+ * Return true if a handler was called.
+ */
+bool semihosting_checkpoint(void);
 /* for vl.c hooks */
 void qemu_semihosting_enable(void);
 int qemu_semihosting_config_options(const char *optstr);
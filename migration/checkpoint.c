@@ -0,0 +1,353 @@
+/*
+ * Boot checkpoints
+ *
+ * A checkpoint is a flat file holding every migratable RAM block at a
+ * CHECKPOINT_ALIGN aligned offset, followed by the device state stream
+ * as produced by qemu_save_device_state().  All-zero host pages are not
+ * written, so the file stays sparse.  On restore, only the data extents
+ * of the file (as found with SEEK_DATA/SEEK_HOLE) are read into guest
+ * RAM; the holes are discarded, so their pages are faulted in as zero
+ * pages when first touched, which keeps resuming a mostly idle guest
+ * from a large checkpoint cheap.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/bswap.h"
+#include "qemu/cutils.h"
+#include "qemu/rcu.h"
+#include "qemu/units.h"
+#include "qapi/error.h"
+#include "exec/memory.h"
+#include "exec/ramblock.h"
+#include "io/channel-file.h"
+#include "migration/global_state.h"
+#include "migration/snapshot.h"
+#include "sysemu/runstate.h"
+#include "migration.h"
+#include "qemu-file.h"
+#include "ram.h"
+#include "savevm.h"
+
+#define CHECKPOINT_MAGIC        "QEMUCKPT"
+#define CHECKPOINT_VERSION      1
+#define CHECKPOINT_ALIGN        (2 * MiB)
+#define CHECKPOINT_MAX_BLOCKS   1024
+
+typedef struct QEMU_PACKED CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nr_blocks;
+    uint64_t state_offset;
+} CheckpointHeader;
+
+typedef struct QEMU_PACKED CheckpointBlock {
+    char idstr[256];
+    uint64_t offset;
+    uint64_t length;
+} CheckpointBlock;
+
+static bool checkpoint_pwrite(QIOChannelFile *ioc, void *buf, size_t len,
+                              uint64_t offset, Error **errp)
+{
+    ssize_t ret;
+
+    while (len) {
+        ret = qio_channel_pwrite(QIO_CHANNEL(ioc), buf, len, offset, errp);
+        if (ret < 0) {
+            return false;
+        }
+        buf += ret;
+        len -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+static bool checkpoint_pread(QIOChannelFile *ioc, void *buf, size_t len,
+                             uint64_t offset, Error **errp)
+{
+    ssize_t ret;
+
+    while (len) {
+        ret = qio_channel_pread(QIO_CHANNEL(ioc), buf, len, offset, errp);
+        if (ret < 0) {
+            return false;
+        }
+        if (ret == 0) {
+            error_setg(errp, "Checkpoint file is truncated");
+            return false;
+        }
+        buf += ret;
+        len -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+/* Write the non-zero host pages of @host, leaving holes for the rest. */
+static bool checkpoint_save_ram(QIOChannelFile *ioc, uint8_t *host,
+                                uint64_t length, uint64_t offset,
+                                Error **errp)
+{
+    size_t page = qemu_real_host_page_size();
+    uint64_t start, end;
+
+    for (start = 0; start < length; start = end) {
+        while (start < length && buffer_is_zero(host + start, page)) {
+            start += page;
+        }
+        for (end = start; end < length; end += page) {
+            if (buffer_is_zero(host + end, page)) {
+                break;
+            }
+        }
+        if (end > start &&
+            !checkpoint_pwrite(ioc, host + start, end - start,
+                               offset + start, errp)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Find the first data extent at or after @pos in the block of @length
+ * bytes stored at @offset in the file: [@data, @hole) is data, and
+ * [@pos, @data) is a hole.  Without hole reporting, everything is data.
+ */
+static void checkpoint_find_data(int fd, uint64_t offset, uint64_t length,
+                                 uint64_t pos, uint64_t *data, uint64_t *hole)
+{
+#if defined SEEK_HOLE && defined SEEK_DATA
+    off_t ret = lseek(fd, offset + pos, SEEK_DATA);
+
+    if (ret >= 0) {
+        *data = MIN(ret - offset, length);
+        ret = lseek(fd, offset + *data, SEEK_HOLE);
+        *hole = ret >= 0 ? MAX(MIN(ret - offset, length), *data) : length;
+        return;
+    }
+    if (errno == ENXIO) {
+        /* Nothing but holes up to the end of the file */
+        *data = *hole = length;
+        return;
+    }
+#endif
+    *data = pos;
+    *hole = length;
+}
+
+/* Zero a range of @block that is a hole in the checkpoint */
+static void checkpoint_zero_ram(RAMBlock *block, uint64_t start,
+                                uint64_t length)
+{
+    if (!ram_block_discard_is_disabled() &&
+        QEMU_IS_ALIGNED(start | length, block->page_size) &&
+        ram_block_discard_range(block, start, length) == 0) {
+        return;
+    }
+    if (!buffer_is_zero(block->host + start, length)) {
+        memset(block->host + start, 0, length);
+    }
+}
+
+static bool checkpoint_load_ram(QIOChannelFile *ioc, CheckpointBlock *cb,
+                                Error **errp)
+{
+    uint64_t offset = le64_to_cpu(cb->offset);
+    uint64_t length = le64_to_cpu(cb->length);
+    uint64_t pos, data, hole;
+    RAMBlock *block;
+
+    cb->idstr[sizeof(cb->idstr) - 1] = '\0';
+    block = qemu_ram_block_by_name(cb->idstr);
+    if (!block) {
+        error_setg(errp, "Checkpoint RAM block '%s' does not exist",
+                   cb->idstr);
+        return false;
+    }
+    if (length != block->used_length) {
+        error_setg(errp, "Checkpoint RAM block '%s' has length 0x%" PRIx64
+                   ", expected 0x" RAM_ADDR_FMT, cb->idstr, length,
+                   block->used_length);
+        return false;
+    }
+
+    for (pos = 0; pos < length; pos = hole) {
+        checkpoint_find_data(ioc->fd, offset, length, pos, &data, &hole);
+        if (data > pos) {
+            checkpoint_zero_ram(block, pos, data - pos);
+        }
+        if (hole > data &&
+            !checkpoint_pread(ioc, block->host + data, hole - data,
+                              offset + data, errp)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool save_checkpoint(const char *filename, Error **errp)
+{
+    g_autofree char *tmpname = g_strdup_printf("%s.tmp", filename);
+    g_autofree CheckpointBlock *blocks = NULL;
+    CheckpointHeader hdr = { };
+    QIOChannelFile *ioc;
+    QEMUFile *f;
+    RAMBlock *block;
+    uint64_t offset;
+    uint32_t nr_blocks = 0, i = 0;
+    bool saved_vm_running;
+    bool ok = false;
+    int ret;
+
+    saved_vm_running = runstate_is_running();
+    vm_stop(RUN_STATE_SAVE_VM);
+    global_state_store_running();
+
+    ioc = qio_channel_file_new_path(tmpname,
+                                    O_WRONLY | O_CREAT | O_TRUNC | O_BINARY,
+                                    0660, errp);
+    if (!ioc) {
+        goto the_end;
+    }
+    qio_channel_set_name(QIO_CHANNEL(ioc), "migration-checkpoint-save");
+
+    WITH_RCU_READ_LOCK_GUARD() {
+        RAMBLOCK_FOREACH_MIGRATABLE(block) {
+            nr_blocks++;
+        }
+        blocks = g_new0(CheckpointBlock, nr_blocks);
+        offset = ROUND_UP(sizeof(hdr) + nr_blocks * sizeof(*blocks),
+                          CHECKPOINT_ALIGN);
+
+        RAMBLOCK_FOREACH_MIGRATABLE(block) {
+            pstrcpy(blocks[i].idstr, sizeof(blocks[i].idstr), block->idstr);
+            blocks[i].offset = cpu_to_le64(offset);
+            blocks[i].length = cpu_to_le64(block->used_length);
+            if (!checkpoint_save_ram(ioc, block->host, block->used_length,
+                                     offset, errp)) {
+                break;
+            }
+            offset = ROUND_UP(offset + block->used_length, CHECKPOINT_ALIGN);
+            i++;
+        }
+    }
+    if (i != nr_blocks) {
+        object_unref(OBJECT(ioc));
+        goto the_end;
+    }
+
+    memcpy(hdr.magic, CHECKPOINT_MAGIC, sizeof(hdr.magic));
+    hdr.version = cpu_to_le32(CHECKPOINT_VERSION);
+    hdr.nr_blocks = cpu_to_le32(nr_blocks);
+    hdr.state_offset = cpu_to_le64(offset);
+    if (!checkpoint_pwrite(ioc, &hdr, sizeof(hdr), 0, errp) ||
+        !checkpoint_pwrite(ioc, blocks, nr_blocks * sizeof(*blocks),
+                           sizeof(hdr), errp) ||
+        qio_channel_io_seek(QIO_CHANNEL(ioc), offset, SEEK_SET, errp) < 0) {
+        object_unref(OBJECT(ioc));
+        goto the_end;
+    }
+
+    f = qemu_file_new_output(QIO_CHANNEL(ioc));
+    object_unref(OBJECT(ioc));
+    ret = qemu_save_device_state(f);
+    if (qemu_fclose(f) < 0 || ret < 0) {
+        error_setg(errp, "Failed to save device state to checkpoint");
+        goto the_end;
+    }
+
+    if (rename(tmpname, filename) < 0) {
+        error_setg_errno(errp, errno, "Cannot rename '%s' to '%s'",
+                         tmpname, filename);
+        goto the_end;
+    }
+    ok = true;
+
+ the_end:
+    if (!ok) {
+        unlink(tmpname);
+    }
+    if (saved_vm_running) {
+        vm_start();
+    }
+    return ok;
+}
+
+bool load_checkpoint(const char *filename, Error **errp)
+{
+    g_autofree CheckpointBlock *blocks = NULL;
+    CheckpointHeader hdr;
+    QIOChannelFile *ioc;
+    QEMUFile *f;
+    uint32_t nr_blocks, i;
+    uint64_t offset;
+    int ret;
+
+    ioc = qio_channel_file_new_path(filename, O_RDONLY | O_BINARY, 0, errp);
+    if (!ioc) {
+        return false;
+    }
+    qio_channel_set_name(QIO_CHANNEL(ioc), "migration-checkpoint-load");
+
+    if (!checkpoint_pread(ioc, &hdr, sizeof(hdr), 0, errp)) {
+        goto fail;
+    }
+    if (memcmp(hdr.magic, CHECKPOINT_MAGIC, sizeof(hdr.magic))) {
+        error_setg(errp, "'%s' is not a checkpoint file", filename);
+        goto fail;
+    }
+    if (le32_to_cpu(hdr.version) != CHECKPOINT_VERSION) {
+        error_setg(errp, "Unsupported checkpoint version %u",
+                   le32_to_cpu(hdr.version));
+        goto fail;
+    }
+    nr_blocks = le32_to_cpu(hdr.nr_blocks);
+    if (nr_blocks > CHECKPOINT_MAX_BLOCKS) {
+        error_setg(errp, "Checkpoint has too many RAM blocks (%u)",
+                   nr_blocks);
+        goto fail;
+    }
+
+    blocks = g_new(CheckpointBlock, nr_blocks);
+    if (!checkpoint_pread(ioc, blocks, nr_blocks * sizeof(*blocks),
+                          sizeof(hdr), errp)) {
+        goto fail;
+    }
+    for (i = 0; i < nr_blocks; i++) {
+        if (!checkpoint_load_ram(ioc, &blocks[i], errp)) {
+            goto fail;
+        }
+    }
+
+    offset = le64_to_cpu(hdr.state_offset);
+    if (qio_channel_io_seek(QIO_CHANNEL(ioc), offset, SEEK_SET, errp) < 0) {
+        goto fail;
+    }
+    f = qemu_file_new_input(QIO_CHANNEL(ioc));
+    object_unref(OBJECT(ioc));
+
+    /* The stream has no configuration section, see qemu_save_device_state */
+    if (qemu_get_be32(f) != QEMU_VM_FILE_MAGIC ||
+        qemu_get_be32(f) != QEMU_VM_FILE_VERSION) {
+        qemu_fclose(f);
+        error_setg(errp, "Checkpoint device state is corrupted");
+        return false;
+    }
+    ret = qemu_load_device_state(f);
+    qemu_fclose(f);
+    migration_incoming_state_destroy();
+    if (ret < 0) {
+        error_setg(errp, "Failed to load device state from checkpoint");
+        return false;
+    }
+    return true;
+
+ fail:
+    object_unref(OBJECT(ioc));
+    return false;
+}
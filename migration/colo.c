@@ -15,6 +15,7 @@
 #include "qapi/error.h"
 #include "qapi/qapi-commands-migration.h"
 #include "migration.h"
+#include "migration-stats.h"
 #include "qemu-file.h"
 #include "savevm.h"
 #include "migration/colo.h"
@@ -24,6 +25,7 @@
 #include "qemu/error-report.h"
 #include "qemu/main-loop.h"
 #include "qemu/rcu.h"
+#include "qemu/stats64.h"
 #include "migration/failover.h"
 #include "migration/ram.h"
 #include "block/replication.h"
@@ -42,8 +44,35 @@ static Notifier packets_compare_notifier;
 /* User need to know colo mode after COLO failover */
 static COLOMode last_colo_mode;
 
+/* Checkpoint statistics, reported by query-colo-status */
+static struct {
+    Stat64 count;
+    Stat64 last_pause;
+    Stat64 max_pause;
+    Stat64 total_pause;
+    Stat64 last_pages;
+} colo_stats;
+
 #define COLO_BUFFER_BASE_SIZE (4 * 1024 * 1024)
 
+static void colo_checkpoint_stats_update(int64_t stop_time, uint64_t pages)
+{
+    uint64_t pause = qemu_clock_get_us(QEMU_CLOCK_REALTIME) - stop_time;
+
+    stat64_add(&colo_stats.count, 1);
+    stat64_set(&colo_stats.last_pause, pause);
+    stat64_max(&colo_stats.max_pause, pause);
+    stat64_add(&colo_stats.total_pause, pause);
+    stat64_set(&colo_stats.last_pages, pages);
+    trace_colo_checkpoint_done(pause, pages);
+}
+
+static uint64_t colo_ram_pages_sent(void)
+{
+    return stat64_get(&mig_stats.normal_pages) +
+           stat64_get(&mig_stats.zero_pages);
+}
+
 bool migration_in_colo_state(void)
 {
     MigrationState *s = migrate_get_current();
@@ -291,6 +320,16 @@ COLOStatus *qmp_query_colo_status(Error **errp)
     s->mode = get_colo_mode();
     s->last_mode = last_colo_mode;
 
+    if (stat64_get(&colo_stats.count)) {
+        s->checkpoint_stats = g_new0(COLOCheckpointStats, 1);
+        s->checkpoint_stats->count = stat64_get(&colo_stats.count);
+        s->checkpoint_stats->last_pause = stat64_get(&colo_stats.last_pause);
+        s->checkpoint_stats->max_pause = stat64_get(&colo_stats.max_pause);
+        s->checkpoint_stats->total_pause =
+            stat64_get(&colo_stats.total_pause);
+        s->checkpoint_stats->last_pages = stat64_get(&colo_stats.last_pages);
+    }
+
     switch (failover_get_state()) {
     case FAILOVER_STATUS_NONE:
         s->reason = COLO_EXIT_REASON_NONE;
@@ -408,6 +447,8 @@ static int colo_do_checkpoint_transaction(MigrationState *s,
                                           QEMUFile *fb)
 {
     Error *local_err = NULL;
+    int64_t stop_time;
+    uint64_t pages;
     int ret = -1;
 
     colo_send_message(s->to_dst_file, COLO_MESSAGE_CHECKPOINT_REQUEST,
@@ -432,6 +473,7 @@ static int colo_do_checkpoint_transaction(MigrationState *s,
     }
     vm_stop_force_state(RUN_STATE_COLO);
     bql_unlock();
+    stop_time = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
     trace_colo_vm_state_change("run", "stop");
     /*
      * Failover request bh could be called after vm_stop_force_state(),
@@ -469,7 +511,9 @@ static int colo_do_checkpoint_transaction(MigrationState *s,
      * TODO: We may need a timeout mechanism to prevent COLO process
      * to be blocked here.
      */
+    pages = colo_ram_pages_sent();
     qemu_savevm_live_state(s->to_dst_file);
+    pages = colo_ram_pages_sent() - pages;
 
     qemu_fflush(fb);
 
@@ -512,6 +556,7 @@ static int colo_do_checkpoint_transaction(MigrationState *s,
     bql_lock();
     vm_start();
     bql_unlock();
+    colo_checkpoint_stats_update(stop_time, pages);
     trace_colo_vm_state_change("stop", "run");
 
 out:
@@ -659,12 +704,15 @@ static void colo_incoming_process_checkpoint(MigrationIncomingState *mis,
 {
     uint64_t total_size;
     uint64_t value;
+    uint64_t pages;
+    int64_t stop_time;
     Error *local_err = NULL;
     int ret;
 
     bql_lock();
     vm_stop_force_state(RUN_STATE_COLO);
     bql_unlock();
+    stop_time = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
     trace_colo_vm_state_change("run", "stop");
 
     /* FIXME: This is unnecessary for periodic checkpoint mode */
@@ -726,7 +774,7 @@ static void colo_incoming_process_checkpoint(MigrationIncomingState *mis,
 
     bql_lock();
     vmstate_loading = true;
-    colo_flush_ram_cache();
+    pages = colo_flush_ram_cache();
     ret = qemu_load_device_state(fb);
     if (ret < 0) {
         error_setg(errp, "COLO: load device state failed");
@@ -764,6 +812,7 @@ static void colo_incoming_process_checkpoint(MigrationIncomingState *mis,
     vmstate_loading = false;
     vm_start();
     bql_unlock();
+    colo_checkpoint_stats_update(stop_time, pages);
     trace_colo_vm_state_change("stop", "run");
 
     if (failover_get_state() == FAILOVER_STATUS_RELAUNCH) {
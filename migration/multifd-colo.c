@@ -0,0 +1,79 @@
+/*
+ * Multifd COLO support
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/cutils.h"
+#include "exec/ramblock.h"
+#include "migration/colo.h"
+#include "migration.h"
+#include "multifd.h"
+#include "ram.h"
+
+/*
+ * The secondary side of COLO keeps a copy of the guest RAM in
+ * block->colo_cache.  Before COLO is entered (i.e. during the initial
+ * migration) pages go to both the guest RAM and the cache.  Once in COLO,
+ * the checkpoint pages only go to the cache and are recorded in the dirty
+ * bitmap, colo_flush_ram_cache() copies them into the guest RAM when the
+ * whole checkpoint has been received.  This mirrors what ram_load_precopy()
+ * does for pages that come through the main channel.
+ *
+ * COLO is enabled on the destination before the RAM setup section is
+ * loaded, and the multifd channels do not carry any page before the sync
+ * at the end of that section, so no page can miss the COLO cache.
+ */
+
+/**
+ * multifd_colo_prepare_recv: redirect a received packet to the COLO cache
+ *
+ * Called after the packet header has been parsed and before the pages are
+ * read into p->host.
+ *
+ * @p: the receive params of the channel
+ */
+void multifd_colo_prepare_recv(MultiFDRecvParams *p)
+{
+    if (!migration_incoming_colo_enabled() ||
+        !migration_incoming_in_colo_state()) {
+        return;
+    }
+
+    assert(p->block->colo_cache);
+    p->host = p->block->colo_cache;
+    colo_record_bitmap(p->block, p->normal, p->normal_num);
+    colo_record_bitmap(p->block, p->zero, p->zero_num);
+}
+
+/**
+ * multifd_colo_process_recv: back up received pages into the COLO cache
+ *
+ * Called after the pages of a packet have been loaded into p->host.
+ *
+ * @p: the receive params of the channel
+ */
+void multifd_colo_process_recv(MultiFDRecvParams *p)
+{
+    uint32_t i;
+
+    if (!migration_incoming_colo_enabled() ||
+        migration_incoming_in_colo_state()) {
+        return;
+    }
+
+    for (i = 0; i < p->normal_num; i++) {
+        memcpy(p->block->colo_cache + p->normal[i],
+               p->block->host + p->normal[i], p->page_size);
+    }
+
+    for (i = 0; i < p->zero_num; i++) {
+        void *page = p->block->colo_cache + p->zero[i];
+
+        if (!buffer_is_zero(page, p->page_size)) {
+            memset(page, 0, p->page_size);
+        }
+    }
+}
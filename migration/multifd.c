@@ -529,6 +529,8 @@ static int multifd_recv_unfill_packet(MultiFDRecvParams *p, Error **errp)
         p->zero[i] = offset;
     }
 
+    multifd_colo_prepare_recv(p);
+
     return 0;
 }
 
@@ -1524,6 +1526,10 @@ static void *multifd_recv_thread(void *opaque)
             if (ret != 0) {
                 break;
             }
+
+            if (use_packets) {
+                multifd_colo_process_recv(p);
+            }
         }
 
         if (use_packets) {
@@ -208,6 +208,7 @@ Property migration_properties[] = {
                         MIGRATION_CAPABILITY_SWITCHOVER_ACK),
     DEFINE_PROP_MIG_CAP("x-dirty-limit", MIGRATION_CAPABILITY_DIRTY_LIMIT),
     DEFINE_PROP_MIG_CAP("mapped-ram", MIGRATION_CAPABILITY_MAPPED_RAM),
+    DEFINE_PROP_MIG_CAP("dirty-extents", MIGRATION_CAPABILITY_DIRTY_EXTENTS),
     DEFINE_PROP_END_OF_LIST(),
 };
 
@@ -253,6 +254,13 @@ bool migrate_dirty_bitmaps(void)
     return s->capabilities[MIGRATION_CAPABILITY_DIRTY_BITMAPS];
 }
 
+bool migrate_dirty_extents(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->capabilities[MIGRATION_CAPABILITY_DIRTY_EXTENTS];
+}
+
 bool migrate_dirty_limit(void)
 {
     MigrationState *s = migrate_get_current();
@@ -676,6 +684,19 @@ bool migrate_caps_check(bool *old_caps, bool *new_caps, Error **errp)
         }
     }
 
+    if (new_caps[MIGRATION_CAPABILITY_DIRTY_EXTENTS]) {
+        if (new_caps[MIGRATION_CAPABILITY_POSTCOPY_RAM]) {
+            error_setg(errp, "Dirty extents are incompatible with postcopy");
+            return false;
+        }
+
+        if (new_caps[MIGRATION_CAPABILITY_MAPPED_RAM]) {
+            error_setg(errp,
+                       "Dirty extents are incompatible with mapped-ram");
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -31,6 +31,7 @@
 #include "qemu/error-report.h"
 #include "trace.h"
 #include "hw/boards.h"
+#include "exec/memory.h"
 #include "exec/ramblock.h"
 #include "socket.h"
 #include "yank_functions.h"
@@ -397,6 +398,17 @@ bool postcopy_ram_supported_by_host(MigrationIncomingState *mis, Error **errp)
         goto out;
     }
 
+    /*
+     * Postcopy discards guest RAM and refills it through userfaultfd;
+     * memory pinned by a device (e.g. io_uring fixed buffers) would keep
+     * pointing at the discarded pages.
+     */
+    if (ram_block_discard_is_disabled()) {
+        error_setg(errp, "Postcopy is not supported while guest RAM is "
+                   "pinned by a device");
+        goto out;
+    }
+
     /* Version and features check */
     if (!ufd_check_and_apply(ufd, mis, errp)) {
         goto out;
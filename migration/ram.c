@@ -31,6 +31,7 @@
 #include "qemu/bitops.h"
 #include "qemu/bitmap.h"
 #include "qemu/madvise.h"
+#include "qemu/units.h"
 #include "qemu/main-loop.h"
 #include "xbzrle.h"
 #include "ram-compress.h"
@@ -57,6 +58,10 @@
 #include "sysemu/cpu-throttle.h"
 #include "savevm.h"
 #include "qemu/iov.h"
+#include "qemu/coroutine.h"
+#include "block/aio-wait.h"
+#include "block/thread-pool.h"
+#include "migration/channel-block.h"
 #include "multifd.h"
 #include "sysemu/runstate.h"
 #include "rdma.h"
@@ -80,9 +85,11 @@
  * RAM_SAVE_FLAG_COMPRESS_PAGE just rename it.
  */
 /*
- * RAM_SAVE_FLAG_FULL was obsoleted in 2009, it can be reused now
+ * RAM_SAVE_FLAG_FULL was obsoleted in 2009, it is reused for
+ * RAM_SAVE_FLAG_DIRTY_EXTENTS, which is only sent when the dirty-extents
+ * capability is enabled on both sides.
  */
-#define RAM_SAVE_FLAG_FULL     0x01
+#define RAM_SAVE_FLAG_DIRTY_EXTENTS    0x01
 #define RAM_SAVE_FLAG_ZERO     0x02
 #define RAM_SAVE_FLAG_MEM_SIZE 0x04
 #define RAM_SAVE_FLAG_PAGE     0x08
@@ -112,6 +119,12 @@
  */
 #define MAPPED_RAM_LOAD_BUF_SIZE 0x100000
 
+/*
+ * When saving or loading a snapshot with mapped-ram, the amount of guest
+ * memory each writer/reader coroutine claims at a time.
+ */
+#define MAPPED_RAM_BULK_CHUNK_SIZE 0x100000
+
 XBZRLECacheStats xbzrle_counters;
 
 /* used by the search for pages to send */
@@ -385,6 +398,8 @@ struct RAMState {
     bool xbzrle_started;
     /* Are we on the last stage of migration */
     bool last_stage;
+    /* dirty_sync_count when the dirty extents were last sent */
+    uint64_t dirty_extents_sync;
 
     /* total handled target pages at the beginning of period */
     uint64_t target_page_count_prev;
@@ -1048,6 +1063,281 @@ static void migration_trigger_throttle(RAMState *rs)
     }
 }
 
+/*
+ * A fixed set of helper threads that join the calling thread in running
+ * one function to completion, such as a scan or copy that hands out its
+ * work items with an atomic counter.  The threads are kept between runs
+ * so that an operation repeated on every bitmap sync or checkpoint does
+ * not create and join threads each time.
+ */
+typedef void RAMWorkFn(void *opaque);
+
+typedef struct RAMWorkerPool {
+    QemuMutex lock;
+    /* A new run was posted, or the helpers must exit */
+    QemuCond work_cond;
+    /* The last helper working on the current run finished */
+    QemuCond done_cond;
+    RAMWorkFn *fn;
+    void *opaque;
+    unsigned int generation;
+    unsigned int busy;
+    QemuThread *threads;
+    int nthreads;
+    bool exiting;
+} RAMWorkerPool;
+
+static void *ram_worker_pool_thread(void *opaque)
+{
+    RAMWorkerPool *pool = opaque;
+    unsigned int seen = 0;
+    RAMWorkFn *fn;
+    void *arg;
+
+    qemu_mutex_lock(&pool->lock);
+    while (!pool->exiting) {
+        if (!pool->fn || pool->generation == seen) {
+            qemu_cond_wait(&pool->work_cond, &pool->lock);
+            continue;
+        }
+        seen = pool->generation;
+        fn = pool->fn;
+        arg = pool->opaque;
+        pool->busy++;
+        qemu_mutex_unlock(&pool->lock);
+
+        fn(arg);
+
+        qemu_mutex_lock(&pool->lock);
+        if (!--pool->busy) {
+            qemu_cond_signal(&pool->done_cond);
+        }
+    }
+    qemu_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/* Start @nthreads helpers; with none, ram_worker_pool_run() runs inline */
+static void ram_worker_pool_init(RAMWorkerPool *pool, const char *name,
+                                 int nthreads)
+{
+    int i;
+
+    memset(pool, 0, sizeof(*pool));
+    if (nthreads <= 0) {
+        return;
+    }
+
+    qemu_mutex_init(&pool->lock);
+    qemu_cond_init(&pool->work_cond);
+    qemu_cond_init(&pool->done_cond);
+    pool->nthreads = nthreads;
+    pool->threads = g_new(QemuThread, nthreads);
+    for (i = 0; i < nthreads; i++) {
+        qemu_thread_create(&pool->threads[i], name, ram_worker_pool_thread,
+                           pool, QEMU_THREAD_JOINABLE);
+    }
+}
+
+static void ram_worker_pool_destroy(RAMWorkerPool *pool)
+{
+    int i;
+
+    if (!pool->threads) {
+        return;
+    }
+
+    qemu_mutex_lock(&pool->lock);
+    pool->exiting = true;
+    qemu_cond_broadcast(&pool->work_cond);
+    qemu_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->nthreads; i++) {
+        qemu_thread_join(&pool->threads[i]);
+    }
+    g_free(pool->threads);
+    pool->threads = NULL;
+
+    qemu_cond_destroy(&pool->done_cond);
+    qemu_cond_destroy(&pool->work_cond);
+    qemu_mutex_destroy(&pool->lock);
+}
+
+/*
+ * Run @fn(@opaque) in the calling thread and in every idle helper, and
+ * return once all of them are done.  @fn must cope with being called
+ * any number of times concurrently.  Returns the number of threads that
+ * could have taken part.
+ */
+static int ram_worker_pool_run(RAMWorkerPool *pool, RAMWorkFn *fn,
+                               void *opaque)
+{
+    if (!pool->threads) {
+        fn(opaque);
+        return 1;
+    }
+
+    qemu_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->opaque = opaque;
+    pool->generation++;
+    qemu_cond_broadcast(&pool->work_cond);
+    qemu_mutex_unlock(&pool->lock);
+
+    fn(opaque);
+
+    qemu_mutex_lock(&pool->lock);
+    pool->fn = NULL;
+    while (pool->busy) {
+        qemu_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    qemu_mutex_unlock(&pool->lock);
+
+    return pool->nthreads + 1;
+}
+
+/*
+ * Dirty extents
+ *
+ * With the dirty-extents capability, the source sends a run-length encoded
+ * copy of the dirty bitmap of each RAMBlock after each bitmap sync, ahead of
+ * the pages themselves.  The bitmap is scanned a word at a time and each
+ * run of words with at least one dirty page becomes an extent; this bounds
+ * the size of the record, at the cost of a little over-population on the
+ * destination.  Large blocks are scanned in shards by multifd-channels
+ * threads.
+ *
+ * The destination hands the extents to prefault threads, which populate
+ * the pages that have not been received yet so that the page copy does not
+ * fault one page at a time.
+ */
+#define DIRTY_EXTENTS_SHARD_WORDS   (1UL << 16)
+
+typedef struct DirtyExtent {
+    uint64_t start;
+    uint64_t npages;
+} DirtyExtent;
+
+typedef struct DirtyExtentsScan {
+    const unsigned long *bmap;
+    unsigned long num_pages;
+    unsigned int nshards;
+    unsigned int next_shard;
+    GArray **shards;
+} DirtyExtentsScan;
+
+static void dirty_extents_scan_shard(DirtyExtentsScan *s, unsigned int shard)
+{
+    unsigned long page = (unsigned long)shard * DIRTY_EXTENTS_SHARD_WORDS *
+                         BITS_PER_LONG;
+    unsigned long end = MIN(page + DIRTY_EXTENTS_SHARD_WORDS * BITS_PER_LONG,
+                            s->num_pages);
+    GArray *extents = s->shards[shard];
+
+    while ((page = find_next_bit(s->bmap, end, page)) < end) {
+        unsigned long word = BIT_WORD(page);
+        DirtyExtent e;
+
+        do {
+            word++;
+        } while (word * BITS_PER_LONG < end && s->bmap[word]);
+
+        e.start = BIT_WORD(page) * BITS_PER_LONG;
+        e.npages = MIN(word * BITS_PER_LONG, end) - e.start;
+        g_array_append_val(extents, e);
+        page = word * BITS_PER_LONG;
+    }
+}
+
+static void dirty_extents_scan_work(void *opaque)
+{
+    DirtyExtentsScan *s = opaque;
+    unsigned int shard;
+
+    while ((shard = qatomic_fetch_inc(&s->next_shard)) < s->nshards) {
+        dirty_extents_scan_shard(s, shard);
+    }
+}
+
+/*
+ * Helpers for dirty_extents_scan(), started once per outgoing migration
+ * by ram_save_setup() and destroyed by ram_save_cleanup().
+ */
+static RAMWorkerPool dirty_extents_pool;
+
+/* Called with bitmap_mutex held and within an RCU critical section */
+static GArray *dirty_extents_scan(RAMBlock *block)
+{
+    unsigned long shard_pages = DIRTY_EXTENTS_SHARD_WORDS * BITS_PER_LONG;
+    DirtyExtentsScan s = {
+        .bmap = block->bmap,
+        .num_pages = block->used_length >> TARGET_PAGE_BITS,
+    };
+    GArray *extents = g_array_new(false, false, sizeof(DirtyExtent));
+    unsigned int i, j;
+
+    s.nshards = DIV_ROUND_UP(s.num_pages, shard_pages);
+    s.shards = g_new(GArray *, s.nshards);
+    for (i = 0; i < s.nshards; i++) {
+        s.shards[i] = g_array_new(false, false, sizeof(DirtyExtent));
+    }
+
+    if (s.nshards > 1) {
+        /* Helpers pick up shards until none are left */
+        ram_worker_pool_run(&dirty_extents_pool, dirty_extents_scan_work, &s);
+    } else {
+        dirty_extents_scan_work(&s);
+    }
+
+    /* Concatenate the shards, merging runs that cross a shard boundary */
+    for (i = 0; i < s.nshards; i++) {
+        for (j = 0; j < s.shards[i]->len; j++) {
+            DirtyExtent *e = &g_array_index(s.shards[i], DirtyExtent, j);
+            DirtyExtent *last = extents->len ?
+                &g_array_index(extents, DirtyExtent, extents->len - 1) : NULL;
+
+            if (last && last->start + last->npages == e->start) {
+                last->npages += e->npages;
+            } else {
+                g_array_append_val(extents, *e);
+            }
+        }
+        g_array_free(s.shards[i], true);
+    }
+    g_free(s.shards);
+
+    return extents;
+}
+
+/* Called with bitmap_mutex held and within an RCU critical section */
+static void ram_save_dirty_extents(RAMState *rs, QEMUFile *f)
+{
+    RAMBlock *block;
+
+    RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+        GArray *extents = dirty_extents_scan(block);
+        size_t size;
+        guint i;
+
+        if (extents->len) {
+            size = save_page_header(&rs->pss[RAM_CHANNEL_PRECOPY], f, block,
+                                    RAM_SAVE_FLAG_DIRTY_EXTENTS);
+            qemu_put_be32(f, extents->len);
+            for (i = 0; i < extents->len; i++) {
+                DirtyExtent *e = &g_array_index(extents, DirtyExtent, i);
+
+                qemu_put_be64(f, e->start);
+                qemu_put_be64(f, e->npages);
+            }
+            size += 4 + extents->len * 2 * 8;
+            ram_transferred_add(size);
+        }
+        trace_ram_save_dirty_extents(block->idstr, extents->len);
+        g_array_free(extents, true);
+    }
+}
+
 static void migration_bitmap_sync(RAMState *rs, bool last_stage)
 {
     RAMBlock *block;
@@ -2467,6 +2757,7 @@ static void ram_save_cleanup(void *opaque)
 
     xbzrle_cleanup();
     compress_threads_save_cleanup();
+    ram_worker_pool_destroy(&dirty_extents_pool);
     ram_state_cleanup(rsp);
     g_free(migration_ops);
     migration_ops = NULL;
@@ -3134,6 +3425,12 @@ static int ram_save_setup(QEMUFile *f, void *opaque)
         migration_ops->ram_save_target_page = ram_save_target_page_legacy;
     }
 
+    if (migrate_dirty_extents()) {
+        /* The migration thread itself scans too */
+        ram_worker_pool_init(&dirty_extents_pool, "mig/dirty-scan",
+                             migrate_multifd_channels() - 1);
+    }
+
     bql_unlock();
     ret = multifd_send_sync_main();
     bql_lock();
@@ -3181,6 +3478,274 @@ void ramblock_set_file_bmap_atomic(RAMBlock *block, ram_addr_t offset, bool set)
     }
 }
 
+/*
+ * Bulk mapped-ram transfer for snapshots
+ *
+ * savevm/loadvm (and the snapshot-save/snapshot-load jobs) run with the VM
+ * stopped and the stream going to the VM state area of a block device.
+ * There is no point in walking the dirty bitmap one page at a time in that
+ * case.  Instead, each RAMBlock is split in chunks of
+ * MAPPED_RAM_BULK_CHUNK_SIZE that are claimed by multifd-channels
+ * coroutines.  Zero page detection runs in the thread pool, and each run of
+ * contiguous non-zero pages is written with a single request.  Zero pages
+ * are left as holes, which the VM state area reads back as zeroes.
+ *
+ * Loading mirrors this, and additionally clears the pages that are not in
+ * the file because the VM may have run since the snapshot was taken.
+ */
+typedef struct MappedRamBulk {
+    RAMState *rs;               /* NULL when loading */
+    QIOChannel *ioc;
+    RAMBlock *block;
+    unsigned long *file_bmap;   /* pages present in the file when loading */
+    unsigned long num_pages;
+    unsigned long next_page;
+    unsigned int in_flight;
+    Error *err;
+} MappedRamBulk;
+
+typedef struct MappedRamChunk {
+    uint8_t *host;
+    unsigned long npages;
+    /* pages to transfer; zero pages are moved to @zero when saving */
+    unsigned long *pages;
+    unsigned long *zero;
+} MappedRamChunk;
+
+static bool mapped_ram_bulk_enabled(QEMUFile *f)
+{
+    return migrate_mapped_ram() && !migrate_multifd() &&
+           object_dynamic_cast(OBJECT(qemu_file_get_ioc(f)),
+                               TYPE_QIO_CHANNEL_BLOCK);
+}
+
+static unsigned long mapped_ram_bulk_chunk_pages(void)
+{
+    return MAPPED_RAM_BULK_CHUNK_SIZE >> TARGET_PAGE_BITS;
+}
+
+/* Claim the next chunk of the block, returns false when there is none */
+static bool mapped_ram_bulk_claim(MappedRamBulk *b, MappedRamChunk *c,
+                                  unsigned long *start)
+{
+    if (b->err || b->next_page >= b->num_pages) {
+        return false;
+    }
+
+    *start = b->next_page;
+    c->npages = MIN(mapped_ram_bulk_chunk_pages(), b->num_pages - *start);
+    c->host = b->block->host + ((ram_addr_t)*start << TARGET_PAGE_BITS);
+    b->next_page += c->npages;
+    return true;
+}
+
+static void mapped_ram_bulk_set_error(MappedRamBulk *b, Error *err)
+{
+    if (b->err) {
+        error_free(err);
+    } else {
+        b->err = err;
+    }
+}
+
+/* Runs in the thread pool */
+static int mapped_ram_bulk_find_zero(void *opaque)
+{
+    MappedRamChunk *c = opaque;
+    unsigned long i;
+
+    for (i = find_first_bit(c->pages, c->npages); i < c->npages;
+         i = find_next_bit(c->pages, c->npages, i + 1)) {
+        if (buffer_is_zero(c->host + ((ram_addr_t)i << TARGET_PAGE_BITS),
+                           TARGET_PAGE_SIZE)) {
+            clear_bit(i, c->pages);
+            set_bit(i, c->zero);
+        }
+    }
+    return 0;
+}
+
+/* Runs in the thread pool */
+static int mapped_ram_bulk_clear_absent(void *opaque)
+{
+    MappedRamChunk *c = opaque;
+    unsigned long i;
+
+    for (i = find_first_bit(c->zero, c->npages); i < c->npages;
+         i = find_next_bit(c->zero, c->npages, i + 1)) {
+        uint8_t *host = c->host + ((ram_addr_t)i << TARGET_PAGE_BITS);
+
+        /* Avoid dirtying (and allocating) pages that are already zero */
+        if (!buffer_is_zero(host, TARGET_PAGE_SIZE)) {
+            memset(host, 0, TARGET_PAGE_SIZE);
+        }
+    }
+    return 0;
+}
+
+static void coroutine_fn mapped_ram_bulk_save_co(void *opaque)
+{
+    MappedRamBulk *b = opaque;
+    RAMBlock *block = b->block;
+    unsigned long chunk_pages = mapped_ram_bulk_chunk_pages();
+    MappedRamChunk c = {
+        .pages = bitmap_new(chunk_pages),
+        .zero = bitmap_new(chunk_pages),
+    };
+    unsigned long start, end, page, i, j;
+
+    while (mapped_ram_bulk_claim(b, &c, &start)) {
+        end = start + c.npages;
+        bitmap_zero(c.pages, chunk_pages);
+        bitmap_zero(c.zero, chunk_pages);
+
+        qemu_mutex_lock(&b->rs->bitmap_mutex);
+        for (page = find_next_bit(block->bmap, end, start); page < end;
+             page = find_next_bit(block->bmap, end, page + 1)) {
+            if (migration_bitmap_clear_dirty(b->rs, block, page)) {
+                set_bit(page - start, c.pages);
+            }
+        }
+        qemu_mutex_unlock(&b->rs->bitmap_mutex);
+
+        if (bitmap_empty(c.pages, c.npages)) {
+            continue;
+        }
+
+        if (migrate_zero_page_detection() != ZERO_PAGE_DETECTION_NONE) {
+            thread_pool_submit_co(mapped_ram_bulk_find_zero, &c);
+        }
+
+        for (i = find_first_bit(c.zero, c.npages); i < c.npages;
+             i = find_next_bit(c.zero, c.npages, i + 1)) {
+            clear_bit(start + i, block->file_bmap);
+            stat64_add(&mig_stats.zero_pages, 1);
+        }
+
+        for (i = find_first_bit(c.pages, c.npages); i < c.npages;
+             i = find_next_bit(c.pages, c.npages, j + 1)) {
+            Error *local_err = NULL;
+            struct iovec iov;
+
+            j = find_next_zero_bit(c.pages, c.npages, i + 1);
+            iov.iov_base = c.host + ((ram_addr_t)i << TARGET_PAGE_BITS);
+            iov.iov_len = (ram_addr_t)(j - i) << TARGET_PAGE_BITS;
+
+            if (qio_channel_pwritev(b->ioc, &iov, 1,
+                                    block->pages_offset +
+                                    ((ram_addr_t)(start + i) <<
+                                     TARGET_PAGE_BITS),
+                                    &local_err) < 0) {
+                mapped_ram_bulk_set_error(b, local_err);
+                break;
+            }
+
+            bitmap_set(block->file_bmap, start + i, j - i);
+            stat64_add(&mig_stats.normal_pages, j - i);
+            ram_transferred_add(iov.iov_len);
+        }
+    }
+
+    g_free(c.pages);
+    g_free(c.zero);
+    b->in_flight--;
+    aio_wait_kick();
+}
+
+static void coroutine_fn mapped_ram_bulk_load_co(void *opaque)
+{
+    MappedRamBulk *b = opaque;
+    RAMBlock *block = b->block;
+    unsigned long chunk_pages = mapped_ram_bulk_chunk_pages();
+    MappedRamChunk c = {
+        .pages = bitmap_new(chunk_pages),
+        .zero = bitmap_new(chunk_pages),
+    };
+    unsigned long start, i, j;
+
+    while (mapped_ram_bulk_claim(b, &c, &start)) {
+        bitmap_zero(c.pages, chunk_pages);
+        bitmap_zero(c.zero, chunk_pages);
+        for (i = 0; i < c.npages; i++) {
+            set_bit(i, test_bit(start + i, b->file_bmap) ? c.pages : c.zero);
+        }
+
+        if (!bitmap_empty(c.zero, c.npages)) {
+            thread_pool_submit_co(mapped_ram_bulk_clear_absent, &c);
+        }
+
+        for (i = find_first_bit(c.pages, c.npages); i < c.npages;
+             i = find_next_bit(c.pages, c.npages, j + 1)) {
+            Error *local_err = NULL;
+            struct iovec iov;
+
+            j = find_next_zero_bit(c.pages, c.npages, i + 1);
+            iov.iov_base = c.host + ((ram_addr_t)i << TARGET_PAGE_BITS);
+            iov.iov_len = (ram_addr_t)(j - i) << TARGET_PAGE_BITS;
+
+            if (qio_channel_preadv(b->ioc, &iov, 1,
+                                   block->pages_offset +
+                                   ((ram_addr_t)(start + i) <<
+                                    TARGET_PAGE_BITS),
+                                   &local_err) < 0) {
+                mapped_ram_bulk_set_error(b, local_err);
+                break;
+            }
+        }
+    }
+
+    g_free(c.pages);
+    g_free(c.zero);
+    b->in_flight--;
+    aio_wait_kick();
+}
+
+/*
+ * Start the worker coroutines for @b and wait for them.  Called from the
+ * main loop outside of coroutine context with the VM stopped.
+ */
+static bool mapped_ram_bulk_run(MappedRamBulk *b, CoroutineEntry *entry,
+                                Error **errp)
+{
+    int i, n = migrate_multifd_channels();
+
+    assert(!qemu_in_coroutine());
+
+    b->in_flight = n;
+    for (i = 0; i < n; i++) {
+        qemu_coroutine_enter(qemu_coroutine_create(entry, b));
+    }
+    AIO_WAIT_WHILE_UNLOCKED(NULL, b->in_flight > 0);
+
+    if (b->err) {
+        error_propagate(errp, b->err);
+        return false;
+    }
+    return true;
+}
+
+static int mapped_ram_bulk_save(RAMState *rs, QEMUFile *f)
+{
+    RAMBlock *block;
+
+    RAMBLOCK_FOREACH_MIGRATABLE(block) {
+        MappedRamBulk b = {
+            .rs = rs,
+            .ioc = qemu_file_get_ioc(f),
+            .block = block,
+            .num_pages = block->used_length >> TARGET_PAGE_BITS,
+        };
+        Error *local_err = NULL;
+
+        trace_mapped_ram_bulk_save(block->idstr, b.num_pages);
+        if (!mapped_ram_bulk_run(&b, mapped_ram_bulk_save_co, &local_err)) {
+            qemu_file_set_error_obj(f, -EIO, local_err);
+            return -EIO;
+        }
+    }
+    return 0;
+}
+
 /**
  * ram_save_iterate: iterative stage for migration
  *
@@ -3205,6 +3770,12 @@ static int ram_save_iterate(QEMUFile *f, void *opaque)
         goto out;
     }
 
+    if (mapped_ram_bulk_enabled(f)) {
+        /* The VM is stopped, ram_save_complete() writes everything at once */
+        done = 1;
+        goto out;
+    }
+
     /*
      * We'll take this lock a little bit long, but it's okay for two reasons.
      * Firstly, the only possible other thread to take it is who calls
@@ -3227,6 +3798,14 @@ static int ram_save_iterate(QEMUFile *f, void *opaque)
                 goto out;
             }
 
+            if (migrate_dirty_extents() &&
+                rs->dirty_extents_sync !=
+                stat64_get(&mig_stats.dirty_sync_count)) {
+                rs->dirty_extents_sync =
+                    stat64_get(&mig_stats.dirty_sync_count);
+                ram_save_dirty_extents(rs, f);
+            }
+
             t0 = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
             i = 0;
             while ((ret = migration_rate_exceeded(f)) == 0 ||
@@ -3340,22 +3919,29 @@ static int ram_save_complete(QEMUFile *f, void *opaque)
 
         /* try transferring iterative blocks of memory */
 
-        /* flush all remaining blocks regardless of rate limiting */
-        qemu_mutex_lock(&rs->bitmap_mutex);
-        while (true) {
-            int pages;
-
-            pages = ram_find_and_save_block(rs);
-            /* no more blocks to sent */
-            if (pages == 0) {
-                break;
+        if (mapped_ram_bulk_enabled(f)) {
+            ret = mapped_ram_bulk_save(rs, f);
+            if (ret < 0) {
+                return ret;
             }
-            if (pages < 0) {
-                qemu_mutex_unlock(&rs->bitmap_mutex);
-                return pages;
+        } else {
+            /* flush all remaining blocks regardless of rate limiting */
+            qemu_mutex_lock(&rs->bitmap_mutex);
+            while (true) {
+                int pages;
+
+                pages = ram_find_and_save_block(rs);
+                /* no more blocks to sent */
+                if (pages == 0) {
+                    break;
+                }
+                if (pages < 0) {
+                    qemu_mutex_unlock(&rs->bitmap_mutex);
+                    return pages;
+                }
             }
+            qemu_mutex_unlock(&rs->bitmap_mutex);
         }
-        qemu_mutex_unlock(&rs->bitmap_mutex);
 
         compress_flush_data();
 
@@ -3595,6 +4181,45 @@ static void colo_init_ram_state(void)
     ram_state_init(&ram_state);
 }
 
+/*
+ * Flushing the COLO cache is a memcpy of every page dirtied by the last
+ * checkpoint and runs with both VMs stopped.  When there is enough to copy,
+ * split it between as many threads as there are multifd channels.
+ */
+#define COLO_FLUSH_EXTENT_SIZE      (2 * MiB)
+#define COLO_FLUSH_PARALLEL_MIN     (16 * MiB)
+
+typedef struct ColoFlushExtent {
+    RAMBlock *block;
+    ram_addr_t offset;
+    ram_addr_t len;
+} ColoFlushExtent;
+
+typedef struct ColoFlushState {
+    GArray *extents;
+    unsigned int next;
+} ColoFlushState;
+
+static void colo_flush_extents(void *opaque)
+{
+    ColoFlushState *fs = opaque;
+    unsigned int i;
+
+    while ((i = qatomic_fetch_inc(&fs->next)) < fs->extents->len) {
+        ColoFlushExtent *e = &g_array_index(fs->extents, ColoFlushExtent, i);
+
+        memcpy(e->block->host + e->offset, e->block->colo_cache + e->offset,
+               e->len);
+    }
+}
+
+/*
+ * Helpers for colo_flush_ram_cache(), started by colo_init_ram_cache()
+ * and destroyed by colo_release_ram_cache(), so that they live as long
+ * as the COLO session.
+ */
+static RAMWorkerPool colo_flush_pool;
+
 /*
  * colo cache: this is for secondary VM, we cache the whole
  * memory of the secondary VM, it is need to hold the global lock
@@ -3640,6 +4265,10 @@ int colo_init_ram_cache(void)
     }
 
     colo_init_ram_state();
+    /* The COLO incoming thread itself flushes too */
+    ram_worker_pool_init(&colo_flush_pool, "colo flush",
+                         migrate_multifd() ?
+                         migrate_multifd_channels() - 1 : 0);
     return 0;
 }
 
@@ -3670,6 +4299,7 @@ void colo_release_ram_cache(void)
 {
     RAMBlock *block;
 
+    ram_worker_pool_destroy(&colo_flush_pool);
     memory_global_dirty_log_stop(GLOBAL_DIRTY_MIGRATION);
     RAMBLOCK_FOREACH_NOT_IGNORED(block) {
         g_free(block->bmap);
@@ -3687,6 +4317,187 @@ void colo_release_ram_cache(void)
     ram_state_cleanup(&ram_state);
 }
 
+/*
+ * Prefault threads, fed by the dirty extents received from the source.
+ * Protected by ram_prefault.lock.
+ */
+#define RAM_PREFAULT_CHUNK_SIZE     (64 * MiB)
+
+typedef struct RAMPrefaultExtent {
+    RAMBlock *block;
+    unsigned long start;
+    unsigned long npages;
+} RAMPrefaultExtent;
+
+static struct {
+    QemuMutex lock;
+    QemuCond cond;
+    GQueue queue;
+    QemuThread *threads;
+    int nthreads;
+    bool exiting;
+    /* MADV_POPULATE_WRITE is not available, ignore further extents */
+    bool failed;
+} ram_prefault;
+
+static void ram_prefault_extent(RAMPrefaultExtent *e)
+{
+    RAMBlock *rb = e->block;
+    unsigned long page = e->start, end = e->start + e->npages, next;
+    ram_addr_t start, len;
+
+    /* Pages that were already received do not need to be populated */
+    while ((page = find_next_zero_bit(rb->receivedmap, end, page)) < end) {
+        next = find_next_bit(rb->receivedmap, end, page + 1);
+        start = QEMU_ALIGN_DOWN((ram_addr_t)page << TARGET_PAGE_BITS,
+                                rb->page_size);
+        len = MIN(QEMU_ALIGN_UP((ram_addr_t)next << TARGET_PAGE_BITS,
+                                rb->page_size), rb->used_length) - start;
+
+        if (qemu_madvise(rb->host + start, len, QEMU_MADV_POPULATE_WRITE)) {
+            trace_ram_prefault_failed(rb->idstr, start, len, errno);
+            qatomic_set(&ram_prefault.failed, true);
+            return;
+        }
+        page = next;
+    }
+}
+
+static void *ram_prefault_thread(void *opaque)
+{
+    RAMPrefaultExtent *e;
+
+    rcu_register_thread();
+
+    qemu_mutex_lock(&ram_prefault.lock);
+    while (!ram_prefault.exiting) {
+        e = g_queue_pop_head(&ram_prefault.queue);
+        if (!e) {
+            qemu_cond_wait(&ram_prefault.cond, &ram_prefault.lock);
+            continue;
+        }
+        qemu_mutex_unlock(&ram_prefault.lock);
+
+        if (!qatomic_read(&ram_prefault.failed)) {
+            WITH_RCU_READ_LOCK_GUARD() {
+                ram_prefault_extent(e);
+            }
+        }
+        g_free(e);
+
+        qemu_mutex_lock(&ram_prefault.lock);
+    }
+    qemu_mutex_unlock(&ram_prefault.lock);
+
+    rcu_unregister_thread();
+    return NULL;
+}
+
+/*
+ * Start the prefault threads.  They serve every dirty bitmap sync of the
+ * incoming migration, and are only joined by ram_load_cleanup().
+ */
+static void ram_prefault_setup(void)
+{
+    int i;
+
+    qemu_mutex_init(&ram_prefault.lock);
+    qemu_cond_init(&ram_prefault.cond);
+    g_queue_init(&ram_prefault.queue);
+    ram_prefault.exiting = false;
+    ram_prefault.failed = false;
+    ram_prefault.nthreads = migrate_multifd_channels();
+    ram_prefault.threads = g_new(QemuThread, ram_prefault.nthreads);
+    for (i = 0; i < ram_prefault.nthreads; i++) {
+        qemu_thread_create(&ram_prefault.threads[i], "mig/dst/prefault",
+                           ram_prefault_thread, NULL, QEMU_THREAD_JOINABLE);
+    }
+}
+
+static void ram_prefault_queue(RAMBlock *block, unsigned long start,
+                               unsigned long npages)
+{
+    unsigned long chunk = RAM_PREFAULT_CHUNK_SIZE >> TARGET_PAGE_BITS;
+
+    qemu_mutex_lock(&ram_prefault.lock);
+    while (npages) {
+        RAMPrefaultExtent *e = g_new(RAMPrefaultExtent, 1);
+
+        e->block = block;
+        e->start = start;
+        e->npages = MIN(npages, chunk);
+        g_queue_push_tail(&ram_prefault.queue, e);
+        start += e->npages;
+        npages -= e->npages;
+    }
+    qemu_cond_broadcast(&ram_prefault.cond);
+    qemu_mutex_unlock(&ram_prefault.lock);
+}
+
+static void ram_prefault_cleanup(void)
+{
+    int i;
+
+    if (!ram_prefault.threads) {
+        return;
+    }
+
+    qemu_mutex_lock(&ram_prefault.lock);
+    ram_prefault.exiting = true;
+    qemu_cond_broadcast(&ram_prefault.cond);
+    qemu_mutex_unlock(&ram_prefault.lock);
+
+    for (i = 0; i < ram_prefault.nthreads; i++) {
+        qemu_thread_join(&ram_prefault.threads[i]);
+    }
+    g_free(ram_prefault.threads);
+    ram_prefault.threads = NULL;
+
+    g_queue_clear_full(&ram_prefault.queue, g_free);
+    qemu_cond_destroy(&ram_prefault.cond);
+    qemu_mutex_destroy(&ram_prefault.lock);
+    ram_prefault.failed = false;
+}
+
+/**
+ * ram_load_dirty_extents: load the dirty extents of a RAMBlock
+ *
+ * Returns 0 for success or a negative error code
+ *
+ * @f: QEMUFile where to receive the data
+ * @block: RAMBlock the extents describe
+ */
+static int ram_load_dirty_extents(QEMUFile *f, RAMBlock *block)
+{
+    unsigned long num_pages;
+    uint64_t start, npages;
+    uint32_t i, count;
+
+    if (!block) {
+        return -EINVAL;
+    }
+
+    num_pages = block->used_length >> TARGET_PAGE_BITS;
+    count = qemu_get_be32(f);
+    trace_ram_load_dirty_extents(block->idstr, count);
+
+    for (i = 0; i < count; i++) {
+        start = qemu_get_be64(f);
+        npages = qemu_get_be64(f);
+        if (start > num_pages || npages > num_pages - start) {
+            error_report("Dirty extent 0x%" PRIx64 "+0x%" PRIx64
+                         " outside of ramblock %s", start, npages,
+                         block->idstr);
+            return -EINVAL;
+        }
+        if (!qatomic_read(&ram_prefault.failed)) {
+            ram_prefault_queue(block, start, npages);
+        }
+    }
+
+    return qemu_file_get_error(f);
+}
+
 /**
  * ram_load_setup: Setup RAM for migration incoming side
  *
@@ -3699,6 +4510,9 @@ static int ram_load_setup(QEMUFile *f, void *opaque)
 {
     xbzrle_load_setup();
     ramblock_recv_map_init();
+    if (migrate_dirty_extents()) {
+        ram_prefault_setup();
+    }
 
     return 0;
 }
@@ -3712,6 +4526,7 @@ static int ram_load_cleanup(void *opaque)
     }
 
     xbzrle_load_cleanup();
+    ram_prefault_cleanup();
 
     RAMBLOCK_FOREACH_NOT_IGNORED(rb) {
         g_free(rb->receivedmap);
@@ -3937,12 +4752,15 @@ static bool postcopy_is_running(void)
  * Flush content of RAM cache into SVM's memory.
  * Only flush the pages that be dirtied by PVM or SVM or both.
  */
-void colo_flush_ram_cache(void)
+uint64_t colo_flush_ram_cache(void)
 {
     RAMBlock *block = NULL;
-    void *dst_host;
-    void *src_host;
+    ColoFlushState fs = {
+        .extents = g_array_new(false, false, sizeof(ColoFlushExtent)),
+    };
     unsigned long offset = 0;
+    uint64_t dirty_pages;
+    int nthreads = 1;
 
     memory_global_dirty_log_sync(false);
     qemu_mutex_lock(&ram_state->bitmap_mutex);
@@ -3952,7 +4770,8 @@ void colo_flush_ram_cache(void)
         }
     }
 
-    trace_colo_flush_ram_cache_begin(ram_state->migration_dirty_pages);
+    dirty_pages = ram_state->migration_dirty_pages;
+    trace_colo_flush_ram_cache_begin(dirty_pages);
     WITH_RCU_READ_LOCK_GUARD() {
         block = QLIST_FIRST_RCU(&ram_list.blocks);
 
@@ -3966,22 +4785,40 @@ void colo_flush_ram_cache(void)
                 num = 0;
                 block = QLIST_NEXT_RCU(block, next);
             } else {
+                ram_addr_t start = ((ram_addr_t)offset) << TARGET_PAGE_BITS;
+                ram_addr_t end = start + ((ram_addr_t)num << TARGET_PAGE_BITS);
                 unsigned long i = 0;
 
                 for (i = 0; i < num; i++) {
                     migration_bitmap_clear_dirty(ram_state, block, offset + i);
                 }
-                dst_host = block->host
-                         + (((ram_addr_t)offset) << TARGET_PAGE_BITS);
-                src_host = block->colo_cache
-                         + (((ram_addr_t)offset) << TARGET_PAGE_BITS);
-                memcpy(dst_host, src_host, TARGET_PAGE_SIZE * num);
+                while (start < end) {
+                    ColoFlushExtent e = {
+                        .block = block,
+                        .offset = start,
+                        .len = MIN(end - start, COLO_FLUSH_EXTENT_SIZE),
+                    };
+
+                    g_array_append_val(fs.extents, e);
+                    start += e.len;
+                }
                 offset += num;
             }
         }
+
+        if (fs.extents->len > 1 &&
+            (dirty_pages << TARGET_PAGE_BITS) >= COLO_FLUSH_PARALLEL_MIN) {
+            nthreads = ram_worker_pool_run(&colo_flush_pool,
+                                           colo_flush_extents, &fs);
+        } else {
+            colo_flush_extents(&fs);
+        }
     }
     qemu_mutex_unlock(&ram_state->bitmap_mutex);
-    trace_colo_flush_ram_cache_end();
+    g_array_free(fs.extents, true);
+    trace_colo_flush_ram_cache_end(nthreads);
+
+    return dirty_pages;
 }
 
 static size_t ram_load_multifd_pages(void *host_addr, size_t size,
@@ -4010,6 +4847,28 @@ static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
     void *host;
     size_t read, unread, size;
 
+    if (mapped_ram_bulk_enabled(f)) {
+        MappedRamBulk b = {
+            .ioc = qemu_file_get_ioc(f),
+            .block = block,
+            .file_bmap = bitmap,
+            .num_pages = num_pages,
+        };
+
+        if (num_pages > (block->used_length >> TARGET_PAGE_BITS)) {
+            error_setg(errp, "page outside of ramblock %s range",
+                       block->idstr);
+            return false;
+        }
+
+        trace_mapped_ram_bulk_load(block->idstr, num_pages);
+        if (!mapped_ram_bulk_run(&b, mapped_ram_bulk_load_co, errp)) {
+            error_prepend(errp, "(%s) failed to read pages: ", block->idstr);
+            return false;
+        }
+        return true;
+    }
+
     for (set_bit_idx = find_first_bit(bitmap, num_pages);
          set_bit_idx < num_pages;
          set_bit_idx = find_next_bit(bitmap, num_pages, clear_bit_idx + 1)) {
@@ -4223,6 +5082,10 @@ static int ram_load_precopy(QEMUFile *f)
                           RAM_SAVE_FLAG_ZERO);
     }
 
+    if (!migrate_dirty_extents()) {
+        invalid_flags |= RAM_SAVE_FLAG_DIRTY_EXTENTS;
+    }
+
     while (!ret && !(flags & RAM_SAVE_FLAG_EOS)) {
         ram_addr_t addr;
         void *host = NULL, *host_bak = NULL;
@@ -4363,6 +5226,11 @@ static int ram_load_precopy(QEMUFile *f)
                 multifd_recv_sync_main();
             }
             break;
+        case RAM_SAVE_FLAG_DIRTY_EXTENTS:
+            ret = ram_load_dirty_extents(f,
+                                         ram_block_from_stream(mis, f, flags,
+                                                       RAM_CHANNEL_PRECOPY));
+            break;
         case RAM_SAVE_FLAG_HOOK:
             ret = rdma_registration_handle(f);
             if (ret < 0) {
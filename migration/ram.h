@@ -80,7 +80,7 @@ void ramblock_set_file_bmap_atomic(RAMBlock *block, ram_addr_t offset,
 
 /* ram cache */
 int colo_init_ram_cache(void);
-void colo_flush_ram_cache(void);
+uint64_t colo_flush_ram_cache(void);
 void colo_release_ram_cache(void);
 void colo_incoming_start_dirty_log(void);
 void colo_record_bitmap(RAMBlock *block, ram_addr_t *normal, uint32_t pages);
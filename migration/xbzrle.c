@@ -15,9 +15,21 @@
 #include "qemu/host-utils.h"
 #include "xbzrle.h"
 
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define XBZRLE_NEON
+#endif
+
+#if defined(CONFIG_AVX512BW_OPT) || defined(XBZRLE_NEON) || \
+    defined(CONFIG_RVV_OPT)
+#include "host/cpuinfo.h"
+#define XBZRLE_ACCEL
+
+static int xbzrle_encode_buffer_int(uint8_t *old_buf, uint8_t *new_buf,
+                                    int slen, uint8_t *dst, int dlen);
+#endif
+
 #if defined(CONFIG_AVX512BW_OPT)
 #include <immintrin.h>
-#include "host/cpuinfo.h"
 
 static int __attribute__((target("avx512bw")))
 xbzrle_encode_buffer_avx512(uint8_t *old_buf, uint8_t *new_buf, int slen,
@@ -136,20 +148,191 @@ xbzrle_encode_buffer_avx512(uint8_t *old_buf, uint8_t *new_buf, int slen,
     }
     return d;
 }
+#endif /* CONFIG_AVX512BW_OPT */
 
-static int xbzrle_encode_buffer_int(uint8_t *old_buf, uint8_t *new_buf,
-                                    int slen, uint8_t *dst, int dlen);
+#if defined(XBZRLE_NEON) || defined(CONFIG_RVV_OPT)
+/*
+ * Encoders built from two vectorized scans: one returning the index of the
+ * first byte at or after @i that differs between the buffers, the other the
+ * index of the first byte that is equal.  Both return @slen if there is none.
+ */
+typedef int XBZRLEScanFn(const uint8_t *old_buf, const uint8_t *new_buf,
+                         int i, int slen);
+
+static int xbzrle_encode_runs(uint8_t *old_buf, uint8_t *new_buf, int slen,
+                              uint8_t *dst, int dlen,
+                              XBZRLEScanFn *next_diff, XBZRLEScanFn *next_same)
+{
+    int d = 0, i = 0, j;
+
+    while (i < slen) {
+        /* overflow */
+        if (d + 2 > dlen) {
+            return -1;
+        }
+
+        j = next_diff(old_buf, new_buf, i, slen);
+
+        /* buffer unchanged */
+        if (j - i == slen) {
+            return 0;
+        }
+
+        /* skip last zero run */
+        if (j == slen) {
+            return d;
+        }
+
+        d += uleb128_encode_small(dst + d, j - i);
+        i = j;
+
+        /* overflow */
+        if (d + 2 > dlen) {
+            return -1;
+        }
+
+        j = next_same(old_buf, new_buf, i, slen);
+        d += uleb128_encode_small(dst + d, j - i);
+
+        /* overflow */
+        if (d + (j - i) > dlen) {
+            return -1;
+        }
+        memcpy(dst + d, new_buf + i, j - i);
+        d += j - i;
+        i = j;
+    }
+
+    return d;
+}
+#endif
 
+#ifdef XBZRLE_NEON
+#include <arm_neon.h>
+
+/*
+ * Compress the 0x00/0xff result of a byte compare into a 64-bit mask with
+ * one nibble per byte, in memory order.
+ */
+static inline uint64_t xbzrle_neon_mask(uint8x16_t cmp)
+{
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+
+static int xbzrle_next_diff_neon(const uint8_t *old_buf,
+                                 const uint8_t *new_buf, int i, int slen)
+{
+    for (; i + 16 <= slen; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(old_buf + i), vld1q_u8(new_buf + i));
+        uint64_t mask = xbzrle_neon_mask(eq);
+
+        if (mask != UINT64_MAX) {
+            return i + ctz64(~mask) / 4;
+        }
+    }
+    while (i < slen && old_buf[i] == new_buf[i]) {
+        i++;
+    }
+    return i;
+}
+
+static int xbzrle_next_same_neon(const uint8_t *old_buf,
+                                 const uint8_t *new_buf, int i, int slen)
+{
+    for (; i + 16 <= slen; i += 16) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(old_buf + i), vld1q_u8(new_buf + i));
+        uint64_t mask = xbzrle_neon_mask(eq);
+
+        if (mask) {
+            return i + ctz64(mask) / 4;
+        }
+    }
+    while (i < slen && old_buf[i] != new_buf[i]) {
+        i++;
+    }
+    return i;
+}
+
+static int xbzrle_encode_buffer_neon(uint8_t *old_buf, uint8_t *new_buf,
+                                     int slen, uint8_t *dst, int dlen)
+{
+    return xbzrle_encode_runs(old_buf, new_buf, slen, dst, dlen,
+                              xbzrle_next_diff_neon, xbzrle_next_same_neon);
+}
+#endif /* XBZRLE_NEON */
+
+#ifdef CONFIG_RVV_OPT
+#include <riscv_vector.h>
+
+static int __attribute__((target("arch=+v")))
+xbzrle_next_diff_rvv(const uint8_t *old_buf, const uint8_t *new_buf,
+                     int i, int slen)
+{
+    while (i < slen) {
+        size_t vl = __riscv_vsetvl_e8m8(slen - i);
+        vuint8m8_t o = __riscv_vle8_v_u8m8(old_buf + i, vl);
+        vuint8m8_t n = __riscv_vle8_v_u8m8(new_buf + i, vl);
+        long first = __riscv_vfirst_m_b1(__riscv_vmsne_vv_u8m8_b1(o, n, vl),
+                                         vl);
+
+        if (first >= 0) {
+            return i + first;
+        }
+        i += vl;
+    }
+    return slen;
+}
+
+static int __attribute__((target("arch=+v")))
+xbzrle_next_same_rvv(const uint8_t *old_buf, const uint8_t *new_buf,
+                     int i, int slen)
+{
+    while (i < slen) {
+        size_t vl = __riscv_vsetvl_e8m8(slen - i);
+        vuint8m8_t o = __riscv_vle8_v_u8m8(old_buf + i, vl);
+        vuint8m8_t n = __riscv_vle8_v_u8m8(new_buf + i, vl);
+        long first = __riscv_vfirst_m_b1(__riscv_vmseq_vv_u8m8_b1(o, n, vl),
+                                         vl);
+
+        if (first >= 0) {
+            return i + first;
+        }
+        i += vl;
+    }
+    return slen;
+}
+
+static int xbzrle_encode_buffer_rvv(uint8_t *old_buf, uint8_t *new_buf,
+                                    int slen, uint8_t *dst, int dlen)
+{
+    return xbzrle_encode_runs(old_buf, new_buf, slen, dst, dlen,
+                              xbzrle_next_diff_rvv, xbzrle_next_same_rvv);
+}
+#endif /* CONFIG_RVV_OPT */
+
+#ifdef XBZRLE_ACCEL
 static int (*accel_func)(uint8_t *, uint8_t *, int, uint8_t *, int);
 
 static void __attribute__((constructor)) init_accel(void)
 {
     unsigned info = cpuinfo_init();
+
+    accel_func = xbzrle_encode_buffer_int;
+#if defined(CONFIG_AVX512BW_OPT)
     if (info & CPUINFO_AVX512BW) {
         accel_func = xbzrle_encode_buffer_avx512;
-    } else {
-        accel_func = xbzrle_encode_buffer_int;
     }
+#elif defined(XBZRLE_NEON)
+    if (info & CPUINFO_ASIMD) {
+        accel_func = xbzrle_encode_buffer_neon;
+    }
+#elif defined(CONFIG_RVV_OPT)
+    if (info & CPUINFO_RVV) {
+        accel_func = xbzrle_encode_buffer_rvv;
+    }
+#endif
 }
 
 int xbzrle_encode_buffer(uint8_t *old_buf, uint8_t *new_buf, int slen,
@@ -104,6 +104,7 @@ def close(self):
         self.file.close()
 
 class RamSection(object):
+    RAM_SAVE_FLAG_DIRTY_EXTENTS = 0x01
     RAM_SAVE_FLAG_COMPRESS = 0x02
     RAM_SAVE_FLAG_MEM_SIZE = 0x04
     RAM_SAVE_FLAG_PAGE     = 0x08
@@ -201,6 +202,15 @@ def read(self):
                     self.memory['%s (0x%016x)' % (self.name, addr)] = hexdata
 
                 flags &= ~self.RAM_SAVE_FLAG_PAGE
+            elif flags & self.RAM_SAVE_FLAG_DIRTY_EXTENTS:
+                if flags & self.RAM_SAVE_FLAG_CONTINUE:
+                    flags &= ~self.RAM_SAVE_FLAG_CONTINUE
+                else:
+                    self.name = self.file.readstr()
+                # Only a hint for the destination, skip the extents
+                count = self.file.read32()
+                self.file.file.seek(count * 16, 1)
+                flags &= ~self.RAM_SAVE_FLAG_DIRTY_EXTENTS
             elif flags & self.RAM_SAVE_FLAG_XBZRLE:
                 raise Exception("XBZRLE RAM compression is not supported yet")
             elif flags & self.RAM_SAVE_FLAG_HOOK:
@@ -77,6 +77,14 @@
 #define TARGET_SYS_ELAPSED     0x30
 #define TARGET_SYS_TICKFREQ    0x31
 
+/*
+ * 0x100-0x1ff are reserved for application use; QEMU specific
+ * operations live there.  Only the RISC-V boards implement them.
+ */
+#ifdef TARGET_RISCV
+#define TARGET_SYS_QEMU_CHECKPOINT 0x100
+#endif
+
 /* ADP_Stopped_ApplicationExit is used for exit(0),
  * anything else is implemented as exit(1) */
 #define ADP_Stopped_ApplicationExit     (0x20026)
@@ -776,6 +784,18 @@ void do_common_semihosting(CPUState *cs)
         common_semi_set_ret(cs, 1000000000);
         break;
 
+#ifdef TARGET_SYS_QEMU_CHECKPOINT
+    case TARGET_SYS_QEMU_CHECKPOINT:
+        /*
+         * Boot marker: let the board snapshot the machine. The board
+         * stops the VM before this vCPU executes anything else, so a
+         * restored guest resumes right after the call with the same
+         * return value.
+         */
+        common_semi_set_ret(cs, semihosting_checkpoint() ? 0 : -1);
+        break;
+#endif
+
     case TARGET_SYS_SYNCCACHE:
         /*
          * Clean the D-cache and invalidate the I-cache for the specified
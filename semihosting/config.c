@@ -62,6 +62,8 @@ typedef struct SemihostingConfig {
 
 static SemihostingConfig semihosting;
 static const char *semihost_chardev;
+static SemihostingCheckpointFn *semihost_checkpoint_fn;
+static void *semihost_checkpoint_opaque;
 
 bool semihosting_enabled(bool is_user)
 {
@@ -126,6 +128,24 @@ void semihosting_arg_fallback(const char *file, const char *cmd)
     }
 }
 
+void semihosting_set_checkpoint_handler(SemihostingCheckpointFn *fn,
+                                        void *opaque)
+{
+    semihost_checkpoint_fn = fn;
+    semihost_checkpoint_opaque = opaque;
+}
+
+bool semihosting_checkpoint(void)
+{
+    SemihostingCheckpointFn *fn = semihost_checkpoint_fn;
+
+    if (!fn) {
+        return false;
+    }
+    fn(semihost_checkpoint_opaque);
+    return true;
+}
+
 void qemu_semihosting_enable(void)
 {
     semihosting.enabled = true;
@@ -60,6 +60,11 @@ void semihosting_arg_fallback(const char *file, const char *cmd)
 {
 }
 
+void semihosting_set_checkpoint_handler(SemihostingCheckpointFn *fn,
+                                        void *opaque)
+{
+}
+
 void qemu_semihosting_chardev_init(void)
 {
 }
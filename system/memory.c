@@ -2548,6 +2548,16 @@ void memory_region_set_flush_coalesced(MemoryRegion *mr)
     mr->flush_coalesced_mmio = true;
 }
 
+void memory_region_enable_lockless_io(MemoryRegion *mr)
+{
+    mr->lockless_io = true;
+    /*
+     * The re-entrancy guard is a per-device flag that is only safe to
+     * update under the BQL.
+     */
+    mr->disable_reentrancy_guard = true;
+}
+
 void memory_region_clear_flush_coalesced(MemoryRegion *mr)
 {
     qemu_flush_coalesced_mmio_buffer();
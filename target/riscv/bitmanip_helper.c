@@ -23,31 +23,22 @@
 #include "exec/exec-all.h"
 #include "exec/helper-proto.h"
 #include "tcg/tcg.h"
+#include "crypto/clmul.h"
 
 target_ulong HELPER(clmul)(target_ulong rs1, target_ulong rs2)
 {
-    target_ulong result = 0;
-
-    for (int i = 0; i < TARGET_LONG_BITS; i++) {
-        if ((rs2 >> i) & 1) {
-            result ^= (rs1 << i);
-        }
-    }
-
-    return result;
+    return int128_getlo(clmul_64(rs1, rs2));
 }
 
+/*
+ * The product of two XLEN-bit operands fits in 2*XLEN-1 bits; clmulr
+ * returns bits [2*XLEN-2:XLEN-1] of it.
+ */
 target_ulong HELPER(clmulr)(target_ulong rs1, target_ulong rs2)
 {
-    target_ulong result = 0;
-
-    for (int i = 0; i < TARGET_LONG_BITS; i++) {
-        if ((rs2 >> i) & 1) {
-            result ^= (rs1 >> (TARGET_LONG_BITS - i - 1));
-        }
-    }
+    Int128 r = clmul_64(rs1, rs2);
 
-    return result;
+    return int128_getlo(int128_urshift(r, TARGET_LONG_BITS - 1));
 }
 
 static inline target_ulong do_swap(target_ulong x, uint64_t mask, int shift)
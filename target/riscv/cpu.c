@@ -3957,6 +3957,10 @@ static Property riscv_cpu_properties[] = {
     {.name = "mtvec", .info = &prop_mtvec},
     {.name = "mtvt", .info = &prop_mtvt},
     {.name = "jvt", .info = &prop_jvt},
+
+    DEFINE_PROP_BOOL("pmu-cache-model", RISCVCPU, cfg.pmu_cache_model, false),
+    DEFINE_PROP_UINT32("pmu-sample-period", RISCVCPU, cfg.pmu_sample_period,
+                       64),
 #endif
 
     DEFINE_PROP_BOOL("short-isa-string", RISCVCPU, cfg.short_isa_string, false),
@@ -212,6 +212,14 @@ struct CPUArchState {
     target_ulong vstart;
     target_ulong vtype;
     bool vill;
+    /*
+     * Byte mask of the body elements (vl << SEW bytes) and a scratch
+     * register group, used by the inline expansion of vector ops when
+     * vl != VLMAX.  vl_mask is derived from vl/vtype and is never
+     * migrated.
+     */
+    uint64_t vl_mask[RV_VLEN_MAX / 8] QEMU_ALIGNED(16);
+    uint64_t vtmp[RV_VLEN_MAX / 8] QEMU_ALIGNED(16);
 
     target_ulong pc;
     target_ulong load_res;
@@ -221,6 +229,11 @@ struct CPUArchState {
     uint64_t fpr[32]; /* assume both F and D extensions */
     target_ulong frm;
     float_status fp_status;
+    /*
+     * The rounding mode in fp_status was last set from frm rather than
+     * from a static rm, see riscv_cpu_frm_synced().
+     */
+    bool frm_synced;
 
     /* matrix state */
     target_ulong mrstart;
@@ -458,6 +471,9 @@ struct CPUArchState {
     uint64_t (*rdtime_fn)(void *);
     void *rdtime_fn_arg;
 
+    /* accesses left before the next memory sample */
+    int32_t mem_sample_countdown;
+
     /* machine specific AIA ireg read-modify-write callback */
 #define AIA_MAKE_IREG(__isel, __priv, __virt, __vgein, __xlen) \
     ((((__xlen) & 0xff) << 24) | \
@@ -612,6 +628,8 @@ struct ArchCPU {
     uint32_t pmu_avail_ctrs;
     /* Mapping of events to counters */
     GHashTable *pmu_event_ctr_map;
+    /* Cache and branch model feeding the programmable counters */
+    struct RISCVPMUModel *pmu_model;
     const GPtrArray *decoders;
     /* extended by Xuantie for xiaohui platform */
     XTPowerState power_state;
@@ -663,6 +681,7 @@ bool riscv_cpu_fp_enabled(CPURISCVState *env);
 target_ulong riscv_cpu_get_geilen(CPURISCVState *env);
 void riscv_cpu_set_geilen(CPURISCVState *env, target_ulong geilen);
 bool riscv_cpu_vector_enabled(CPURISCVState *env);
+void riscv_cpu_update_vl_mask(CPURISCVState *env);
 bool riscv_cpu_matrix_enabled(CPURISCVState *env);
 void riscv_cpu_set_virt_enabled(CPURISCVState *env, bool enable);
 int riscv_env_mmu_index(CPURISCVState *env, bool ifetch);
@@ -697,6 +716,19 @@ void riscv_cpu_interrupt(CPURISCVState *env);
 #define BOOL_TO_MASK(x) (-!!(x)) /* helper for riscv_cpu_update_mip value */
 void riscv_cpu_set_rdtime_fn(CPURISCVState *env, uint64_t (*fn)(void *),
                              void *arg);
+
+/*
+ * Called for one in every @weight guest loads and stores, with the
+ * physical address accessed and the state of the hart doing it.
+ */
+typedef void RISCVMemSampleFn(void *opaque, CPURISCVState *env,
+                              hwaddr paddr, unsigned size, bool is_store,
+                              uint32_t weight);
+bool riscv_cpu_add_mem_sampler(RISCVMemSampleFn *fn, void *opaque,
+                               uint32_t period, Error **errp);
+uint32_t riscv_cpu_mem_sample_period(void);
+void riscv_cpu_mem_sample(CPURISCVState *env, hwaddr paddr, unsigned size,
+                          bool is_store);
 void riscv_cpu_set_aia_ireg_rmw_fn(CPURISCVState *env, uint32_t priv,
                                    int (*rmw_fn)(void *arg,
                                                  target_ulong reg,
@@ -749,6 +781,8 @@ FIELD(TB_FLAGS_ANY, PM_PMM, 26, 2)
 FIELD(TB_FLAGS_ANY, PM_SIGNEXTEND, 28, 1)
 FIELD(TB_FLAGS_ANY, XSSE, 29, 1)
 FIELD(TB_FLAGS_ANY, ELP, 30, 1)
+/* fp_status holds the rounding mode of a valid frm */
+FIELD(TB_FLAGS_ANY, FRM_DYN, 31, 1)
 
 /* matrix flags*/
 FIELD(TB_FLAGS_THEAD, PWFP, 0, 1)
@@ -993,6 +1027,18 @@ enum {
 enum riscv_pmu_event_idx {
     RISCV_PMU_EVENT_HW_CPU_CYCLES = 0x01,
     RISCV_PMU_EVENT_HW_INSTRUCTIONS = 0x02,
+    RISCV_PMU_EVENT_HW_CACHE_REFERENCES = 0x03,
+    RISCV_PMU_EVENT_HW_CACHE_MISSES = 0x04,
+    RISCV_PMU_EVENT_HW_BRANCH_INSTRUCTIONS = 0x05,
+    RISCV_PMU_EVENT_HW_BRANCH_MISSES = 0x06,
+    RISCV_PMU_EVENT_CACHE_L1D_READ_ACCESS = 0x10000,
+    RISCV_PMU_EVENT_CACHE_L1D_READ_MISS = 0x10001,
+    RISCV_PMU_EVENT_CACHE_L1D_WRITE_ACCESS = 0x10002,
+    RISCV_PMU_EVENT_CACHE_L1D_WRITE_MISS = 0x10003,
+    RISCV_PMU_EVENT_CACHE_LL_READ_ACCESS = 0x10010,
+    RISCV_PMU_EVENT_CACHE_LL_READ_MISS = 0x10011,
+    RISCV_PMU_EVENT_CACHE_LL_WRITE_ACCESS = 0x10012,
+    RISCV_PMU_EVENT_CACHE_LL_WRITE_MISS = 0x10013,
     RISCV_PMU_EVENT_CACHE_DTLB_READ_MISS = 0x10019,
     RISCV_PMU_EVENT_CACHE_DTLB_WRITE_MISS = 0x1001B,
     RISCV_PMU_EVENT_CACHE_ITLB_PREFETCH_MISS = 0x10021,
@@ -198,6 +198,8 @@ struct RISCVCPUConfig {
     bool ext_xtheadcbop;
 
     uint32_t pmu_mask;
+    bool pmu_cache_model;
+    uint32_t pmu_sample_period;
     uint16_t vlenb;
     uint16_t elen;
     uint16_t mrowlen;
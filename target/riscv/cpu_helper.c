@@ -20,6 +20,7 @@
 #include "qemu/osdep.h"
 #include "qemu/log.h"
 #include "qemu/main-loop.h"
+#include "qapi/error.h"
 #include "cpu.h"
 #include "internals.h"
 #include "pmu.h"
@@ -246,6 +247,9 @@ void cpu_get_tb_cpu_state(CPURISCVState *env, vaddr *pc,
 
     DP_TBFLAGS_ANY(flags, FS, fs);
     DP_TBFLAGS_ANY(flags, VS, vs);
+    if (fs != EXT_STATUS_DISABLED) {
+        DP_TBFLAGS_ANY(flags, FRM_DYN, riscv_cpu_frm_synced(env));
+    }
     DP_TBFLAGS_ANY(flags, XL, env->xl);
     DP_TBFLAGS_ANY(flags, AXL, cpu_address_xl(env));
     DP_TBFLAGS_ANY(flags, PM_PMM, riscv_pm_get_pmm(env));
@@ -670,6 +674,32 @@ bool riscv_cpu_vector_enabled(CPURISCVState *env)
     return false;
 }
 
+/*
+ * Recompute env->vl_mask after vl or vtype changed.  Only the bytes of the
+ * current register group are rewritten, as translated code never looks
+ * past VLMAX for the vtype it was generated for.
+ */
+void riscv_cpu_update_vl_mask(CPURISCVState *env)
+{
+    RISCVCPU *cpu = env_archcpu(env);
+    uint32_t vsew = FIELD_EX64(env->vtype, VTYPE, VSEW);
+    int8_t lmul = sextract32(FIELD_EX64(env->vtype, VTYPE, VLMUL), 0, 3);
+    uint32_t maxsz = vext_get_vlmax(cpu->cfg.vlenb, vsew, lmul) << vsew;
+    uint32_t len, full, i;
+    uint8_t *mask = (uint8_t *)env->vl_mask;
+
+    maxsz = MIN(QEMU_ALIGN_UP(maxsz, 8), sizeof(env->vl_mask));
+    len = MIN(env->vl << vsew, maxsz);
+    full = QEMU_ALIGN_DOWN(len, 8);
+
+    memset(mask, 0xff, full);
+    memset(mask + full, 0, maxsz - full);
+    /* Elements are swizzled within each 64-bit word on big-endian hosts */
+    for (i = full; i < len; i++) {
+        mask[HOST_BIG_ENDIAN ? i ^ 7 : i] = 0xff;
+    }
+}
+
 /* Return true is matrix support is currently enabled */
 bool riscv_cpu_matrix_enabled(CPURISCVState *env)
 {
@@ -845,6 +875,61 @@ void riscv_cpu_set_rdtime_fn(CPURISCVState *env, uint64_t (*fn)(void *),
     env->rdtime_fn_arg = arg;
 }
 
+/*
+ * Memory access sampling: once a sampler is registered, translated
+ * loads and stores count down env->mem_sample_countdown inline and
+ * call helper_mem_sample() when it runs out, i.e. once every
+ * riscv_mem_sample_period accesses per hart. The period is the
+ * smallest one requested; samplers get it as the weight of a sample.
+ * Samplers must be registered before any code is translated.
+ * The limit fits the PMU model plus the six CBQRI controllers of the
+ * example SoC on the virt machine.
+ */
+#define RISCV_MEM_SAMPLERS_MAX 8
+
+static struct {
+    RISCVMemSampleFn *fn;
+    void *opaque;
+} riscv_mem_samplers[RISCV_MEM_SAMPLERS_MAX];
+static unsigned int riscv_mem_nb_samplers;
+static uint32_t riscv_mem_sample_period;
+
+bool riscv_cpu_add_mem_sampler(RISCVMemSampleFn *fn, void *opaque,
+                               uint32_t period, Error **errp)
+{
+    assert(period > 0 && period <= INT32_MAX);
+    if (riscv_mem_nb_samplers == RISCV_MEM_SAMPLERS_MAX) {
+        error_setg(errp, "at most %d memory access samplers are supported",
+                   RISCV_MEM_SAMPLERS_MAX);
+        return false;
+    }
+
+    riscv_mem_samplers[riscv_mem_nb_samplers].fn = fn;
+    riscv_mem_samplers[riscv_mem_nb_samplers].opaque = opaque;
+    riscv_mem_nb_samplers++;
+
+    if (!riscv_mem_sample_period || period < riscv_mem_sample_period) {
+        riscv_mem_sample_period = period;
+    }
+    return true;
+}
+
+uint32_t riscv_cpu_mem_sample_period(void)
+{
+    return riscv_mem_sample_period;
+}
+
+void riscv_cpu_mem_sample(CPURISCVState *env, hwaddr paddr, unsigned size,
+                          bool is_store)
+{
+    unsigned int i;
+
+    for (i = 0; i < riscv_mem_nb_samplers; i++) {
+        riscv_mem_samplers[i].fn(riscv_mem_samplers[i].opaque, env, paddr,
+                                 size, is_store, riscv_mem_sample_period);
+    }
+}
+
 void riscv_cpu_set_aia_ireg_rmw_fn(CPURISCVState *env, uint32_t priv,
                                    int (*rmw_fn)(void *arg,
                                                  target_ulong reg,
@@ -1398,8 +1398,11 @@ RISCVException riscv_pmu_read_ctr(CPURISCVState *env, target_ulong *val,
     PMUCTRState *counter = &env->pmu_ctrs[ctr_idx];
     target_ulong ctr_prev = upper_half ? counter->mhpmcounterh_prev :
                                          counter->mhpmcounter_prev;
-    target_ulong ctr_val = upper_half ? counter->mhpmcounterh_val :
-                                        counter->mhpmcounter_val;
+    target_ulong ctr_val;
+
+    riscv_pmu_model_flush(env);
+    ctr_val = upper_half ? counter->mhpmcounterh_val :
+                           counter->mhpmcounter_val;
 
     if (get_field(env->mcountinhibit, BIT(ctr_idx))) {
         /*
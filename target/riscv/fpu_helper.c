@@ -55,6 +55,7 @@ void helper_set_rounding_mode(CPURISCVState *env, uint32_t rm)
 {
     int softrm;
 
+    env->frm_synced = rm == RISCV_FRM_DYN;
     if (rm == RISCV_FRM_DYN) {
         rm = env->frm;
     }
@@ -89,6 +90,7 @@ void helper_set_rounding_mode_chkfrm(CPURISCVState *env, uint32_t rm)
     if (unlikely(env->frm >= 5)) {
         riscv_raise_exception(env, RISCV_EXCP_ILLEGAL_INST, GETPC());
     }
+    env->frm_synced = rm == RISCV_FRM_DYN;
     if (rm == RISCV_FRM_DYN) {
         rm = env->frm;
     }
@@ -118,6 +120,13 @@ void helper_set_rounding_mode_chkfrm(CPURISCVState *env, uint32_t rm)
     set_float_rounding_mode(softrm, &env->fp_status);
 }
 
+/* Inline read of fcsr, once translation has checked that FP is enabled */
+target_ulong helper_read_fcsr(CPURISCVState *env)
+{
+    return (riscv_cpu_get_fflags(env) << FSR_AEXC_SHIFT) |
+           (env->frm << FSR_RD_SHIFT);
+}
+
 static uint64_t do_fmadd_h(CPURISCVState *env, uint64_t rs1, uint64_t rs2,
                            uint64_t rs3, int flags)
 {
@@ -27,6 +27,7 @@ DEF_HELPER_2(raise_exception, noreturn, env, i32)
 /* Floating Point - rounding mode */
 DEF_HELPER_FLAGS_2(set_rounding_mode, TCG_CALL_NO_WG, void, env, i32)
 DEF_HELPER_FLAGS_2(set_rounding_mode_chkfrm, TCG_CALL_NO_WG, void, env, i32)
+DEF_HELPER_FLAGS_1(read_fcsr, TCG_CALL_NO_RWG_SE, tl, env)
 
 /* Floating Point - fused */
 DEF_HELPER_FLAGS_4(fmadd_s, TCG_CALL_NO_RWG, i64, env, i64, i64, i64)
@@ -166,6 +167,7 @@ DEF_HELPER_4(ctr_jal, void, env, tl, tl, tl)
 DEF_HELPER_5(ctr_jalr, void, env, tl, tl, tl, tl)
 /* Native Debug */
 DEF_HELPER_1(itrigger_match, void, env)
+DEF_HELPER_FLAGS_3(mem_sample, TCG_CALL_NO_WG, void, env, tl, i32)
 #endif
 
 /* Hypervisor functions */
@@ -2549,14 +2551,6 @@ DEF_HELPER_6(th_vcompress_vm_w, void, ptr, ptr, ptr, ptr, env, i32)
 DEF_HELPER_6(th_vcompress_vm_d, void, ptr, ptr, ptr, ptr, env, i32)
 
 /* P extension function */
-DEF_HELPER_3(radd16, tl, env, tl, tl)
-DEF_HELPER_3(uradd16, tl, env, tl, tl)
-DEF_HELPER_3(kadd16, tl, env, tl, tl)
-DEF_HELPER_3(ukadd16, tl, env, tl, tl)
-DEF_HELPER_3(rsub16, tl, env, tl, tl)
-DEF_HELPER_3(ursub16, tl, env, tl, tl)
-DEF_HELPER_3(ksub16, tl, env, tl, tl)
-DEF_HELPER_3(uksub16, tl, env, tl, tl)
 DEF_HELPER_3(cras16, tl, env, tl, tl)
 DEF_HELPER_3(rcras16, tl, env, tl, tl)
 DEF_HELPER_3(urcras16, tl, env, tl, tl)
@@ -2578,15 +2572,6 @@ DEF_HELPER_3(urstsa16, tl, env, tl, tl)
 DEF_HELPER_3(kstsa16, tl, env, tl, tl)
 DEF_HELPER_3(ukstsa16, tl, env, tl, tl)
 
-DEF_HELPER_3(radd8, tl, env, tl, tl)
-DEF_HELPER_3(uradd8, tl, env, tl, tl)
-DEF_HELPER_3(kadd8, tl, env, tl, tl)
-DEF_HELPER_3(ukadd8, tl, env, tl, tl)
-DEF_HELPER_3(rsub8, tl, env, tl, tl)
-DEF_HELPER_3(ursub8, tl, env, tl, tl)
-DEF_HELPER_3(ksub8, tl, env, tl, tl)
-DEF_HELPER_3(uksub8, tl, env, tl, tl)
-
 DEF_HELPER_3(sra16, tl, env, tl, tl)
 DEF_HELPER_3(sra16_u, tl, env, tl, tl)
 DEF_HELPER_3(srl16, tl, env, tl, tl)
@@ -2605,18 +2590,6 @@ DEF_HELPER_3(ksll8, tl, env, tl, tl)
 DEF_HELPER_3(kslra8, tl, env, tl, tl)
 DEF_HELPER_3(kslra8_u, tl, env, tl, tl)
 
-DEF_HELPER_3(cmpeq16, tl, env, tl, tl)
-DEF_HELPER_3(scmplt16, tl, env, tl, tl)
-DEF_HELPER_3(scmple16, tl, env, tl, tl)
-DEF_HELPER_3(ucmplt16, tl, env, tl, tl)
-DEF_HELPER_3(ucmple16, tl, env, tl, tl)
-
-DEF_HELPER_3(cmpeq8, tl, env, tl, tl)
-DEF_HELPER_3(scmplt8, tl, env, tl, tl)
-DEF_HELPER_3(scmple8, tl, env, tl, tl)
-DEF_HELPER_3(ucmplt8, tl, env, tl, tl)
-DEF_HELPER_3(ucmple8, tl, env, tl, tl)
-
 DEF_HELPER_3(smul16, i64, env, tl, tl)
 DEF_HELPER_3(smulx16, i64, env, tl, tl)
 DEF_HELPER_3(umul16, i64, env, tl, tl)
@@ -2631,10 +2604,6 @@ DEF_HELPER_3(umulx8, i64, env, tl, tl)
 DEF_HELPER_3(khm8, tl, env, tl, tl)
 DEF_HELPER_3(khmx8, tl, env, tl, tl)
 
-DEF_HELPER_3(smin16, tl, env, tl, tl)
-DEF_HELPER_3(umin16, tl, env, tl, tl)
-DEF_HELPER_3(smax16, tl, env, tl, tl)
-DEF_HELPER_3(umax16, tl, env, tl, tl)
 DEF_HELPER_3(sclip16, tl, env, tl, tl)
 DEF_HELPER_3(uclip16, tl, env, tl, tl)
 DEF_HELPER_2(kabs16, tl, env, tl)
@@ -2642,10 +2611,6 @@ DEF_HELPER_2(clrs16, tl, env, tl)
 DEF_HELPER_2(clz16, tl, env, tl)
 DEF_HELPER_2(clo16, tl, env, tl)
 
-DEF_HELPER_3(smin8, tl, env, tl, tl)
-DEF_HELPER_3(umin8, tl, env, tl, tl)
-DEF_HELPER_3(smax8, tl, env, tl, tl)
-DEF_HELPER_3(umax8, tl, env, tl, tl)
 DEF_HELPER_3(sclip8, tl, env, tl, tl)
 DEF_HELPER_3(uclip8, tl, env, tl, tl)
 DEF_HELPER_2(kabs8, tl, env, tl)
@@ -2665,11 +2630,6 @@ DEF_HELPER_2(zunpkd830, tl, env, tl)
 DEF_HELPER_2(zunpkd831, tl, env, tl)
 DEF_HELPER_2(zunpkd832, tl, env, tl)
 
-DEF_HELPER_3(pkbb16, tl, env, tl, tl)
-DEF_HELPER_3(pkbt16, tl, env, tl, tl)
-DEF_HELPER_3(pktt16, tl, env, tl, tl)
-DEF_HELPER_3(pktb16, tl, env, tl, tl)
-
 DEF_HELPER_3(smmul, tl, env, tl, tl)
 DEF_HELPER_3(smmul_u, tl, env, tl, tl)
 DEF_HELPER_4(kmmac, tl, env, tl, tl, tl)
@@ -2725,10 +2685,6 @@ DEF_HELPER_2(clo32, tl, env, tl)
 DEF_HELPER_3(pbsad, tl, env, tl, tl)
 DEF_HELPER_4(pbsada, tl, env, tl, tl, tl)
 
-DEF_HELPER_4(smaqa, tl, env, tl, tl, tl)
-DEF_HELPER_4(umaqa, tl, env, tl, tl, tl)
-DEF_HELPER_4(smaqa_su, tl, env, tl, tl, tl)
-
 DEF_HELPER_3(add64, i64, env, i64, i64)
 DEF_HELPER_3(radd64, i64, env, i64, i64)
 DEF_HELPER_3(uradd64, i64, env, i64, i64)
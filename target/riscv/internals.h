@@ -105,6 +105,35 @@ enum {
     RISCV_FRM_ROD = 8,  /* Round to Odd */
 };
 
+/* The softfloat rounding mode for a static rm in [RISCV_FRM_RNE, RMM]. */
+static inline FloatRoundMode riscv_frm_to_softfloat(int rm)
+{
+    static const FloatRoundMode softrm[] = {
+        [RISCV_FRM_RNE] = float_round_nearest_even,
+        [RISCV_FRM_RTZ] = float_round_to_zero,
+        [RISCV_FRM_RDN] = float_round_down,
+        [RISCV_FRM_RUP] = float_round_up,
+        [RISCV_FRM_RMM] = float_round_ties_away,
+    };
+
+    return softrm[rm];
+}
+
+/*
+ * True if frm is valid and fp_status already rounds according to it, so
+ * that an instruction with a dynamic rm needs no set_rounding_mode call.
+ * This is part of the TB flags, and must therefore be known at the end of
+ * each TB from its flags and code alone: the frm_synced bit, which tracks
+ * whether the last rm set was dynamic, provides that; the comparison
+ * covers state that is not migrated.
+ */
+static inline bool riscv_cpu_frm_synced(CPURISCVState *env)
+{
+    return env->frm_synced && env->frm <= RISCV_FRM_RMM &&
+           get_float_rounding_mode(&env->fp_status) ==
+           riscv_frm_to_softfloat(env->frm);
+}
+
 static inline uint64_t nanbox_s(CPURISCVState *env, float32 f)
 {
     /* the value is sign-extended instead of NaN-boxing for zfinx */
@@ -257,6 +257,9 @@ static int riscv_cpu_post_load(void *opaque, int version_id)
     CPURISCVState *env = &cpu->env;
 
     env->xl = cpu_recompute_xl(env);
+    if (riscv_has_ext(env, RVV)) {
+        riscv_cpu_update_vl_mask(env);
+    }
     return 0;
 }
 
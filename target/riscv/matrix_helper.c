@@ -930,8 +930,10 @@ static inline uint32_t f32_to_f16_ieee(uint64_t a, float_status *status)
 }
 
 FP_UNOP_WRAPPER_DEF(bfloat16_to_float32)
+FP_UNOP_WRAPPER_DEF(float8e4_to_bfloat16)
 FP_UNOP_WRAPPER_DEF(float8e4_to_float16)
 FP_UNOP_WRAPPER_DEF(float8e4_to_float32)
+FP_UNOP_WRAPPER_DEF(float8e5_to_bfloat16)
 FP_UNOP_WRAPPER_DEF(float8e5_to_float16)
 FP_UNOP_WRAPPER_DEF(float8e5_to_float32)
 FP_UNOP_WRAPPER_DEF(float16_to_float8e4)
@@ -1238,99 +1240,68 @@ void helper_fmmacc_d(void *md, void *ms1, void *ms2,
     }
 }
 
-/* fmmacc.s.e4: float8e4 x float8e4 + float32 -> float32 */
-static inline uint64_t fmacc_f8e4_to_f32(uint64_t a, uint64_t b, uint64_t c,
-                                         float_status *s) {
-    float32 a_f32 = float8e4_to_float32((uint8_t) a, s);
-    float32 b_f32 = float8e4_to_float32((uint8_t) b, s);
-    return fmacc32(a_f32, b_f32, c, s);
-}
-
-/* fmmacc.s.e5: float8e5 x float8e5 + float32 -> float32 */
-static inline uint64_t fmacc_f8e5_to_f32(uint64_t a, uint64_t b, uint64_t c,
-                                         float_status *s) {
-    float32 a_f32 = float8e5_to_float32((uint8_t) a, s);
-    float32 b_f32 = float8e5_to_float32((uint8_t) b, s);
-    return fmacc32(a_f32, b_f32, c, s);
-}
-
-/* fmmacc.s.bf16: bfloat16 x bfloat16 + float32 -> float32 */
-static inline uint64_t fmacc_bf16_to_f32(uint64_t a, uint64_t b, uint64_t c,
-                                         float_status *s) {
-    float32 a_f32 = bfloat16_to_float32((uint16_t) a, s);
-    float32 b_f32 = bfloat16_to_float32((uint16_t) b, s);
-    return fmacc32(a_f32, b_f32, c, s);
-}
-
-/* fmmacc.s.h: float16 x float16 + float32 -> float32 */
-static inline uint64_t fmacc_f16_to_f32(uint64_t a, uint64_t b, uint64_t c,
-                                        float_status *s) {
-    float32 a_f32 = float16_to_float32((uint16_t) a, true, s);
-    float32 b_f32 = float16_to_float32((uint16_t) b, true, s);
-    return fmacc32(a_f32, b_f32, c, s);
-}
+/*
+ * The widening fmmacc forms convert every operand to the accumulator
+ * format before the MAC.  The conversions are exact and only depend on
+ * the (constant) float_status, and exception flags are sticky, so the
+ * operands are widened into row buffers ahead of the MAC loop instead of
+ * once per MAC.  ms2 is widened once, MMEXT_WIDEN_ROWS rows at a time;
+ * each ms1 row is widened once per block of ms2 rows.
+ */
+#define MMEXT_WIDEN_ROWS    8
+#define MMEXT_WIDEN_COLS    (RV_RLEN_MAX / 8)
 
-/* fmmacc.h.e4: float8e4 x float8e4 + float16 -> float16 */
-static inline uint64_t fmacc_f8e4_to_f16(uint64_t a, uint64_t b, uint64_t c,
-                                         float_status *s) {
-    float16 a_f16 = float8e4_to_float16((uint8_t) a, s);
-    float16 b_f16 = float8e4_to_float16((uint8_t) b, s);
-    return fmacc16(a_f16, b_f16, c, s);
-}
-
-/* fmmacc.h.e4: float8e5 x float8e5 + float16 -> float16 */
-static inline uint64_t fmacc_f8e5_to_f16(uint64_t a, uint64_t b, uint64_t c,
-                                         float_status *s) {
-    float16 a_f16 = float8e5_to_float16((uint8_t) a, s);
-    float16 b_f16 = float8e5_to_float16((uint8_t) b, s);
-    return fmacc16(a_f16, b_f16, c, s);
-}
+typedef uint16_t fmacc16_fn(uint16_t, uint16_t, uint16_t, float_status *);
 
-/* fmmacc.bf16.e4 */
-static inline uint64_t fmacc_f8e4_to_bf16(uint64_t a, uint64_t b, uint64_t c,
-                                          float_status *s) {
-    bfloat16 a_bf16 = float8e4_to_bfloat16((uint8_t) a, s);
-    bfloat16 b_bf16 = float8e4_to_bfloat16((uint8_t) b, s);
-    return fmaccbf16(a_bf16, b_bf16, c, s);
-}
+static void mmext_widen_row(uint32_t *dst, void *ms, uint32_t row,
+                            uint32_t cols, CPURISCVState *env,
+                            mmext_get_elem *get_elem, fp_unop *widen_fn)
+{
+    uint32_t k;
 
-/* fmmacc.bf16.e5 */
-static inline uint64_t fmacc_f8e5_to_bf16(uint64_t a, uint64_t b, uint64_t c,
-                                          float_status *s) {
-    bfloat16 a_bf16 = float8e5_to_bfloat16((uint8_t) a, s);
-    bfloat16 b_bf16 = float8e5_to_bfloat16((uint8_t) b, s);
-    return fmaccbf16(a_bf16, b_bf16, c, s);
+    for (k = 0; k < cols; k++) {
+        dst[k] = widen_fn(get_elem(ms, row, k, env), &env->mfp_status);
+    }
 }
 
-typedef uint64_t fmacc_fn(uint64_t, uint64_t, uint64_t, float_status*);
-
 static inline void mmext_fmmacc_b_to_h(void *md, void *ms1, void *ms2,
-                                       CPURISCVState *env, fmacc_fn *macc_fn,
+                                       CPURISCVState *env, fp_unop *widen_fn,
+                                       fmacc16_fn *macc_fn,
                                        fp_binop *add_fn) {
-    uint32_t i, j, k;
+    uint32_t i, j, j0, k, nj;
     uint16_t temp, psum;
-    uint16_t oprd_a, oprd_b;
+    uint32_t rows = get_mrows(env), cols = env->sizek;
     void *ms2_pair_1 = ms2;
     void *ms2_pair_2 = (void *) (((int8_t *) ms2) + get_mlenb(env));
-    for (i = 0; i < get_mrows(env); i++) {
-        for (j = 0; j < get_mrows(env) * 2; j++) {
-            temp = 0;
-            for (k = 0; k < env->sizek; k++) {
-                oprd_a = get_elem_b(ms1, i, k, env);
-                if (j >= get_mrows(env)) {
-                    oprd_b = get_elem_b(ms2_pair_2, j % (get_mrows(env)),
-                                        k, env);
+    uint32_t wa[MMEXT_WIDEN_COLS];
+    uint32_t wb[MMEXT_WIDEN_ROWS][MMEXT_WIDEN_COLS];
+
+    for (j0 = 0; j0 < rows * 2; j0 += nj) {
+        nj = MIN(rows * 2 - j0, MMEXT_WIDEN_ROWS);
+        for (j = 0; j < nj; j++) {
+            if (j0 + j >= rows) {
+                mmext_widen_row(wb[j], ms2_pair_2, j0 + j - rows, cols, env,
+                                get_elem_b, widen_fn);
+            } else {
+                mmext_widen_row(wb[j], ms2_pair_1, j0 + j, cols, env,
+                                get_elem_b, widen_fn);
+            }
+        }
+
+        for (i = 0; i < rows; i++) {
+            mmext_widen_row(wa, ms1, i, cols, env, get_elem_b, widen_fn);
+            for (j = 0; j < nj; j++) {
+                temp = 0;
+                for (k = 0; k < cols; k++) {
+                    temp = macc_fn(wa[k], wb[j][k], temp, &env->mfp_status);
+                }
+                if (i < env->sizem && j0 + j < env->sizen) {
+                    psum = get_elem_h(md, i, j0 + j, env);
+                    psum = add_fn(psum, temp, &env->mfp_status);
+                    set_elem_h(md, i, j0 + j, env, psum);
                 } else {
-                    oprd_b = get_elem_b(ms2_pair_1, j, k, env);
+                    set_elem_h(md, i, j0 + j, env, 0);
                 }
-                temp = macc_fn(oprd_a, oprd_b, temp, &env->mfp_status);
-            }
-            if (i < env->sizem && j < env->sizen) {
-                psum = get_elem_h(md, i, j, env);
-                psum = add_fn(psum, temp, &env->mfp_status);
-                set_elem_h(md, i, j, env, psum);
-            } else {
-                set_elem_h(md, i, j, env, 0);
             }
         }
     }
@@ -1338,40 +1309,50 @@ static inline void mmext_fmmacc_b_to_h(void *md, void *ms1, void *ms2,
 
 static inline void mmext_fmmacc_to_s(void *md, void *ms1, void *ms2,
                                      CPURISCVState *env, uint8_t esz,
-                                     fmacc_fn *macc_fn,
+                                     fp_unop *widen_fn,
                                      mmext_get_elem *get_elem) {
-    uint32_t i, j, k;
+    uint32_t i, j, j0, k, nj;
     uint32_t temp, psum;
-    uint32_t oprd_a, oprd_b;
-    for (i = 0; i < get_mrows(env); i++) {
-        for (j = 0; j < get_mrows(env); j++) {
-            temp = 0;
-            for (k = 0; k < (env->sizek >> esz); k++) {
-                oprd_a = get_elem(ms1, i, k, env);
-                oprd_b = get_elem(ms2, j, k, env);
-                temp = macc_fn(oprd_a, oprd_b, temp, &env->mfp_status);
-            }
-            if (i < env->sizem && j < env->sizen) {
-                psum = get_elem_s(md, i, j, env);
-                psum = float32_add(psum, temp, &env->mfp_status);
-                set_elem_s(md, i, j, env, psum);
-            } else {
-                set_elem_s(md, i, j, env, 0);
+    uint32_t rows = get_mrows(env), cols = env->sizek >> esz;
+    uint32_t wa[MMEXT_WIDEN_COLS];
+    uint32_t wb[MMEXT_WIDEN_ROWS][MMEXT_WIDEN_COLS];
+
+    for (j0 = 0; j0 < rows; j0 += nj) {
+        nj = MIN(rows - j0, MMEXT_WIDEN_ROWS);
+        for (j = 0; j < nj; j++) {
+            mmext_widen_row(wb[j], ms2, j0 + j, cols, env, get_elem,
+                            widen_fn);
+        }
+
+        for (i = 0; i < rows; i++) {
+            mmext_widen_row(wa, ms1, i, cols, env, get_elem, widen_fn);
+            for (j = 0; j < nj; j++) {
+                temp = 0;
+                for (k = 0; k < cols; k++) {
+                    temp = fmacc32(wa[k], wb[j][k], temp, &env->mfp_status);
+                }
+                if (i < env->sizem && j0 + j < env->sizen) {
+                    psum = get_elem_s(md, i, j0 + j, env);
+                    psum = float32_add(psum, temp, &env->mfp_status);
+                    set_elem_s(md, i, j0 + j, env, psum);
+                } else {
+                    set_elem_s(md, i, j0 + j, env, 0);
+                }
             }
         }
     }
 }
 
-#define GEN_FMMACCH_B_HELPER(insn, macc, add)                         \
+#define GEN_FMMACCH_B_HELPER(insn, widen, macc, add)                  \
 void HELPER(insn)(void* md, void* ms1, void* ms2, CPURISCVState* env) \
 {                                                                     \
-    mmext_fmmacc_b_to_h(md, ms1, ms2, env, macc, add);                \
+    mmext_fmmacc_b_to_h(md, ms1, ms2, env, widen, macc, add);         \
 }
 
-#define GEN_FMMACC_S_HELPER(insn, macc, get_ty, esz)                    \
-void HELPER(insn)(void* md, void* ms1, void* ms2, CPURISCVState* env)   \
-{                                                                       \
-    mmext_fmmacc_to_s(md, ms1, ms2, env, esz, macc, get_elem_##get_ty); \
+#define GEN_FMMACC_S_HELPER(insn, widen, get_ty, esz)                    \
+void HELPER(insn)(void* md, void* ms1, void* ms2, CPURISCVState* env)    \
+{                                                                        \
+    mmext_fmmacc_to_s(md, ms1, ms2, env, esz, widen, get_elem_##get_ty); \
 }
 
 static inline uint64_t bfloat16_add_wrapped(uint64_t a, uint64_t b,
@@ -1379,18 +1360,24 @@ static inline uint64_t bfloat16_add_wrapped(uint64_t a, uint64_t b,
     return bfloat16_add(a, b, s);
 }
 
-GEN_FMMACCH_B_HELPER(fmmacc_bf16_e4, fmacc_f8e4_to_bf16, bfloat16_add_wrapped)
-GEN_FMMACCH_B_HELPER(fmmacc_bf16_e5, fmacc_f8e5_to_bf16, bfloat16_add_wrapped)
-GEN_FMMACCH_B_HELPER(fmmacc_h_e4,    fmacc_f8e4_to_f16,  FP_BINOP_FN(16, add))
-GEN_FMMACCH_B_HELPER(fmmacc_h_e5,    fmacc_f8e5_to_f16,  FP_BINOP_FN(16, add))
+GEN_FMMACCH_B_HELPER(fmmacc_bf16_e4, FUNOP(float8e4_to_bfloat16), fmaccbf16,
+                     bfloat16_add_wrapped)
+GEN_FMMACCH_B_HELPER(fmmacc_bf16_e5, FUNOP(float8e5_to_bfloat16), fmaccbf16,
+                     bfloat16_add_wrapped)
+GEN_FMMACCH_B_HELPER(fmmacc_h_e4, FUNOP(float8e4_to_float16), fmacc16,
+                     FP_BINOP_FN(16, add))
+GEN_FMMACCH_B_HELPER(fmmacc_h_e5, FUNOP(float8e5_to_float16), fmacc16,
+                     FP_BINOP_FN(16, add))
 
-GEN_FMMACC_S_HELPER(fmmacc_s_bf16, fmacc_bf16_to_f32, h, 1)
-GEN_FMMACC_S_HELPER(fmmacc_s_h,    fmacc_f16_to_f32,  h, 1)
-GEN_FMMACC_S_HELPER(fmmacc_s_e4,   fmacc_f8e4_to_f32, b, 0)
-GEN_FMMACC_S_HELPER(fmmacc_s_e5,   fmacc_f8e5_to_f32, b, 0)
+GEN_FMMACC_S_HELPER(fmmacc_s_bf16, FUNOP(bfloat16_to_float32), h, 1)
+GEN_FMMACC_S_HELPER(fmmacc_s_h,    FUNOP(f16_to_f32_ieee),     h, 1)
+GEN_FMMACC_S_HELPER(fmmacc_s_e4,   FUNOP(float8e4_to_float32), b, 0)
+GEN_FMMACC_S_HELPER(fmmacc_s_e5,   FUNOP(float8e5_to_float32), b, 0)
 
 /* floating point mixed precision matrix-multiplication-accumulation */
 
+typedef uint64_t fmacc_fn(uint64_t, uint64_t, uint64_t, float_status*);
+
 /* fmmacc.h.hp: float16 x signed-half-byte + float16 -> float16 */
 static inline uint64_t fmacc_f16xi4_to_f16(uint64_t a, uint64_t b, uint64_t c,
                                           float_status *s) {
@@ -1557,6 +1544,89 @@ void helper_fmmacc_d_s(void *md, void *ms1, void *ms2,
 
 /* load/store instructions */
 
+/*
+ * Resolve a contiguous row of @len bytes at @addr to a host pointer.
+ * Returns NULL when the row crosses a page or is not plain RAM (MMIO,
+ * watchpoints, ...), in which case the caller falls back to per-element
+ * accesses.  The caller must already have probed the row for faults.
+ */
+static void *mmext_row_host(CPURISCVState *env, target_ulong addr,
+                            uint32_t len, MMUAccessType access_type,
+                            uintptr_t ra)
+{
+    void *host;
+    int flags;
+
+    if (len == 0 || ((addr ^ (addr + len - 1)) & TARGET_PAGE_MASK)) {
+        return NULL;
+    }
+    flags = probe_access_flags(env, addr, len, access_type,
+                               riscv_env_mmu_index(env, false), true,
+                               &host, ra);
+    return flags ? NULL : host;
+}
+
+/*
+ * Load row @i of the tile at @md from guest memory in one go.  Only the
+ * first @len bytes (rounded down to whole elements) come from memory, the
+ * rest of the row is zeroed.  Returns false if the slow path must be used.
+ */
+static bool mmext_ld_row_host(void *md, uint32_t i, target_ulong addr,
+                              uint32_t len, CPURISCVState *env, uint8_t esz,
+                              uintptr_t ra)
+{
+    uint32_t rlenb = get_rlenb(env);
+    uint8_t *row = (uint8_t *)md + i * rlenb;
+    void *host;
+
+    if (len > rlenb) {
+        return false;
+    }
+    len = len >> esz << esz;
+    host = mmext_row_host(env, addr, len, MMU_DATA_LOAD, ra);
+    if (!host) {
+        return false;
+    }
+#if HOST_BIG_ENDIAN
+    for (uint32_t off = 0; off < len; off += 1 << esz) {
+        stn_he_p(row + off, 1 << esz, ldn_le_p((uint8_t *)host + off,
+                                               1 << esz));
+    }
+#else
+    memcpy(row, host, len);
+#endif
+    memset(row + len, 0, rlenb - len);
+    return true;
+}
+
+/* Store the first @len bytes of row @i of the tile at @ms3 in one go. */
+static bool mmext_st_row_host(void *ms3, uint32_t i, target_ulong addr,
+                              uint32_t len, CPURISCVState *env, uint8_t esz,
+                              uintptr_t ra)
+{
+    uint32_t rlenb = get_rlenb(env);
+    uint8_t *row = (uint8_t *)ms3 + i * rlenb;
+    void *host;
+
+    if (len > rlenb) {
+        return false;
+    }
+    len = len >> esz << esz;
+    host = mmext_row_host(env, addr, len, MMU_DATA_STORE, ra);
+    if (!host) {
+        return false;
+    }
+#if HOST_BIG_ENDIAN
+    for (uint32_t off = 0; off < len; off += 1 << esz) {
+        stn_le_p((uint8_t *)host + off, 1 << esz, ldn_he_p(row + off,
+                                                           1 << esz));
+    }
+#else
+    memcpy(host, row, len);
+#endif
+    return true;
+}
+
 #define MMEXT_LD_ELEM(NAME, LDSUF)                                         \
 static int64_t NAME(CPURISCVState *env, target_ulong addr,                 \
                     uintptr_t retaddr){                                    \
@@ -1584,6 +1654,11 @@ static void mmext_mld(void *md, target_ulong rs1, target_ulong s2,
     }
 
     for (i = 0; i < get_mrows(env); i++) {
+        if (i < env->sizem &&
+            mmext_ld_row_host(md, i, rs1 + i * s2, env->sizek, env, esz,
+                              ra)) {
+            continue;
+        }
         for (k = 0; k < (get_rlenb(env) >> esz); k++) {
             addr = rs1 + i * s2 + k * (1 << esz);
             if (i < env->sizem && k < (env->sizek >> esz)) {
@@ -1646,6 +1721,11 @@ static void mmext_mldm(void *md, target_ulong rs1, uint8_t nf,
     for (n = 0; n < nf; n++) {
         temp = (void *)((char *) md + n * get_mlenb(env));
         for (i = 0; i < get_mrows(env); i++) {
+            addr = rs1 + n * get_mlenb(env) + get_rlenb(env) * i;
+            if (mmext_ld_row_host(temp, i, addr, get_rlenb(env), env, esz,
+                                  ra)) {
+                continue;
+            }
             for (k = 0; k < (get_rlenb(env) >> esz); k++) {
                 addr = rs1 + n * get_mlenb(env) + get_rlenb(env) * i + k * (1 << esz);
                 set_elem(temp, i, k, env, ld_elem(env, addr, ra));
@@ -1722,6 +1802,10 @@ static void mmext_mst(void *ms3, target_ulong rs1, target_ulong s2,
     }
 
     for (i = 0; i < env->sizem; i++) {
+        if (mmext_st_row_host(ms3, i, rs1 + i * s2, env->sizek, env, esz,
+                              ra)) {
+            continue;
+        }
         for (k = 0; k < (env->sizek >> esz); k++) {
             addr = rs1 + i * s2 + k * (1 << esz);
             st_elem(env, addr, get_elem(ms3, i, k, env), ra);
@@ -1780,6 +1864,11 @@ static void mmext_mstm(void *ms3, target_ulong rs1, uint8_t nf,
     for (n = 0; n < nf; n++) {
         temp = (void *)((char *) ms3 + n * get_mlenb(env));
         for (i = 0; i < get_mrows(env); i++) {
+            addr = rs1 + n * get_mlenb(env) + get_rlenb(env) * i;
+            if (mmext_st_row_host(temp, i, addr, get_rlenb(env), env, esz,
+                                  ra)) {
+                continue;
+            }
             for (k = 0; k < (get_rlenb(env) >> esz); k++) {
                 addr = rs1 + n * get_mlenb(env) + get_rlenb(env) * i + k * (1 << esz);
                 st_elem(env, addr, get_elem(temp, i, k, env), ra);
@@ -21,6 +21,7 @@
 #include "qemu/osdep.h"
 #include "cpu.h"
 #include "internals.h"
+#include "pmu.h"
 #include "exec/exec-all.h"
 #include "exec/cpu_ldst.h"
 #include "exec/helper-proto.h"
@@ -570,6 +571,8 @@ void helper_ctr_branch(CPURISCVState *env, target_ulong src, target_ulong dest,
     target_ulong curr_priv = env->priv;
     bool curr_virt = env->virt_enabled;
 
+    riscv_pmu_branch(env, src, branch_taken);
+
     if (branch_taken) {
         riscv_ctr_add_entry(env, src, dest, CTRDATA_TYPE_TAKEN_BRANCH,
                             curr_priv, curr_virt);
@@ -644,6 +647,33 @@ void helper_tlb_flush_all(CPURISCVState *env)
     tlb_flush_all_cpus_synced(cs);
 }
 
+void helper_mem_sample(CPURISCVState *env, target_ulong addr, uint32_t desc)
+{
+    int mmu_idx = extract32(desc, 0, 8);
+    unsigned size = 1 << extract32(desc, 8, 3);
+    bool is_store = extract32(desc, 12, 1);
+    CPUTLBEntryFull *full;
+    void *host;
+    int flags;
+
+    env->mem_sample_countdown = riscv_cpu_mem_sample_period();
+
+    /*
+     * This runs after the access itself, which has already raised any
+     * fault, so the translation is normally in the TLB; one that does
+     * not resolve here (e.g. evicted meanwhile) is just not sampled.
+     */
+    flags = probe_access_full(env, addr, 0,
+                              is_store ? MMU_DATA_STORE : MMU_DATA_LOAD,
+                              mmu_idx, true, &host, &full, GETPC());
+    if (flags & TLB_INVALID_MASK) {
+        return;
+    }
+
+    riscv_cpu_mem_sample(env, full->phys_addr | (addr & ~TARGET_PAGE_MASK),
+                         size, is_store);
+}
+
 void helper_hyp_tlb_flush(CPURISCVState *env)
 {
     CPUState *cs = env_cpu(env);
@@ -58,47 +58,11 @@ static inline int32_t hadd32(int32_t a, int32_t b)
     return ((int64_t)a + b) >> 1;
 }
 
-static inline void do_radd16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-    d[i] = hadd32(a[i], b[i]);
-}
-
-RVPR(radd16, 1, 2);
-
 static inline uint32_t haddu32(uint32_t a, uint32_t b)
 {
     return ((uint64_t)a + b) >> 1;
 }
 
-static inline void do_uradd16(CPURISCVState *env, void *vd, void *va,
-                              void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[i] = haddu32(a[i], b[i]);
-}
-
-RVPR(uradd16, 1, 2);
-
-static inline void do_kadd16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-    d[i] = sadd16(env, 0, a[i], b[i]);
-}
-
-RVPR(kadd16, 1, 2);
-
-static inline void do_ukadd16(CPURISCVState *env, void *vd, void *va,
-                              void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[i] = saddu16(env, 0, a[i], b[i]);
-}
-
-RVPR(ukadd16, 1, 2);
-
 static inline int32_t hsub32(int32_t a, int32_t b)
 {
     return ((int64_t)a - b) >> 1;
@@ -113,47 +77,11 @@ static inline int64_t hsub64(int64_t a, int64_t b)
     return (res >> 1) ^ over;
 }
 
-static inline void do_rsub16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-    d[i] = hsub32(a[i], b[i]);
-}
-
-RVPR(rsub16, 1, 2);
-
 static inline uint64_t hsubu64(uint64_t a, uint64_t b)
 {
     return (a - b) >> 1;
 }
 
-static inline void do_ursub16(CPURISCVState *env, void *vd, void *va,
-                              void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[i] = hsubu64(a[i], b[i]);
-}
-
-RVPR(ursub16, 1, 2);
-
-static inline void do_ksub16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-    d[i] = ssub16(env, 0, a[i], b[i]);
-}
-
-RVPR(ksub16, 1, 2);
-
-static inline void do_uksub16(CPURISCVState *env, void *vd, void *va,
-                              void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[i] = ssubu16(env, 0, a[i], b[i]);
-}
-
-RVPR(uksub16, 1, 2);
-
 static inline void do_cras16(CPURISCVState *env, void *vd, void *va,
                              void *vb, uint8_t i)
 {
@@ -355,78 +283,6 @@ static inline void do_ukstsa16(CPURISCVState *env, void *vd, void *va,
 RVPR(ukstsa16, 2, 2);
 
 /* 8-bit Addition & Subtraction Instructions */
-static inline void do_radd8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-    d[i] = hadd32(a[i], b[i]);
-}
-
-RVPR(radd8, 1, 1);
-
-static inline void do_uradd8(CPURISCVState *env, void *vd, void *va,
-                                  void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-    d[i] = haddu32(a[i], b[i]);
-}
-
-RVPR(uradd8, 1, 1);
-
-static inline void do_kadd8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-    d[i] = sadd8(env, 0, a[i], b[i]);
-}
-
-RVPR(kadd8, 1, 1);
-
-static inline void do_ukadd8(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-    d[i] = saddu8(env, 0, a[i], b[i]);
-}
-
-RVPR(ukadd8, 1, 1);
-
-static inline void do_rsub8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-    d[i] = hsub32(a[i], b[i]);
-}
-
-RVPR(rsub8, 1, 1);
-
-static inline void do_ursub8(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-    d[i] = hsubu64(a[i], b[i]);
-}
-
-RVPR(ursub8, 1, 1);
-
-static inline void do_ksub8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-    d[i] = ssub8(env, 0, a[i], b[i]);
-}
-
-RVPR(ksub8, 1, 1);
-
-static inline void do_uksub8(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-    d[i] = ssubu8(env, 0, a[i], b[i]);
-}
-
-RVPR(uksub8, 1, 1);
-
 /* 16-bit Shift Instructions */
 static inline void do_sra16(CPURISCVState *env, void *vd, void *va,
                             void *vb, uint8_t i)
@@ -633,98 +489,6 @@ static inline void do_kslra8_u(CPURISCVState *env, void *vd, void *va,
 
 RVPR(kslra8_u, 1, 1);
 
-/* SIMD 16-bit Compare Instructions */
-static inline void do_cmpeq16(CPURISCVState *env, void *vd, void *va,
-                              void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] == b[i]) ? 0xffff : 0x0;
-}
-
-RVPR(cmpeq16, 1, 2);
-
-static inline void do_scmplt16(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] < b[i]) ? 0xffff : 0x0;
-}
-
-RVPR(scmplt16, 1, 2);
-
-static inline void do_scmple16(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] <= b[i]) ? 0xffff : 0x0;
-}
-
-RVPR(scmple16, 1, 2);
-
-static inline void do_ucmplt16(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] < b[i]) ? 0xffff : 0x0;
-}
-
-RVPR(ucmplt16, 1, 2);
-
-static inline void do_ucmple16(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] <= b[i]) ? 0xffff : 0x0;
-}
-
-RVPR(ucmple16, 1, 2);
-
-/* SIMD 8-bit Compare Instructions */
-static inline void do_cmpeq8(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] == b[i]) ? 0xff : 0x0;
-}
-
-RVPR(cmpeq8, 1, 1);
-
-static inline void do_scmplt8(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] < b[i]) ? 0xff : 0x0;
-}
-
-RVPR(scmplt8, 1, 1);
-
-static inline void do_scmple8(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] <= b[i]) ? 0xff : 0x0;
-}
-
-RVPR(scmple8, 1, 1);
-
-static inline void do_ucmplt8(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] < b[i]) ? 0xff : 0x0;
-}
-
-RVPR(ucmplt8, 1, 1);
-
-static inline void do_ucmple8(CPURISCVState *env, void *vd, void *va,
-                               void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-    d[i] = (a[i] <= b[i]) ? 0xff : 0x0;
-}
-
-RVPR(ucmple8, 1, 1);
-
 /* SIMD 16-bit Multiply Instructions */
 typedef void PackedFn3(CPURISCVState *, void *, void *, void *);
 static inline uint64_t rvpr64(CPURISCVState *env, target_ulong a,
@@ -923,46 +687,6 @@ static inline void do_khmx8(CPURISCVState *env, void *vd, void *va,
 RVPR(khmx8, 2, 1);
 
 /* SIMD 16-bit Miscellaneous Instructions */
-static inline void do_smin16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] < b[i]) ? a[i] : b[i];
-}
-
-RVPR(smin16, 1, 2);
-
-static inline void do_umin16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] < b[i]) ? a[i] : b[i];
-}
-
-RVPR(umin16, 1, 2);
-
-static inline void do_smax16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    int16_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] > b[i]) ? a[i] : b[i];
-}
-
-RVPR(smax16, 1, 2);
-
-static inline void do_umax16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] > b[i]) ? a[i] : b[i];
-}
-
-RVPR(umax16, 1, 2);
-
 static int64_t sat64(CPURISCVState *env, int64_t a, uint8_t shift)
 {
     int64_t max = shift >= 64 ? INT64_MAX : (1ull << shift) - 1;
@@ -1081,46 +805,6 @@ static inline void do_clo16(CPURISCVState *env, void *vd, void *va, uint8_t i)
 RVPR2(clo16, 1, 2);
 
 /* SIMD 8-bit Miscellaneous Instructions */
-static inline void do_smin8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] < b[i]) ? a[i] : b[i];
-}
-
-RVPR(smin8, 1, 1);
-
-static inline void do_umin8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] < b[i]) ? a[i] : b[i];
-}
-
-RVPR(umin8, 1, 1);
-
-static inline void do_smax8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    int8_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] > b[i]) ? a[i] : b[i];
-}
-
-RVPR(smax8, 1, 1);
-
-static inline void do_umax8(CPURISCVState *env, void *vd, void *va,
-                            void *vb, uint8_t i)
-{
-    uint8_t *d = vd, *a = va, *b = vb;
-
-    d[i] = (a[i] > b[i]) ? a[i] : b[i];
-}
-
-RVPR(umax8, 1, 1);
-
 static inline void do_sclip8(CPURISCVState *env, void *vd, void *va,
                              void *vb, uint8_t i)
 {
@@ -1320,47 +1004,6 @@ RVPR2(zunpkd832, 4, 1);
  *** Partial-SIMD Data Processing Instructions
  */
 
-/* 16-bit Packing Instructions */
-static inline void do_pkbb16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[H2(i + 1)] = a[H2(i)];
-    d[H2(i)] = b[H2(i)];
-}
-
-RVPR(pkbb16, 2, 2);
-
-static inline void do_pkbt16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[H2(i + 1)] = a[H2(i)];
-    d[H2(i)] = b[H2(i + 1)];
-}
-
-RVPR(pkbt16, 2, 2);
-
-static inline void do_pktt16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[H2(i + 1)] = a[H2(i + 1)];
-    d[H2(i)] = b[H2(i + 1)];
-}
-
-RVPR(pktt16, 2, 2);
-
-static inline void do_pktb16(CPURISCVState *env, void *vd, void *va,
-                             void *vb, uint8_t i)
-{
-    uint16_t *d = vd, *a = va, *b = vb;
-    d[H2(i + 1)] = a[H2(i + 1)];
-    d[H2(i)] = b[H2(i)];
-}
-
-RVPR(pktb16, 2, 2);
-
 /* Most Significant Word “32x32” Multiply & Add Instructions */
 static inline void do_smmul(CPURISCVState *env, void *vd, void *va,
                             void *vb, uint8_t i)
@@ -2046,50 +1689,6 @@ static inline void do_pbsada(CPURISCVState *env, void *vd, void *va,
 
 RVPR_ACC(pbsada, 1, 1);
 
-/* 8-bit Multiply with 32-bit Add Instructions */
-static inline void do_smaqa(CPURISCVState *env, void *vd, void *va,
-                            void *vb, void *vc, uint8_t i)
-{
-    int8_t *a = va, *b = vb;
-    int32_t *d = vd, *c = vc;
-
-    d[H4(i)] = c[H4(i)] + a[H1(i * 4)] * b[H1(i * 4)] +
-               a[H1(i * 4 + 1)] * b[H1(i * 4 + 1)] +
-               a[H1(i * 4 + 2)] * b[H1(i * 4 + 2)] +
-               a[H1(i * 4 + 3)] * b[H1(i * 4 + 3)];
-}
-
-RVPR_ACC(smaqa, 1, 4);
-
-static inline void do_umaqa(CPURISCVState *env, void *vd, void *va,
-                            void *vb, void *vc, uint8_t i)
-{
-    uint8_t *a = va, *b = vb;
-    uint32_t *d = vd, *c = vc;
-
-    d[H4(i)] = c[H4(i)] + a[H1(i * 4)] * b[H1(i * 4)] +
-               a[H1(i * 4 + 1)] * b[H1(i * 4 + 1)] +
-               a[H1(i * 4 + 2)] * b[H1(i * 4 + 2)] +
-               a[H1(i * 4 + 3)] * b[H1(i * 4 + 3)];
-}
-
-RVPR_ACC(umaqa, 1, 4);
-
-static inline void do_smaqa_su(CPURISCVState *env, void *vd, void *va,
-                               void *vb, void *vc, uint8_t i)
-{
-    int8_t *a = va;
-    uint8_t *b = vb;
-    int32_t *d = vd, *c = vc;
-
-    d[H4(i)] = c[H4(i)] + a[H1(i * 4)] * b[H1(i * 4)] +
-               a[H1(i * 4 + 1)] * b[H1(i * 4 + 1)] +
-               a[H1(i * 4 + 2)] * b[H1(i * 4 + 2)] +
-               a[H1(i * 4 + 3)] * b[H1(i * 4 + 3)];
-}
-
-RVPR_ACC(smaqa_su, 1, 4);
-
 /*
  *** 64-bit Profile Instructions
  */
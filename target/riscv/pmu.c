@@ -19,6 +19,7 @@
 #include "qemu/osdep.h"
 #include "qemu/log.h"
 #include "qemu/error-report.h"
+#include "qemu/host-utils.h"
 #include "qemu/timer.h"
 #include "cpu.h"
 #include "pmu.h"
@@ -27,6 +28,41 @@
 
 #define RISCV_TIMEBASE_FREQ 1000000000 /* 1Ghz */
 
+/*
+ * Cache and branch model
+ *
+ * With "pmu-cache-model", each hart gets a private two-level data cache
+ * (32KiB 8-way L1D, 2MiB 16-way last level, 64-byte lines, LRU) and a
+ * bimodal branch predictor. The caches are fed one in every
+ * "pmu-sample-period" loads and stores by the TCG memory sampler, and
+ * every event a sample produces counts for that many; as the sampler is
+ * shared, all harts must use the same period. Conditional
+ * branches all train the predictor, as they already go through a helper,
+ * but are only added to the counters in batches. Neither is meant to
+ * match real hardware, only to give guest profilers something to work
+ * with.
+ */
+#define PMU_MODEL_LINE_BITS     6
+#define PMU_MODEL_L1D_SETS      64
+#define PMU_MODEL_L1D_WAYS      8
+#define PMU_MODEL_LL_SETS       2048
+#define PMU_MODEL_LL_WAYS       16
+#define PMU_MODEL_BHT_SIZE      4096
+
+typedef struct RISCVPMUModel {
+    /* line numbers plus one, most recently used first; 0 is invalid */
+    uint64_t l1d[PMU_MODEL_L1D_SETS][PMU_MODEL_L1D_WAYS];
+    uint64_t ll[PMU_MODEL_LL_SETS][PMU_MODEL_LL_WAYS];
+    /* 2-bit saturating counters, taken when >= 2 */
+    uint8_t bht[PMU_MODEL_BHT_SIZE];
+    /* not yet added to the counters */
+    uint32_t branches;
+    uint32_t branch_misses;
+} RISCVPMUModel;
+
+/* "pmu-sample-period" shared by all harts with the model, 0 if none */
+static uint32_t pmu_model_period;
+
 /*
  * To keep it simple, any event can be mapped to any programmable counters in
  * QEMU. The generic cycle & instruction count events can also be monitored
@@ -36,7 +72,8 @@
  */
 void riscv_pmu_generate_fdt_node(void *fdt, uint32_t cmask, char *pmu_name)
 {
-    uint32_t fdt_event_ctr_map[15] = {};
+    uint32_t fdt_event_ctr_map[15 + 9] = {};
+    size_t fdt_event_ctr_map_size = 15 * sizeof(uint32_t);
 
    /*
     * The event encoding is specified in the SBI specification
@@ -74,9 +111,28 @@ void riscv_pmu_generate_fdt_node(void *fdt, uint32_t cmask, char *pmu_name)
    fdt_event_ctr_map[13] = cpu_to_be32(0x00010021);
    fdt_event_ctr_map[14] = cpu_to_be32(cmask);
 
+   if (pmu_model_period) {
+       /* SBI_PMU_HW_CACHE_REFERENCES .. SBI_PMU_HW_BRANCH_MISSES */
+       fdt_event_ctr_map[15] = cpu_to_be32(0x00000003);
+       fdt_event_ctr_map[16] = cpu_to_be32(0x00000006);
+       fdt_event_ctr_map[17] = cpu_to_be32(cmask);
+
+       /* SBI_PMU_HW_CACHE_L1D : 0x00 READ/WRITE ACCESS/MISS type(0x01) */
+       fdt_event_ctr_map[18] = cpu_to_be32(0x00010000);
+       fdt_event_ctr_map[19] = cpu_to_be32(0x00010003);
+       fdt_event_ctr_map[20] = cpu_to_be32(cmask);
+
+       /* SBI_PMU_HW_CACHE_LL : 0x02 READ/WRITE ACCESS/MISS type(0x01) */
+       fdt_event_ctr_map[21] = cpu_to_be32(0x00010010);
+       fdt_event_ctr_map[22] = cpu_to_be32(0x00010013);
+       fdt_event_ctr_map[23] = cpu_to_be32(cmask);
+
+       fdt_event_ctr_map_size = sizeof(fdt_event_ctr_map);
+   }
+
    /* This a OpenSBI specific DT property documented in OpenSBI docs */
    qemu_fdt_setprop(fdt, pmu_name, "riscv,event-to-mhpmcounters",
-                    fdt_event_ctr_map, sizeof(fdt_event_ctr_map));
+                    fdt_event_ctr_map, fdt_event_ctr_map_size);
 }
 
 static bool riscv_pmu_counter_valid(RISCVCPU *cpu, uint32_t ctr_idx)
@@ -101,12 +157,13 @@ static bool riscv_pmu_counter_enabled(RISCVCPU *cpu, uint32_t ctr_idx)
     }
 }
 
-static int riscv_pmu_incr_ctr_rv32(RISCVCPU *cpu, uint32_t ctr_idx)
+static int riscv_pmu_incr_ctr_rv32(RISCVCPU *cpu, uint32_t ctr_idx,
+                                   uint64_t delta)
 {
     CPURISCVState *env = &cpu->env;
-    target_ulong max_val = UINT32_MAX;
     PMUCTRState *counter = &env->pmu_ctrs[ctr_idx];
     bool virt_on = env->virt_enabled;
+    uint64_t val;
 
     /* Privilege mode filtering */
     if ((env->priv == PRV_M &&
@@ -123,31 +180,28 @@ static int riscv_pmu_incr_ctr_rv32(RISCVCPU *cpu, uint32_t ctr_idx)
     }
 
     /* Handle the overflow scenario */
-    if (counter->mhpmcounter_val == max_val) {
-        if (counter->mhpmcounterh_val == max_val) {
-            counter->mhpmcounter_val = 0;
-            counter->mhpmcounterh_val = 0;
-            /* Generate interrupt only if OF bit is clear */
-            if (!(env->mhpmeventh_val[ctr_idx] & MHPMEVENTH_BIT_OF)) {
-                env->mhpmeventh_val[ctr_idx] |= MHPMEVENTH_BIT_OF;
-                riscv_cpu_update_mip(env, MIP_LCOFIP, BOOL_TO_MASK(1));
-            }
-        } else {
-            counter->mhpmcounterh_val++;
+    val = deposit64((uint32_t)counter->mhpmcounter_val, 32, 32,
+                    counter->mhpmcounterh_val);
+    if (uadd64_overflow(val, delta, &val)) {
+        /* Generate interrupt only if OF bit is clear */
+        if (!(env->mhpmeventh_val[ctr_idx] & MHPMEVENTH_BIT_OF)) {
+            env->mhpmeventh_val[ctr_idx] |= MHPMEVENTH_BIT_OF;
+            riscv_cpu_update_mip(env, MIP_LCOFIP, BOOL_TO_MASK(1));
         }
-    } else {
-        counter->mhpmcounter_val++;
     }
+    counter->mhpmcounter_val = (uint32_t)val;
+    counter->mhpmcounterh_val = val >> 32;
 
     return 0;
 }
 
-static int riscv_pmu_incr_ctr_rv64(RISCVCPU *cpu, uint32_t ctr_idx)
+static int riscv_pmu_incr_ctr_rv64(RISCVCPU *cpu, uint32_t ctr_idx,
+                                   uint64_t delta)
 {
     CPURISCVState *env = &cpu->env;
     PMUCTRState *counter = &env->pmu_ctrs[ctr_idx];
-    uint64_t max_val = UINT64_MAX;
     bool virt_on = env->virt_enabled;
+    uint64_t val;
 
     /* Privilege mode filtering */
     if ((env->priv == PRV_M &&
@@ -164,16 +218,14 @@ static int riscv_pmu_incr_ctr_rv64(RISCVCPU *cpu, uint32_t ctr_idx)
     }
 
     /* Handle the overflow scenario */
-    if (counter->mhpmcounter_val == max_val) {
-        counter->mhpmcounter_val = 0;
+    if (uadd64_overflow(counter->mhpmcounter_val, delta, &val)) {
         /* Generate interrupt only if OF bit is clear */
         if (!(env->mhpmevent_val[ctr_idx] & MHPMEVENT_BIT_OF)) {
             env->mhpmevent_val[ctr_idx] |= MHPMEVENT_BIT_OF;
             riscv_cpu_update_mip(env, MIP_LCOFIP, BOOL_TO_MASK(1));
         }
-    } else {
-        counter->mhpmcounter_val++;
     }
+    counter->mhpmcounter_val = val;
     return 0;
 }
 
@@ -264,11 +316,14 @@ static void riscv_pmu_cycle_update_priv(CPURISCVState *env,
 void riscv_pmu_update_fixed_ctrs(CPURISCVState *env, target_ulong newpriv,
                                  bool new_virt)
 {
+    /* Pending branches belong to the mode being left */
+    riscv_pmu_model_flush(env);
     riscv_pmu_cycle_update_priv(env, newpriv, new_virt);
     riscv_pmu_icount_update_priv(env, newpriv, new_virt);
 }
 
-int riscv_pmu_incr_ctr(RISCVCPU *cpu, enum riscv_pmu_event_idx event_idx)
+static int riscv_pmu_add_ctr(RISCVCPU *cpu, enum riscv_pmu_event_idx event_idx,
+                             uint64_t delta)
 {
     uint32_t ctr_idx;
     int ret;
@@ -290,14 +345,114 @@ int riscv_pmu_incr_ctr(RISCVCPU *cpu, enum riscv_pmu_event_idx event_idx)
     }
 
     if (riscv_cpu_mxl(env) == MXL_RV32) {
-        ret = riscv_pmu_incr_ctr_rv32(cpu, ctr_idx);
+        ret = riscv_pmu_incr_ctr_rv32(cpu, ctr_idx, delta);
     } else {
-        ret = riscv_pmu_incr_ctr_rv64(cpu, ctr_idx);
+        ret = riscv_pmu_incr_ctr_rv64(cpu, ctr_idx, delta);
     }
 
     return ret;
 }
 
+int riscv_pmu_incr_ctr(RISCVCPU *cpu, enum riscv_pmu_event_idx event_idx)
+{
+    return riscv_pmu_add_ctr(cpu, event_idx, 1);
+}
+
+/* Look up @line in a set, making it the most recently used way */
+static bool pmu_model_cache_access(uint64_t *ways, unsigned int nways,
+                                   uint64_t line)
+{
+    unsigned int i;
+    bool hit;
+
+    for (i = 0; i < nways - 1 && ways[i] != line; i++) {
+        continue;
+    }
+    hit = ways[i] == line;
+    memmove(&ways[1], &ways[0], i * sizeof(*ways));
+    ways[0] = line;
+    return hit;
+}
+
+static void riscv_pmu_mem_sample(void *opaque, CPURISCVState *env,
+                                 hwaddr paddr, unsigned size, bool is_store,
+                                 uint32_t weight)
+{
+    RISCVCPU *cpu = env_archcpu(env);
+    RISCVPMUModel *model = cpu->pmu_model;
+    uint64_t line = (paddr >> PMU_MODEL_LINE_BITS) + 1;
+
+    if (!model) {
+        return;
+    }
+
+    riscv_pmu_add_ctr(cpu, is_store ? RISCV_PMU_EVENT_CACHE_L1D_WRITE_ACCESS :
+                                      RISCV_PMU_EVENT_CACHE_L1D_READ_ACCESS,
+                      weight);
+    if (pmu_model_cache_access(model->l1d[line % PMU_MODEL_L1D_SETS],
+                               PMU_MODEL_L1D_WAYS, line)) {
+        return;
+    }
+    riscv_pmu_add_ctr(cpu, is_store ? RISCV_PMU_EVENT_CACHE_L1D_WRITE_MISS :
+                                      RISCV_PMU_EVENT_CACHE_L1D_READ_MISS,
+                      weight);
+
+    riscv_pmu_add_ctr(cpu, RISCV_PMU_EVENT_HW_CACHE_REFERENCES, weight);
+    riscv_pmu_add_ctr(cpu, is_store ? RISCV_PMU_EVENT_CACHE_LL_WRITE_ACCESS :
+                                      RISCV_PMU_EVENT_CACHE_LL_READ_ACCESS,
+                      weight);
+    if (pmu_model_cache_access(model->ll[line % PMU_MODEL_LL_SETS],
+                               PMU_MODEL_LL_WAYS, line)) {
+        return;
+    }
+    riscv_pmu_add_ctr(cpu, RISCV_PMU_EVENT_HW_CACHE_MISSES, weight);
+    riscv_pmu_add_ctr(cpu, is_store ? RISCV_PMU_EVENT_CACHE_LL_WRITE_MISS :
+                                      RISCV_PMU_EVENT_CACHE_LL_READ_MISS,
+                      weight);
+}
+
+void riscv_pmu_model_flush(CPURISCVState *env)
+{
+    RISCVCPU *cpu = env_archcpu(env);
+    RISCVPMUModel *model = cpu->pmu_model;
+
+    if (!model || !model->branches) {
+        return;
+    }
+
+    riscv_pmu_add_ctr(cpu, RISCV_PMU_EVENT_HW_BRANCH_INSTRUCTIONS,
+                      model->branches);
+    riscv_pmu_add_ctr(cpu, RISCV_PMU_EVENT_HW_BRANCH_MISSES,
+                      model->branch_misses);
+    model->branches = 0;
+    model->branch_misses = 0;
+}
+
+void riscv_pmu_branch(CPURISCVState *env, target_ulong pc, bool taken)
+{
+    RISCVCPU *cpu = env_archcpu(env);
+    RISCVPMUModel *model = cpu->pmu_model;
+    uint8_t *state;
+
+    if (!model) {
+        return;
+    }
+
+    state = &model->bht[(pc >> 1) % PMU_MODEL_BHT_SIZE];
+    if ((*state >= 2) != taken) {
+        model->branch_misses++;
+    }
+    if (taken) {
+        *state = MIN(*state + 1, 3);
+    } else if (*state) {
+        *state -= 1;
+    }
+
+    if (++model->branches >= cpu->cfg.pmu_sample_period) {
+        riscv_pmu_model_flush(env);
+    }
+}
+
 bool riscv_pmu_ctr_monitor_instructions(CPURISCVState *env,
                                         uint32_t target_ctr)
 {
@@ -406,6 +561,22 @@ int riscv_pmu_update_event_map(CPURISCVState *env, uint64_t value,
     case RISCV_PMU_EVENT_CACHE_DTLB_WRITE_MISS:
     case RISCV_PMU_EVENT_CACHE_ITLB_PREFETCH_MISS:
         break;
+    case RISCV_PMU_EVENT_HW_CACHE_REFERENCES:
+    case RISCV_PMU_EVENT_HW_CACHE_MISSES:
+    case RISCV_PMU_EVENT_HW_BRANCH_INSTRUCTIONS:
+    case RISCV_PMU_EVENT_HW_BRANCH_MISSES:
+    case RISCV_PMU_EVENT_CACHE_L1D_READ_ACCESS:
+    case RISCV_PMU_EVENT_CACHE_L1D_READ_MISS:
+    case RISCV_PMU_EVENT_CACHE_L1D_WRITE_ACCESS:
+    case RISCV_PMU_EVENT_CACHE_L1D_WRITE_MISS:
+    case RISCV_PMU_EVENT_CACHE_LL_READ_ACCESS:
+    case RISCV_PMU_EVENT_CACHE_LL_READ_MISS:
+    case RISCV_PMU_EVENT_CACHE_LL_WRITE_ACCESS:
+    case RISCV_PMU_EVENT_CACHE_LL_WRITE_MISS:
+        if (cpu->pmu_model) {
+            break;
+        }
+        return -1;
     default:
         /* We don't support any raw events right now */
         return -1;
@@ -561,4 +732,30 @@ void riscv_pmu_init(RISCVCPU *cpu, Error **errp)
     }
 
     cpu->pmu_avail_ctrs = cpu->cfg.pmu_mask;
+
+    if (cpu->cfg.pmu_cache_model) {
+        if (cpu->cfg.pmu_sample_period == 0 ||
+            cpu->cfg.pmu_sample_period > INT32_MAX) {
+            error_setg(errp, "\"pmu-sample-period\" must be between 1 and %d",
+                       INT32_MAX);
+            return;
+        }
+
+        /* The memory sampler, and so the sample weight, is machine-wide */
+        if (pmu_model_period &&
+            cpu->cfg.pmu_sample_period != pmu_model_period) {
+            error_setg(errp, "\"pmu-sample-period\" must be the same on all "
+                       "harts (%u)", pmu_model_period);
+            return;
+        }
+
+        if (!pmu_model_period) {
+            if (!riscv_cpu_add_mem_sampler(riscv_pmu_mem_sample, NULL,
+                                           cpu->cfg.pmu_sample_period, errp)) {
+                return;
+            }
+            pmu_model_period = cpu->cfg.pmu_sample_period;
+        }
+        cpu->pmu_model = g_new0(RISCVPMUModel, 1);
+    }
 }
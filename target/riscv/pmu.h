@@ -38,5 +38,7 @@ void riscv_pmu_update_fixed_ctrs(CPURISCVState *env, target_ulong newpriv,
                                  bool new_virt);
 RISCVException riscv_pmu_read_ctr(CPURISCVState *env, target_ulong *val,
                                   bool upper_half, uint32_t ctr_idx);
+void riscv_pmu_branch(CPURISCVState *env, target_ulong pc, bool taken);
+void riscv_pmu_model_flush(CPURISCVState *env);
 
 #endif /* RISCV_PMU_H */
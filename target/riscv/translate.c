@@ -33,6 +33,7 @@
 
 #include "instmap.h"
 #include "internals.h"
+#include "cpu_vendorid.h"
 
 #define HELPER_H "helper.h"
 #include "exec/helper-info.c.inc"
@@ -139,6 +140,8 @@ typedef struct DisasContext {
     bool ztso;
     /* Use icount trigger for native debug */
     bool itrigger;
+    /* Sample loads and stores, see riscv_cpu_add_mem_sampler() */
+    bool mem_sample;
     /* FRM is known to contain a valid value. */
     bool frm_valid;
     bool insn_start_updated;
@@ -811,6 +814,18 @@ static void finalize_rvv_inst(DisasContext *ctx)
     ctx->vstart_eq_zero = true;
 }
 
+/*
+ * A static rounding mode in [RNE, RMM] cannot trap, so it can be stored
+ * straight into fp_status without calling out to a helper.
+ */
+static void gen_store_softrm(int rm)
+{
+    tcg_gen_st8_i32(tcg_constant_i32(riscv_frm_to_softfloat(rm)), tcg_env,
+                    offsetof(CPURISCVState, fp_status.float_rounding_mode));
+    tcg_gen_st8_i32(tcg_constant_i32(false), tcg_env,
+                    offsetof(CPURISCVState, frm_synced));
+}
+
 static void gen_set_rm(DisasContext *ctx, int rm)
 {
     if (ctx->frm == rm) {
@@ -818,6 +833,11 @@ static void gen_set_rm(DisasContext *ctx, int rm)
     }
     ctx->frm = rm;
 
+    if (rm <= RISCV_FRM_RMM) {
+        gen_store_softrm(rm);
+        return;
+    }
+
     if (rm == RISCV_FRM_DYN) {
         /* The helper will return only if frm valid. */
         ctx->frm_valid = true;
@@ -833,6 +853,12 @@ static void gen_set_rm_chkfrm(DisasContext *ctx, int rm)
     if (ctx->frm == rm && ctx->frm_valid) {
         return;
     }
+    /* Once frm has been validated, only the mode itself needs setting. */
+    if (ctx->frm_valid && rm <= RISCV_FRM_RMM) {
+        ctx->frm = rm;
+        gen_store_softrm(rm);
+        return;
+    }
     ctx->frm = rm;
     ctx->frm_valid = true;
 
@@ -1054,8 +1080,38 @@ static bool gen_arith(DisasContext *ctx, arg_r *a, DisasExtend ext,
     return true;
 }
 
+static void gen_mem_sample(DisasContext *ctx, TCGv addr, int memop,
+                           bool is_store)
+{
+#ifndef CONFIG_USER_ONLY
+    TCGv_i32 count;
+    TCGLabel *skip;
+    uint32_t desc;
+
+    if (!ctx->mem_sample) {
+        return;
+    }
+
+    count = tcg_temp_new_i32();
+    skip = gen_new_label();
+    tcg_gen_ld_i32(count, tcg_env,
+                   offsetof(CPURISCVState, mem_sample_countdown));
+    tcg_gen_subi_i32(count, count, 1);
+    tcg_gen_st_i32(count, tcg_env,
+                   offsetof(CPURISCVState, mem_sample_countdown));
+    tcg_gen_brcondi_i32(TCG_COND_GT, count, 0, skip);
+
+    desc = deposit32(ctx->mem_idx, 8, 3, memop & MO_SIZE);
+    desc = deposit32(desc, 12, 1, is_store);
+    gen_helper_mem_sample(tcg_env, addr, tcg_constant_i32(desc));
+    gen_set_label(skip);
+#endif
+}
+
 static void gen_load_internal(DisasContext *ctx, int memop, TCGv t1, TCGv t0)
 {
+    gen_mem_sample(ctx, t0, memop, false);
+
     if (gen_mem_trace()) {
         gen_update_pc(ctx, 0);
         switch (memop) {
@@ -1088,6 +1144,8 @@ static void gen_load_internal(DisasContext *ctx, int memop, TCGv t1, TCGv t0)
 
 static void gen_store_internal(DisasContext *ctx, int memop, TCGv dat, TCGv t0)
 {
+    gen_mem_sample(ctx, t0, memop, true);
+
     if (gen_mem_trace()) {
         gen_update_pc(ctx, 0);
         switch (memop) {
@@ -1448,7 +1506,14 @@ static void riscv_tr_init_disas_context(DisasContextBase *dcbase, CPUState *cs)
     ctx->priv_ver = env->priv_ver;
     ctx->virt_enabled = EX_TBFLAGS_ANY(tb_flags, VIRT_ENABLED);
     ctx->misa_ext = env->misa_ext;
-    ctx->frm = -1;  /* unknown rounding mode */
+    if (EX_TBFLAGS_ANY(tb_flags, FRM_DYN)) {
+        /* fp_status already matches a validated frm */
+        ctx->frm = RISCV_FRM_DYN;
+        ctx->frm_valid = true;
+    } else {
+        ctx->frm = -1;  /* unknown rounding mode */
+        ctx->frm_valid = false;
+    }
     ctx->cfg_ptr = &(cpu->cfg);
     ctx->vill = EX_TBFLAGS_ANY(tb_flags, VILL);
     ctx->sew = EX_TBFLAGS_ANY(tb_flags, SEW);
@@ -1472,6 +1537,9 @@ static void riscv_tr_init_disas_context(DisasContextBase *dcbase, CPUState *cs)
     }
     ctx->ztso = cpu->cfg.ext_ztso;
     ctx->itrigger = EX_TBFLAGS_ANY(tb_flags, ITRIGGER);
+#ifndef CONFIG_USER_ONLY
+    ctx->mem_sample = riscv_cpu_mem_sample_period() != 0;
+#endif
     ctx->zero = tcg_constant_tl(0);
     ctx->virt_inst_excp = false;
     ctx->decoders = cpu->decoders;
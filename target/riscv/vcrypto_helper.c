@@ -24,6 +24,8 @@
 #include "cpu.h"
 #include "crypto/aes.h"
 #include "crypto/aes-round.h"
+#include "crypto/clmul.h"
+#include "crypto/sha256.h"
 #include "crypto/sm4.h"
 #include "exec/memop.h"
 #include "exec/exec-all.h"
@@ -33,24 +35,12 @@
 
 static uint64_t clmul64(uint64_t y, uint64_t x)
 {
-    uint64_t result = 0;
-    for (int j = 63; j >= 0; j--) {
-        if ((y >> j) & 1) {
-            result ^= (x << j);
-        }
-    }
-    return result;
+    return int128_getlo(clmul_64(y, x));
 }
 
 static uint64_t clmulh64(uint64_t y, uint64_t x)
 {
-    uint64_t result = 0;
-    for (int j = 63; j >= 1; j--) {
-        if ((y >> j) & 1) {
-            result ^= (x >> (64 - j));
-        }
-    }
-    return result;
+    return int128_gethi(clmul_64(y, x));
 }
 
 RVVCALL(OPIVV2, vclmul_vv_d, OP_UUU_D, H8, H8, H8, clmul64)
@@ -64,24 +54,12 @@ GEN_VEXT_VX(vclmulh_vx_d, 8)
 
 static uint32_t clmul32(uint32_t y, uint32_t x)
 {
-    uint32_t result = 0;
-    for (int j = 31; j >= 0; j--) {
-        if ((y >> j) & 1) {
-            result ^= (x << j);
-        }
-    }
-    return result;
+    return int128_getlo(clmul_64(y, x));
 }
 
 static uint32_t clmulh32(uint32_t y, uint32_t x)
 {
-    uint32_t result = 0;
-    for (int j = 31; j >= 1; j--) {
-        if ((y >> j) & 1) {
-            result ^= (x >> (32 - j));
-        }
-    }
-    return result;
+    return int128_getlo(clmul_64(y, x)) >> 32;
 }
 
 RVVCALL(OPIVV2, vclmul_vv_w, OP_UUU_W, H4, H4, H4, clmul32)
@@ -461,6 +439,12 @@ static inline uint64_t sig1_sha512(uint64_t x)
 static inline void vsha2ms_e32(uint32_t *vd, uint32_t *vs1, uint32_t *vs2)
 {
     uint32_t res[4];
+
+    if (HAVE_SHA256_SCHED_ACCEL && !HOST_BIG_ENDIAN) {
+        sha256_sched_accel(vd, vs2, vs1);
+        return;
+    }
+
     res[0] = sig1_sha256(vs1[H4(2)]) + vs2[H4(1)] + sig0_sha256(vd[H4(1)]) +
              vd[H4(0)];
     res[1] = sig1_sha256(vs1[H4(3)]) + vs2[H4(2)] + sig0_sha256(vd[H4(2)]) +
@@ -577,8 +561,16 @@ static void vsha2c_32(uint32_t *vs2, uint32_t *vd, uint32_t *vs1)
     uint32_t a = vs2[H4(3)], b = vs2[H4(2)], e = vs2[H4(1)], f = vs2[H4(0)];
     uint32_t c = vd[H4(3)], d = vd[H4(2)], g = vd[H4(1)], h = vd[H4(0)];
     uint32_t W0 = vs1[H4(0)], W1 = vs1[H4(1)];
-    uint32_t T1 = h + sum1_32(e) + ch(e, f, g) + W0;
-    uint32_t T2 = sum0_32(a) + maj(a, b, c);
+    uint32_t T1, T2;
+
+    /* vs2 and vd are already in the {ABEF, CDGH} layout of SHA-NI. */
+    if (HAVE_SHA256_ROUND_ACCEL && !HOST_BIG_ENDIAN) {
+        sha256_2rounds_accel(vd, vs2, vs1);
+        return;
+    }
+
+    T1 = h + sum1_32(e) + ch(e, f, g) + W0;
+    T2 = sum0_32(a) + maj(a, b, c);
 
     h = g;
     g = f;
@@ -824,6 +816,34 @@ void HELPER(vsm3c_vi)(void *vd_vptr, void *vs2_vptr, uint32_t uimm,
     env->vstart = 0;
 }
 
+/*
+ * Z = S * H in GF(2^128) modulo x^128 + x^7 + x^2 + x + 1, where bit j of
+ * {S[1]:S[0]} is the coefficient of x^j (i.e. the operands have already
+ * been passed through brev8).  The 256-bit product is formed with four
+ * 64x64 carry-less multiplies and then folded back in two steps.
+ */
+static void gf128_mul(uint64_t *Z, const uint64_t *S, const uint64_t *H)
+{
+    Int128 lo = clmul_64(S[0], H[0]);
+    Int128 hi = clmul_64(S[1], H[1]);
+    Int128 mid = int128_xor(clmul_64(S[0], H[1]), clmul_64(S[1], H[0]));
+    uint64_t p0 = int128_getlo(lo);
+    uint64_t p1 = int128_gethi(lo) ^ int128_getlo(mid);
+    uint64_t p2 = int128_getlo(hi) ^ int128_gethi(mid);
+    uint64_t p3 = int128_gethi(hi);
+    Int128 t;
+
+    t = clmul_64(p3, 0x87);
+    p1 ^= int128_getlo(t);
+    p2 ^= int128_gethi(t);
+    t = clmul_64(p2, 0x87);
+    p0 ^= int128_getlo(t);
+    p1 ^= int128_gethi(t);
+
+    Z[0] = p0;
+    Z[1] = p1;
+}
+
 void HELPER(vghsh_vv)(void *vd_vptr, void *vs1_vptr, void *vs2_vptr,
                       CPURISCVState *env, uint32_t desc)
 {
@@ -839,22 +859,11 @@ void HELPER(vghsh_vv)(void *vd_vptr, void *vs1_vptr, void *vs2_vptr,
         uint64_t Y[2] = {vd[i * 2 + 0], vd[i * 2 + 1]};
         uint64_t H[2] = {brev8(vs2[i * 2 + 0]), brev8(vs2[i * 2 + 1])};
         uint64_t X[2] = {vs1[i * 2 + 0], vs1[i * 2 + 1]};
-        uint64_t Z[2] = {0, 0};
+        uint64_t Z[2];
 
         uint64_t S[2] = {brev8(Y[0] ^ X[0]), brev8(Y[1] ^ X[1])};
 
-        for (int j = 0; j < 128; j++) {
-            if ((S[j / 64] >> (j % 64)) & 1) {
-                Z[0] ^= H[0];
-                Z[1] ^= H[1];
-            }
-            bool reduce = ((H[1] >> 63) & 1);
-            H[1] = H[1] << 1 | H[0] >> 63;
-            H[0] = H[0] << 1;
-            if (reduce) {
-                H[0] ^= 0x87;
-            }
-        }
+        gf128_mul(Z, S, H);
 
         vd[i * 2 + 0] = brev8(Z[0]);
         vd[i * 2 + 1] = brev8(Z[1]);
@@ -877,20 +886,9 @@ void HELPER(vgmul_vv)(void *vd_vptr, void *vs2_vptr, CPURISCVState *env,
     for (uint32_t i = env->vstart / 4; i < env->vl / 4; i++) {
         uint64_t Y[2] = {brev8(vd[i * 2 + 0]), brev8(vd[i * 2 + 1])};
         uint64_t H[2] = {brev8(vs2[i * 2 + 0]), brev8(vs2[i * 2 + 1])};
-        uint64_t Z[2] = {0, 0};
+        uint64_t Z[2];
 
-        for (int j = 0; j < 128; j++) {
-            if ((Y[j / 64] >> (j % 64)) & 1) {
-                Z[0] ^= H[0];
-                Z[1] ^= H[1];
-            }
-            bool reduce = ((H[1] >> 63) & 1);
-            H[1] = H[1] << 1 | H[0] >> 63;
-            H[0] = H[0] << 1;
-            if (reduce) {
-                H[0] ^= 0x87;
-            }
-        }
+        gf128_mul(Z, Y, H);
 
         vd[i * 2 + 0] = brev8(Z[0]);
         vd[i * 2 + 1] = brev8(Z[1]);
@@ -948,22 +946,11 @@ void HELPER(vghsh_vs)(void *vd_vptr, void *vs1_vptr, void *vs2_vptr,
         uint64_t Y[2] = {vd[i * 2 + 0], vd[i * 2 + 1]};
         uint64_t X[2] = {vs1[i * 2 + 0], vs1[i * 2 + 1]};
         uint64_t H[2] = {brev8(vs2[helem * 2]), brev8(vs2[helem * 2 + 1])};
-        uint64_t Z[2] = {0, 0};
+        uint64_t Z[2];
 
         uint64_t S[2] = {brev8(Y[0] ^ X[0]), brev8(Y[1] ^ X[1])};
 
-        for (int j = 0; j < 128; j++) {
-            if ((S[j / 64] >> (j % 64)) & 1) {
-                Z[0] ^= H[0];
-                Z[1] ^= H[1];
-            }
-            bool reduce = ((H[1] >> 63) & 1);
-            H[1] = H[1] << 1 | H[0] >> 63;
-            H[0] = H[0] << 1;
-            if (reduce) {
-                H[0] ^= 0x87;
-            }
-        }
+        gf128_mul(Z, S, H);
 
         vd[i * 2 + 0] = brev8(Z[0]);
         vd[i * 2 + 1] = brev8(Z[1]);
@@ -987,20 +974,9 @@ void HELPER(vgmul_vs)(void *vd_vptr, void *vs2_vptr, CPURISCVState *env,
     for (uint32_t i = env->vstart / 4; i < env->vl / 4; i++) {
         uint64_t Y[2] = {brev8(vd[i * 2 + 0]), brev8(vd[i * 2 + 1])};
         uint64_t H[2] = {brev8(vs2[helem * 2]), brev8(vs2[helem * 2 + 1])};
-        uint64_t Z[2] = {0, 0};
+        uint64_t Z[2];
 
-        for (int j = 0; j < 128; j++) {
-            if ((Y[j / 64] >> (j % 64)) & 1) {
-                Z[0] ^= H[0];
-                Z[1] ^= H[1];
-            }
-            bool reduce = ((H[1] >> 63) & 1);
-            H[1] = H[1] << 1 | H[0] >> 63;
-            H[0] = H[0] << 1;
-            if (reduce) {
-                H[0] ^= 0x87;
-            }
-        }
+        gf128_mul(Z, Y, H);
 
         vd[i * 2 + 0] = brev8(Z[0]);
         vd[i * 2 + 1] = brev8(Z[1]);
@@ -71,6 +71,7 @@ target_ulong HELPER(vsetvl)(CPURISCVState *env, target_ulong s1,
         env->vtype = 0;
         env->vl = 0;
         env->vstart = 0;
+        riscv_cpu_update_vl_mask(env);
         return 0;
     }
 
@@ -86,6 +87,7 @@ target_ulong HELPER(vsetvl)(CPURISCVState *env, target_ulong s1,
     env->vtype = s2;
     env->vstart = 0;
     env->vill = 0;
+    riscv_cpu_update_vl_mask(env);
     if (gen_x_lmul_trace()) {
         write_trace_8(INST_VECTOR_LMUL, sizeof(uint32_t), vlmul);
     }
@@ -148,9 +150,6 @@ static inline void vext_set_elem_mask(void *v0, int index,
 }
 
 /* elements operations for load and store */
-typedef void vext_ldst_elem_fn(CPURISCVState *env, abi_ptr addr,
-                               uint32_t idx, void *vd, uintptr_t retaddr);
-
 #define GEN_VEXT_LD_ELEM(NAME, ETYPE, H, LDSUF)            \
 static void NAME(CPURISCVState *env, abi_ptr addr,         \
                  uint32_t idx, void *vd, uintptr_t retaddr)\
@@ -158,6 +157,13 @@ static void NAME(CPURISCVState *env, abi_ptr addr,         \
     ETYPE *cur = ((ETYPE *)vd + H(idx));                   \
     *cur = cpu_##LDSUF##_data_ra(env, addr, retaddr);      \
 }                                                          \
+                                                           \
+static inline QEMU_ALWAYS_INLINE                           \
+void NAME##_host(void *vd, uint32_t idx, void *host)       \
+{                                                          \
+    ETYPE *cur = ((ETYPE *)vd + H(idx));                   \
+    *cur = LDSUF##_p(host);                                \
+}
 
 GEN_VEXT_LD_ELEM(lde_b, int8_t,  H1, ldsb)
 GEN_VEXT_LD_ELEM(lde_h, int16_t, H2, ldsw)
@@ -170,6 +176,13 @@ static void NAME(CPURISCVState *env, abi_ptr addr,         \
 {                                                          \
     ETYPE data = *((ETYPE *)vd + H(idx));                  \
     cpu_##STSUF##_data_ra(env, addr, data, retaddr);       \
+}                                                          \
+                                                           \
+static inline QEMU_ALWAYS_INLINE                           \
+void NAME##_host(void *vd, uint32_t idx, void *host)       \
+{                                                          \
+    ETYPE data = *((ETYPE *)vd + H(idx));                  \
+    STSUF##_p(host, data);                                 \
 }
 
 GEN_VEXT_ST_ELEM(ste_b, int8_t,  H1, stb)
@@ -267,27 +280,19 @@ GEN_VEXT_ST_STRIDE(vsse64_v, int64_t, ste_d)
  */
 
 /* unmasked unit-stride load and store operation */
-static void
+static inline QEMU_ALWAYS_INLINE void
 vext_ldst_us(void *vd, target_ulong base, CPURISCVState *env, uint32_t desc,
-             vext_ldst_elem_fn *ldst_elem, uint32_t log2_esz, uint32_t evl,
-             uintptr_t ra)
+             vext_ldst_elem_fn *ldst_elem, vext_ldst_elem_fn_host *ldst_host,
+             uint32_t log2_esz, uint32_t evl, uintptr_t ra, bool is_load)
 {
-    uint32_t i, k;
     uint32_t nf = vext_nf(desc);
     uint32_t max_elems = vext_max_elems(desc, log2_esz);
     uint32_t esz = 1 << log2_esz;
 
     VSTART_CHECK_EARLY_EXIT(env);
 
-    /* load bytes from guest memory */
-    for (i = env->vstart; i < evl; env->vstart = ++i) {
-        k = 0;
-        while (k < nf) {
-            target_ulong addr = base + ((i * nf + k) << log2_esz);
-            ldst_elem(env, adjust_addr(env, addr), i + k * max_elems, vd, ra);
-            k++;
-        }
-    }
+    vext_ldst_contig(env, vd, base, evl, nf, max_elems, esz, esz, is_load,
+                     ldst_elem, ldst_host, ra);
     env->vstart = 0;
 
     vext_set_tail_elems_1s(evl, vd, desc, nf, esz, max_elems);
@@ -310,8 +315,8 @@ void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,         \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,                \
                   CPURISCVState *env, uint32_t desc)                    \
 {                                                                       \
-    vext_ldst_us(vd, base, env, desc, LOAD_FN,                          \
-                 ctzl(sizeof(ETYPE)), env->vl, GETPC());                \
+    vext_ldst_us(vd, base, env, desc, LOAD_FN, LOAD_FN##_host,          \
+                 ctzl(sizeof(ETYPE)), env->vl, GETPC(), true);          \
 }
 
 GEN_VEXT_LD_US(vle8_v,  int8_t,  lde_b)
@@ -331,8 +336,8 @@ void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,          \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,                 \
                   CPURISCVState *env, uint32_t desc)                     \
 {                                                                        \
-    vext_ldst_us(vd, base, env, desc, STORE_FN,                          \
-                 ctzl(sizeof(ETYPE)), env->vl, GETPC());                 \
+    vext_ldst_us(vd, base, env, desc, STORE_FN, STORE_FN##_host,         \
+                 ctzl(sizeof(ETYPE)), env->vl, GETPC(), false);          \
 }
 
 GEN_VEXT_ST_US(vse8_v,  int8_t,  ste_b)
@@ -348,8 +353,8 @@ void HELPER(vlm_v)(void *vd, void *v0, target_ulong base,
 {
     /* evl = ceil(vl/8) */
     uint8_t evl = (env->vl + 7) >> 3;
-    vext_ldst_us(vd, base, env, desc, lde_b,
-                 0, evl, GETPC());
+    vext_ldst_us(vd, base, env, desc, lde_b, lde_b_host,
+                 0, evl, GETPC(), true);
 }
 
 void HELPER(vsm_v)(void *vd, void *v0, target_ulong base,
@@ -357,8 +362,8 @@ void HELPER(vsm_v)(void *vd, void *v0, target_ulong base,
 {
     /* evl = ceil(vl/8) */
     uint8_t evl = (env->vl + 7) >> 3;
-    vext_ldst_us(vd, base, env, desc, ste_b,
-                 0, evl, GETPC());
+    vext_ldst_us(vd, base, env, desc, ste_b, ste_b_host,
+                 0, evl, GETPC(), false);
 }
 
 /*
@@ -527,6 +532,7 @@ ProbeSuccess:
     /* load bytes from guest memory */
     if (vl != 0) {
         env->vl = vl;
+        riscv_cpu_update_vl_mask(env);
     }
     for (i = env->vstart; i < env->vl; i++) {
         k = 0;
@@ -574,50 +580,31 @@ GEN_VEXT_LDFF(vle64ff_v, int64_t, lde_d)
 /*
  * load and store whole register instructions
  */
-static void
+static inline QEMU_ALWAYS_INLINE void
 vext_ldst_whole(void *vd, target_ulong base, CPURISCVState *env, uint32_t desc,
-                vext_ldst_elem_fn *ldst_elem, uint32_t log2_esz, uintptr_t ra)
+                vext_ldst_elem_fn *ldst_elem,
+                vext_ldst_elem_fn_host *ldst_host, uint32_t log2_esz,
+                uintptr_t ra, bool is_load)
 {
-    uint32_t i, k, off, pos;
     uint32_t nf = vext_nf(desc);
     uint32_t vlenb = riscv_cpu_cfg(env)->vlenb;
-    uint32_t max_elems = vlenb >> log2_esz;
-
-    if (env->vstart >= ((vlenb * nf) >> log2_esz)) {
-        env->vstart = 0;
-        return;
-    }
-
-    k = env->vstart / max_elems;
-    off = env->vstart % max_elems;
-
-    if (off) {
-        /* load/store rest of elements of current segment pointed by vstart */
-        for (pos = off; pos < max_elems; pos++, env->vstart++) {
-            target_ulong addr = base + ((pos + k * max_elems) << log2_esz);
-            ldst_elem(env, adjust_addr(env, addr), pos + k * max_elems, vd,
-                      ra);
-        }
-        k++;
-    }
-
-    /* load/store elements for rest of segments */
-    for (; k < nf; k++) {
-        for (i = 0; i < max_elems; i++, env->vstart++) {
-            target_ulong addr = base + ((i + k * max_elems) << log2_esz);
-            ldst_elem(env, adjust_addr(env, addr), i + k * max_elems, vd, ra);
-        }
-    }
+    uint32_t esz = 1 << log2_esz;
 
+    /*
+     * The registers of the group are contiguous in env->vreg, so this is
+     * a single-field access of all the elements of the group.
+     */
+    vext_ldst_contig(env, vd, base, (vlenb * nf) >> log2_esz, 1, 0,
+                     esz, esz, is_load, ldst_elem, ldst_host, ra);
     env->vstart = 0;
 }
 
-#define GEN_VEXT_LD_WHOLE(NAME, ETYPE, LOAD_FN)      \
-void HELPER(NAME)(void *vd, target_ulong base,       \
-                  CPURISCVState *env, uint32_t desc) \
-{                                                    \
-    vext_ldst_whole(vd, base, env, desc, LOAD_FN,    \
-                    ctzl(sizeof(ETYPE)), GETPC());   \
+#define GEN_VEXT_LD_WHOLE(NAME, ETYPE, LOAD_FN)                     \
+void HELPER(NAME)(void *vd, target_ulong base,                      \
+                  CPURISCVState *env, uint32_t desc)                \
+{                                                                   \
+    vext_ldst_whole(vd, base, env, desc, LOAD_FN, LOAD_FN##_host,   \
+                    ctzl(sizeof(ETYPE)), GETPC(), true);            \
 }
 
 GEN_VEXT_LD_WHOLE(vl1re8_v,  int8_t,  lde_b)
@@ -637,12 +624,12 @@ GEN_VEXT_LD_WHOLE(vl8re16_v, int16_t, lde_h)
 GEN_VEXT_LD_WHOLE(vl8re32_v, int32_t, lde_w)
 GEN_VEXT_LD_WHOLE(vl8re64_v, int64_t, lde_d)
 
-#define GEN_VEXT_ST_WHOLE(NAME, ETYPE, STORE_FN)     \
-void HELPER(NAME)(void *vd, target_ulong base,       \
-                  CPURISCVState *env, uint32_t desc) \
-{                                                    \
-    vext_ldst_whole(vd, base, env, desc, STORE_FN,   \
-                    ctzl(sizeof(ETYPE)), GETPC());   \
+#define GEN_VEXT_ST_WHOLE(NAME, ETYPE, STORE_FN)                    \
+void HELPER(NAME)(void *vd, target_ulong base,                      \
+                  CPURISCVState *env, uint32_t desc)                \
+{                                                                   \
+    vext_ldst_whole(vd, base, env, desc, STORE_FN, STORE_FN##_host, \
+                    ctzl(sizeof(ETYPE)), GETPC(), false);           \
 }
 
 GEN_VEXT_ST_WHOLE(vs1r_v, int8_t, ste_b)
@@ -21,6 +21,7 @@
 
 #include "qemu/bitops.h"
 #include "cpu.h"
+#include "exec/exec-all.h"
 #include "tcg/tcg-gvec-desc.h"
 #include "internals.h"
 
@@ -200,9 +201,43 @@ static void do_##NAME(void *vd, void *vs1, void *vs2, int i)    \
     *((TD *)vd + HD(i)) = OP(s2, s1);                           \
 }
 
-void do_vext_vv(void *vd, void *v0, void *vs1, void *vs2,
-                CPURISCVState *env, uint32_t desc,
-                opivv2_fn *fn, uint32_t esz);
+/*
+ * The element loops are inlined into each helper so that @fn is a direct
+ * call; without a mask the loop body is then just the element operation
+ * and is left for the compiler to vectorize.
+ */
+static inline QEMU_ALWAYS_INLINE void
+do_vext_vv(void *vd, void *v0, void *vs1, void *vs2,
+           CPURISCVState *env, uint32_t desc,
+           opivv2_fn *fn, uint32_t esz)
+{
+    uint32_t vm = vext_vm(desc);
+    uint32_t vl = env->vl;
+    uint32_t total_elems = vext_get_total_elems(env, desc, esz);
+    uint32_t vta = vext_vta(desc);
+    uint32_t vma = vext_vma(desc);
+    uint32_t i;
+
+    VSTART_CHECK_EARLY_EXIT(env);
+
+    if (vm) {
+        for (i = env->vstart; i < vl; i++) {
+            fn(vd, vs1, vs2, i);
+        }
+    } else {
+        for (i = env->vstart; i < vl; i++) {
+            if (!vext_elem_mask(v0, i)) {
+                /* set masked-off elements to 1s */
+                vext_set_elems_1s(vd, vma, i * esz, (i + 1) * esz);
+                continue;
+            }
+            fn(vd, vs1, vs2, i);
+        }
+    }
+    env->vstart = 0;
+    /* set tail elements to 1s */
+    vext_set_elems_1s(vd, vta, vl * esz, total_elems * esz);
+}
 
 /* generate the helpers for OPIVV */
 #define GEN_VEXT_VV(NAME, ESZ)                            \
@@ -227,9 +262,38 @@ static void do_##NAME(void *vd, target_long s1, void *vs2, int i)   \
     *((TD *)vd + HD(i)) = OP(s2, (TX1)(T1)s1);                      \
 }
 
-void do_vext_vx(void *vd, void *v0, target_long s1, void *vs2,
-                CPURISCVState *env, uint32_t desc,
-                opivx2_fn fn, uint32_t esz);
+static inline QEMU_ALWAYS_INLINE void
+do_vext_vx(void *vd, void *v0, target_long s1, void *vs2,
+           CPURISCVState *env, uint32_t desc,
+           opivx2_fn fn, uint32_t esz)
+{
+    uint32_t vm = vext_vm(desc);
+    uint32_t vl = env->vl;
+    uint32_t total_elems = vext_get_total_elems(env, desc, esz);
+    uint32_t vta = vext_vta(desc);
+    uint32_t vma = vext_vma(desc);
+    uint32_t i;
+
+    VSTART_CHECK_EARLY_EXIT(env);
+
+    if (vm) {
+        for (i = env->vstart; i < vl; i++) {
+            fn(vd, s1, vs2, i);
+        }
+    } else {
+        for (i = env->vstart; i < vl; i++) {
+            if (!vext_elem_mask(v0, i)) {
+                /* set masked-off elements to 1s */
+                vext_set_elems_1s(vd, vma, i * esz, (i + 1) * esz);
+                continue;
+            }
+            fn(vd, s1, vs2, i);
+        }
+    }
+    env->vstart = 0;
+    /* set tail elements to 1s */
+    vext_set_elems_1s(vd, vta, vl * esz, total_elems * esz);
+}
 
 /* generate the helpers for OPIVX */
 #define GEN_VEXT_VX(NAME, ESZ)                            \
@@ -296,6 +360,89 @@ void probe_pages(CPURISCVState *env, target_ulong addr,
                  target_ulong len, uintptr_t ra,
                  MMUAccessType access_type);
 
+/* elements operations for load and store */
+typedef void vext_ldst_elem_fn(CPURISCVState *env, abi_ptr addr,
+                               uint32_t idx, void *vd, uintptr_t retaddr);
+typedef void vext_ldst_elem_fn_host(void *vd, uint32_t idx, void *host);
+
+/*
+ * Contiguous (unit-stride, segment and whole register) accesses.
+ *
+ * Memory holds segments of @nf fields, each @msz bytes wide, and field k of
+ * segment i is element i + k * @max_elems of @vd, @esz bytes wide.  The
+ * segments from vstart to @evl are accessed.
+ *
+ * The segments that lie in one guest page are probed at once.  When the
+ * page is plain RAM they are accessed through the host pointer, without a
+ * softmmu lookup per element.  Otherwise (MMIO, watchpoints, faults, or
+ * plugin memory callbacks, which need to see every element), and for a
+ * segment that crosses a page boundary, @ldst_tlb is used for each
+ * element with vstart pointing at the current segment, so that an exception
+ * leaves vstart as the spec requires.
+ */
+static inline QEMU_ALWAYS_INLINE void
+vext_ldst_contig(CPURISCVState *env, void *vd, target_ulong base,
+                 uint32_t evl, uint32_t nf, uint32_t max_elems,
+                 uint32_t esz, uint32_t msz, bool is_load,
+                 vext_ldst_elem_fn *ldst_tlb,
+                 vext_ldst_elem_fn_host *ldst_host, uintptr_t ra)
+{
+    MMUAccessType access_type = is_load ? MMU_DATA_LOAD : MMU_DATA_STORE;
+    int mmu_index = riscv_env_mmu_index(env, false);
+    bool mem_cbs = cpu_plugin_mem_cbs_enabled(env_cpu(env));
+    uint32_t segsz = nf * msz;
+
+    while (env->vstart < evl) {
+        target_ulong addr = base + (target_ulong)env->vstart * segsz;
+        target_ulong page_left = -(addr | TARGET_PAGE_MASK);
+        uint32_t elems = MIN(page_left / segsz, evl - env->vstart);
+        uint32_t i, k;
+        void *host;
+        int flags;
+
+        if (unlikely(elems == 0)) {
+            /* The segment crosses a page boundary */
+            for (k = 0; k < nf; k++) {
+                ldst_tlb(env, adjust_addr(env, addr + k * msz),
+                         env->vstart + k * max_elems, vd, ra);
+            }
+            env->vstart++;
+            continue;
+        }
+
+        flags = probe_access_flags(env, adjust_addr(env, addr),
+                                   elems * segsz, access_type, mmu_index,
+                                   true, &host, ra);
+        if (unlikely(flags || mem_cbs)) {
+            for (i = 0; i < elems; i++, env->vstart++) {
+                for (k = 0; k < nf; k++) {
+                    ldst_tlb(env, adjust_addr(env, addr + k * msz),
+                             env->vstart + k * max_elems, vd, ra);
+                }
+                addr += segsz;
+            }
+            continue;
+        }
+
+        if (!HOST_BIG_ENDIAN && nf == 1 && esz == 1 && msz == 1) {
+            /* Byte elements are laid out as in memory */
+            if (is_load) {
+                memcpy(vd + env->vstart, host, elems);
+            } else {
+                memcpy(host, vd + env->vstart, elems);
+            }
+        } else {
+            for (i = env->vstart; i < env->vstart + elems; i++) {
+                for (k = 0; k < nf; k++) {
+                    ldst_host(vd, i + k * max_elems, host);
+                    host += msz;
+                }
+            }
+        }
+        env->vstart += elems;
+    }
+}
+
 int8_t do_mulh_b(int8_t s2, int8_t s1);
 int16_t do_mulh_h(int16_t s2, int16_t s1);
 int32_t do_mulh_w(int32_t s2, int32_t s1);
@@ -169,6 +169,15 @@ static void NAME(CPURISCVState *env, abi_ptr addr,         \
     data = cpu_##LDSUF##_data_ra(env, addr, retaddr);      \
     *cur = data;                                           \
 }                                                          \
+                                                           \
+static inline QEMU_ALWAYS_INLINE                           \
+void NAME##_host(void *vd, uint32_t idx, void *host)       \
+{                                                          \
+    MTYPE data;                                            \
+    ETYPE *cur = ((ETYPE *)vd + H(idx));                   \
+    data = LDSUF##_p(host);                                \
+    *cur = data;                                           \
+}
 
 GEN_TH_LD_ELEM(ldb_b, int8_t,  int8_t,  H1, ldsb)
 GEN_TH_LD_ELEM(ldb_h, int8_t,  int16_t, H2, ldsb)
@@ -199,6 +208,13 @@ static void NAME(CPURISCVState *env, abi_ptr addr,         \
 {                                                          \
     ETYPE data = *((ETYPE *)vd + H(idx));                  \
     cpu_##STSUF##_data_ra(env, addr, data, retaddr);       \
+}                                                          \
+                                                           \
+static inline QEMU_ALWAYS_INLINE                           \
+void NAME##_host(void *vd, uint32_t idx, void *host)       \
+{                                                          \
+    ETYPE data = *((ETYPE *)vd + H(idx));                  \
+    STSUF##_p(host, data);                                 \
 }
 
 GEN_TH_ST_ELEM(stb_b, int8_t,  H1, stb)
@@ -346,26 +362,20 @@ GEN_TH_ST_STRIDE(th_vsse_v_d, int64_t, int64_t, ste_d)
  * 2) different data encoding
  * 3) different the tail elements process policy
  */
-static void
+static inline QEMU_ALWAYS_INLINE void
 th_ldst_us(void *vd, target_ulong base, CPURISCVState *env, uint32_t desc,
-           th_ldst_elem_fn *ldst_elem, clear_fn *clear_elem,
-           uint32_t esz, uint32_t msz, uintptr_t ra)
+           th_ldst_elem_fn *ldst_elem, vext_ldst_elem_fn_host *ldst_host,
+           clear_fn *clear_elem, uint32_t esz, uint32_t msz, uintptr_t ra,
+           bool is_load)
 {
-    uint32_t i, k;
+    uint32_t k;
     uint32_t nf = th_nf(desc);
     uint32_t vlmax = th_maxsz(desc) / esz;
 
     VSTART_CHECK_EARLY_EXIT(env);
 
-    /* load bytes from guest memory */
-    for (i = env->vstart; i < env->vl; env->vstart = ++i) {
-        k = 0;
-        while (k < nf) {
-            target_ulong addr = base + (i * nf + k) * msz;
-            ldst_elem(env, adjust_addr(env, addr), i + k * vlmax, vd, ra);
-            k++;
-        }
-    }
+    vext_ldst_contig(env, vd, base, env->vl, nf, vlmax, esz, msz,
+                     is_load, ldst_elem, ldst_host, ra);
     env->vstart = 0;
     /* clear tail elements */
     if (clear_elem) {
@@ -393,8 +403,8 @@ void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,         \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,                \
                   CPURISCVState *env, uint32_t desc)                    \
 {                                                                       \
-    th_ldst_us(vd, base, env, desc, LOAD_FN, CLEAR_FN,                  \
-               sizeof(ETYPE), sizeof(MTYPE), GETPC());                  \
+    th_ldst_us(vd, base, env, desc, LOAD_FN, LOAD_FN##_host, CLEAR_FN,  \
+               sizeof(ETYPE), sizeof(MTYPE), GETPC(), true);            \
 }
 
 GEN_TH_LD_US(th_vlb_v_b,  int8_t,   int8_t,   ldb_b,  clearb_th)
@@ -433,8 +443,8 @@ void HELPER(NAME##_mask)(void *vd, void *v0, target_ulong base,         \
 void HELPER(NAME)(void *vd, void *v0, target_ulong base,                \
                   CPURISCVState *env, uint32_t desc)                    \
 {                                                                       \
-    th_ldst_us(vd, base, env, desc, STORE_FN, NULL,                     \
-               sizeof(ETYPE), sizeof(MTYPE), GETPC());                  \
+    th_ldst_us(vd, base, env, desc, STORE_FN, STORE_FN##_host, NULL,    \
+               sizeof(ETYPE), sizeof(MTYPE), GETPC(), false);           \
 }
 
 GEN_TH_ST_US(th_vsb_v_b, int8_t,  int8_t , stb_b)
@@ -623,6 +633,7 @@ ProbeSuccess:
     /* load bytes from guest memory */
     if (vl != 0) {
         env->vl = vl;
+        riscv_cpu_update_vl_mask(env);
     }
     for (i = env->vstart; i < env->vl; i++) {
         k = 0;
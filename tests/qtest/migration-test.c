@@ -1914,6 +1914,27 @@ static void test_precopy_unix_plain(void)
     test_precopy_common(&args);
 }
 
+static void *migrate_dirty_extents_start(QTestState *from, QTestState *to)
+{
+    migrate_set_capability(from, "dirty-extents", true);
+    migrate_set_capability(to, "dirty-extents", true);
+
+    return NULL;
+}
+
+static void test_precopy_unix_dirty_extents(void)
+{
+    g_autofree char *uri = g_strdup_printf("unix:%s/migsocket", tmpfs);
+    MigrateCommon args = {
+        .listen_uri = uri,
+        .connect_uri = uri,
+        .start_hook = migrate_dirty_extents_start,
+        .live = true,
+    };
+
+    test_precopy_common(&args);
+}
+
 static void test_precopy_unix_suspend_live(void)
 {
     g_autofree char *uri = g_strdup_printf("unix:%s/migsocket", tmpfs);
@@ -3613,6 +3634,8 @@ int main(int argc, char **argv)
 #endif
     migration_test_add("/migration/precopy/unix/plain",
                        test_precopy_unix_plain);
+    migration_test_add("/migration/precopy/unix/dirty-extents",
+                       test_precopy_unix_dirty_extents);
     migration_test_add("/migration/precopy/unix/xbzrle",
                        test_precopy_unix_xbzrle);
     /*
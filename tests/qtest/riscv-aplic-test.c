@@ -0,0 +1,184 @@
+/*
+ * QTest testcase for the RISC-V APLIC in direct delivery mode
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2 or later, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qemu/osdep.h"
+#include "libqtest.h"
+#include "qapi/qmp/qdict.h"
+#include "qapi/qmp/qlist.h"
+
+/* M-level APLIC of the virt machine, socket 0 */
+#define APLIC_BASE              0xc000000
+#define APLIC_NUM_SOURCES       96
+#define APLIC_NUM_PRIOS         7
+
+#define APLIC_DOMAINCFG         0x0000
+#define APLIC_DOMAINCFG_IE      (1 << 8)
+#define APLIC_SOURCECFG(irq)    (0x0004 + ((irq) - 1) * 4)
+#define APLIC_SM_LEVEL_HIGH     0x6
+#define APLIC_SETIENUM          0x1edc
+#define APLIC_TARGET(irq)       (0x3004 + ((irq) - 1) * 4)
+#define APLIC_IDC_IDELIVERY     0x4000
+#define APLIC_IDC_ITHRESHOLD    0x4008
+#define APLIC_IDC_TOPI          0x4018
+#define APLIC_IDC_CLAIMI        0x401c
+
+#define TOPI(irq, prio)         (((irq) << 16) | (prio))
+
+static char *aplic_find_root(QTestState *qts)
+{
+    QDict *response;
+    QList *list;
+    QListEntry *entry;
+    char *path = NULL;
+
+    response = qtest_qmp(qts, "{ 'execute': 'qom-list',"
+                              "  'arguments': { 'path': "
+                              "'/machine/unattached' } }");
+    g_assert(qdict_haskey(response, "return"));
+    list = qdict_get_qlist(response, "return");
+    QLIST_FOREACH_ENTRY(list, entry) {
+        QDict *tuple = qobject_to(QDict, qlist_entry_obj(entry));
+        char *candidate;
+
+        if (strcmp(qdict_get_str(tuple, "type"), "child<riscv.aplic>")) {
+            continue;
+        }
+        candidate = g_strdup_printf("/machine/unattached/%s",
+                                    qdict_get_str(tuple, "name"));
+        if (qtest_qom_get_bool(qts, candidate, "mmode")) {
+            path = candidate;
+            break;
+        }
+        g_free(candidate);
+    }
+    qobject_unref(response);
+
+    g_assert(path);
+    return path;
+}
+
+static uint32_t aplic_prio(int irq)
+{
+    return irq % APLIC_NUM_PRIOS + 1;
+}
+
+/* All sources level-high, enabled and routed to hart 0 */
+static QTestState *aplic_setup(char **path)
+{
+    QTestState *qts = qtest_init("-M virt,aia=aplic -bios none");
+    int irq;
+
+    *path = aplic_find_root(qts);
+    qtest_writel(qts, APLIC_BASE + APLIC_DOMAINCFG, APLIC_DOMAINCFG_IE);
+    for (irq = 1; irq <= APLIC_NUM_SOURCES; irq++) {
+        qtest_set_irq_in(qts, *path, NULL, irq, 0);
+        qtest_writel(qts, APLIC_BASE + APLIC_SOURCECFG(irq),
+                     APLIC_SM_LEVEL_HIGH);
+        qtest_writel(qts, APLIC_BASE + APLIC_TARGET(irq), aplic_prio(irq));
+        qtest_writel(qts, APLIC_BASE + APLIC_SETIENUM, irq);
+    }
+    qtest_writel(qts, APLIC_BASE + APLIC_IDC_IDELIVERY, 1);
+
+    return qts;
+}
+
+static void test_topi(void)
+{
+    g_autofree char *path = NULL;
+    QTestState *qts = aplic_setup(&path);
+
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_TOPI), ==, 0);
+
+    /* 5 -> prio 6, 10 -> prio 4, 17 -> prio 4, 20 -> prio 7 */
+    qtest_set_irq_in(qts, path, NULL, 5, 1);
+    qtest_set_irq_in(qts, path, NULL, 20, 1);
+    qtest_set_irq_in(qts, path, NULL, 17, 1);
+    qtest_set_irq_in(qts, path, NULL, 10, 1);
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_TOPI), ==,
+                    TOPI(10, 4));
+
+    /* Only priorities below the threshold are signalled */
+    qtest_writel(qts, APLIC_BASE + APLIC_IDC_ITHRESHOLD, 4);
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_TOPI), ==, 0);
+    qtest_writel(qts, APLIC_BASE + APLIC_IDC_ITHRESHOLD, 0);
+
+    /* A claimed level source stays pending while its input is high */
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_CLAIMI), ==,
+                    TOPI(10, 4));
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_TOPI), ==,
+                    TOPI(10, 4));
+    qtest_set_irq_in(qts, path, NULL, 10, 0);
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_CLAIMI), ==,
+                    TOPI(10, 4));
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_TOPI), ==,
+                    TOPI(17, 4));
+
+    /* Changing the priority of a pending source moves it */
+    qtest_writel(qts, APLIC_BASE + APLIC_TARGET(20), 1);
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_TOPI), ==,
+                    TOPI(20, 1));
+
+    /* So does routing it to another hart */
+    qtest_writel(qts, APLIC_BASE + APLIC_TARGET(20), (1 << 18) | 1);
+    g_assert_cmphex(qtest_readl(qts, APLIC_BASE + APLIC_IDC_TOPI), ==,
+                    TOPI(17, 4));
+
+    qtest_quit(qts);
+}
+
+static void test_level_storm(void)
+{
+    g_autofree char *path = NULL;
+    QTestState *qts = aplic_setup(&path);
+    int i, irq, iterations = g_test_perf() ? 2000 : 20;
+    uint32_t topi;
+    double elapsed;
+
+    /* Keep every line asserted and claim them in priority order */
+    for (irq = 1; irq <= APLIC_NUM_SOURCES; irq++) {
+        qtest_set_irq_in(qts, path, NULL, irq, 1);
+    }
+
+    g_test_timer_start();
+    for (i = 0; i < iterations; i++) {
+        irq = i % APLIC_NUM_SOURCES + 1;
+        qtest_set_irq_in(qts, path, NULL, irq, 0);
+        qtest_set_irq_in(qts, path, NULL, irq, 1);
+        topi = qtest_readl(qts, APLIC_BASE + APLIC_IDC_CLAIMI);
+        g_assert_cmpuint(topi & 0xff, ==, 1);
+        g_assert_cmpuint(aplic_prio(topi >> 16), ==, 1);
+    }
+    elapsed = g_test_timer_elapsed();
+
+    if (g_test_perf()) {
+        g_test_minimized_result(elapsed * 1e9 / iterations,
+                                "%d level lines: %.0f ns per edge+claim",
+                                APLIC_NUM_SOURCES,
+                                elapsed * 1e9 / iterations);
+    }
+
+    qtest_quit(qts);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+
+    qtest_add_func("/riscv-aplic/direct/topi", test_topi);
+    qtest_add_func("/riscv-aplic/direct/level-storm", test_level_storm);
+
+    return g_test_run();
+}
@@ -0,0 +1,51 @@
+/*
+ * QTest helpers for booting hand-assembled RISC-V guest code
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/bswap.h"
+#include "riscv-boot-helpers.h"
+
+char *riscv_boot_write_bios(const uint32_t *code, size_t count)
+{
+    g_autofree uint32_t *image = g_new(uint32_t, count);
+    g_autofree char *dir = NULL;
+    char *bios;
+    size_t i;
+
+    dir = g_dir_make_tmp("qtest-riscv-boot-XXXXXX", NULL);
+    g_assert(dir);
+    bios = g_build_filename(dir, "bios.bin", NULL);
+
+    for (i = 0; i < count; i++) {
+        image[i] = cpu_to_le32(code[i]);
+    }
+    g_assert(g_file_set_contents(bios, (const char *)image,
+                                 count * sizeof(*image), NULL));
+    return bios;
+}
+
+void riscv_boot_wait_done(QTestState *qts, uint64_t addr)
+{
+    int i;
+
+    /* Wait at most 10 seconds */
+    for (i = 0; i < 1000; i++) {
+        if (qtest_readl(qts, addr) == RISCV_BOOT_DONE_MAGIC) {
+            return;
+        }
+        g_usleep(10 * 1000);
+    }
+    g_assert_cmphex(qtest_readl(qts, addr), ==, RISCV_BOOT_DONE_MAGIC);
+}
+
+void riscv_boot_remove_bios(const char *bios)
+{
+    g_autofree char *dir = g_path_get_dirname(bios);
+
+    unlink(bios);
+    rmdir(dir);
+}
@@ -0,0 +1,31 @@
+/*
+ * QTest helpers for booting hand-assembled RISC-V guest code
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#ifndef TEST_RISCV_BOOT_HELPERS_H
+#define TEST_RISCV_BOOT_HELPERS_H
+
+#include "libqtest.h"
+
+/* Start of RAM on the virt machine, where -bios images are loaded */
+#define RISCV_DRAM_BASE         0x80000000
+
+/* Stored by the guest code when it has finished */
+#define RISCV_BOOT_DONE_MAGIC   0x123
+
+/*
+ * Write @count instructions from @code as a little-endian -bios image in
+ * a new temporary directory, and return its file name.
+ */
+char *riscv_boot_write_bios(const uint32_t *code, size_t count);
+
+/* Wait for the guest to store RISCV_BOOT_DONE_MAGIC at @addr */
+void riscv_boot_wait_done(QTestState *qts, uint64_t addr);
+
+/* Remove the image and its directory, which must be otherwise empty */
+void riscv_boot_remove_bios(const char *bios);
+
+#endif /* TEST_RISCV_BOOT_HELPERS_H */
@@ -0,0 +1,151 @@
+/*
+ * QTest testcase for the RISC-V CBQRI occupancy and bandwidth models
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2 or later, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/bitops.h"
+#include "riscv-boot-helpers.h"
+
+#define DONE_ADDR               (RISCV_DRAM_BASE + 0x100)
+
+/* Controllers of the example SoC on the virt machine */
+#define LLC_BASE                0x0482b000
+#define MEM0_BASE               0x04828000
+#define MEM1_BASE               0x04829000
+#define MEM2_BASE               0x0482a000
+
+#define MON_CTL                 0x08
+#define MON_CTR_VAL             0x10
+
+#define MON_OP_CONFIG_EVENT     1
+#define MON_OP_READ_COUNTER     2
+#define MON_STATUS_SUCCESS      1
+
+#define CC_EVT_OCCUPANCY        1
+#define BC_EVT_RDWR             1
+#define BC_EVT_RDONLY           2
+#define BC_EVT_WRONLY           3
+
+#define MCID                    5
+#define MODEL_SETS              16
+#define LINE_SIZE               64
+#define NR_LOADS                64
+#define NR_STORES               32
+
+/*
+ * With MCID 5 in sqoscfg, load one doubleword from each of NR_LOADS
+ * consecutive lines at DRAM + 0x1000, then store NR_STORES doublewords
+ * to the first of those lines.  Then return to MCID 0 and store
+ * RISCV_BOOT_DONE_MAGIC.
+ */
+static const uint32_t guest_code[] = {
+    0x00000297,     /* auipc t0, 0 */
+    0x00050337,     /* lui t1, MCID << 16 >> 12 */
+    0x18131073,     /* csrw sqoscfg, t1 */
+    0x00001e37,     /* lui t3, 1 */
+    0x01c283b3,     /* add t2, t0, t3 */
+    0x04000e93,     /* li t4, NR_LOADS */
+    0x0003bf03,     /* 1: ld t5, 0(t2) */
+    0x04038393,     /* addi t2, t2, LINE_SIZE */
+    0xfffe8e93,     /* addi t4, t4, -1 */
+    0xfe0e9ae3,     /* bnez t4, 1b */
+    0x01c283b3,     /* add t2, t0, t3 */
+    0x02000e93,     /* li t4, NR_STORES */
+    0x0003b023,     /* 2: sd zero, 0(t2) */
+    0x00838393,     /* addi t2, t2, 8 */
+    0xfffe8e93,     /* addi t4, t4, -1 */
+    0xfe0e9ae3,     /* bnez t4, 2b */
+    0x18101073,     /* csrw sqoscfg, zero */
+    0x12300313,     /* li t1, RISCV_BOOT_DONE_MAGIC */
+    0x1062a023,     /* sw t1, 0x100(t0) */
+    0x0000006f,     /* j . */
+};
+
+static void mon_op(QTestState *qts, uint64_t base, int op, int evt_id)
+{
+    uint64_t ctl = op | (MCID << 8) | ((uint64_t)evt_id << 20);
+
+    qtest_writeq(qts, base + MON_CTL, ctl);
+    ctl = qtest_readq(qts, base + MON_CTL);
+    g_assert_cmpuint(extract64(ctl, 32, 7), ==, MON_STATUS_SUCCESS);
+}
+
+static uint64_t mon_read(QTestState *qts, uint64_t base)
+{
+    mon_op(qts, base, MON_OP_READ_COUNTER, 0);
+    return qtest_readq(qts, base + MON_CTR_VAL);
+}
+
+static void test_counters(void)
+{
+    g_autofree char *bios = NULL;
+    QTestState *qts;
+
+    bios = riscv_boot_write_bios(guest_code, ARRAY_SIZE(guest_code));
+
+    /* Every access is sampled; the CPU starts stopped */
+    qts = qtest_initf("-M virt -bios %s -accel tcg -S "
+                      "-cpu rv64,h=true,ssqosid=true "
+                      "-global driver=riscv.cbqri.capacity,"
+                      "property=occupancy-model,value=on "
+                      "-global driver=riscv.cbqri.capacity,"
+                      "property=sample-period,value=1 "
+                      "-global driver=riscv.cbqri.capacity,"
+                      "property=model-sets,value=%d "
+                      "-global driver=riscv.cbqri.bandwidth,"
+                      "property=bandwidth-model,value=on "
+                      "-global driver=riscv.cbqri.bandwidth,"
+                      "property=sample-period,value=1",
+                      bios, MODEL_SETS);
+
+    /* Bandwidth counters count from the time the event is configured */
+    mon_op(qts, LLC_BASE, MON_OP_CONFIG_EVENT, CC_EVT_OCCUPANCY);
+    mon_op(qts, MEM0_BASE, MON_OP_CONFIG_EVENT, BC_EVT_RDWR);
+    mon_op(qts, MEM1_BASE, MON_OP_CONFIG_EVENT, BC_EVT_RDONLY);
+    mon_op(qts, MEM2_BASE, MON_OP_CONFIG_EVENT, BC_EVT_WRONLY);
+    g_assert_cmpuint(mon_read(qts, LLC_BASE), ==, 0);
+    g_assert_cmpuint(mon_read(qts, MEM0_BASE), ==, 0);
+
+    qtest_qmp_assert_success(qts, "{ 'execute': 'cont' }");
+    riscv_boot_wait_done(qts, DONE_ADDR);
+
+    /*
+     * The loads allocate NR_LOADS / MODEL_SETS ways in every set, which
+     * is less than the LLC's 16 capacity blocks, and the stores hit.
+     */
+    g_assert_cmpuint(mon_read(qts, LLC_BASE), ==, NR_LOADS / MODEL_SETS);
+    g_assert_cmpuint(mon_read(qts, MEM0_BASE), ==,
+                     (NR_LOADS + NR_STORES) * 8);
+    g_assert_cmpuint(mon_read(qts, MEM1_BASE), ==, NR_LOADS * 8);
+    g_assert_cmpuint(mon_read(qts, MEM2_BASE), ==, NR_STORES * 8);
+
+    qtest_quit(qts);
+
+    riscv_boot_remove_bios(bios);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+
+    if (!qtest_has_accel("tcg")) {
+        g_test_skip("TCG is required to run the guest");
+        return 0;
+    }
+
+    qtest_add_func("/riscv-cbqri/counters", test_counters);
+
+    return g_test_run();
+}
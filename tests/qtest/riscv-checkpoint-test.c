@@ -0,0 +1,97 @@
+/*
+ * QTest testcase for RISC-V virt boot checkpoints
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2 or later, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qemu/osdep.h"
+#include "riscv-boot-helpers.h"
+
+#define RESULT_ADDR             (RISCV_DRAM_BASE + 0x100)
+#define DONE_ADDR               (RISCV_DRAM_BASE + 0x104)
+#define DATA_ADDR               (RISCV_DRAM_BASE + 0x200)
+
+#define DATA_MAGIC              0x5a5
+
+/*
+ * Store DATA_MAGIC, issue SYS_QEMU_CHECKPOINT, then store its return
+ * value and RISCV_BOOT_DONE_MAGIC and spin.  Without a checkpoint
+ * handler the call returns -1, so a zero result after a restore means
+ * the guest resumed from the checkpoint rather than running the call
+ * again.
+ */
+static const uint32_t guest_code[] = {
+    0x00000297,     /* auipc t0, 0 */
+    0x5a500313,     /* li t1, DATA_MAGIC */
+    0x2062a023,     /* sw t1, 0x200(t0) */
+    0x10000513,     /* li a0, 0x100 */
+    0x00000593,     /* li a1, 0 */
+    0x01f01013,     /* slli zero, zero, 0x1f */
+    0x00100073,     /* ebreak */
+    0x40705013,     /* srai zero, zero, 7 */
+    0x10a2a023,     /* sw a0, 0x100(t0) */
+    0x12300313,     /* li t1, RISCV_BOOT_DONE_MAGIC */
+    0x1062a223,     /* sw t1, 0x104(t0) */
+    0x0000006f,     /* j . */
+};
+
+static QTestState *checkpoint_boot(const char *bios, const char *ckpt)
+{
+    QTestState *qts;
+
+    qts = qtest_initf("-M virt,checkpoint=%s -bios %s -semihosting "
+                      "-accel tcg", ckpt, bios);
+    riscv_boot_wait_done(qts, DONE_ADDR);
+    return qts;
+}
+
+static void test_save_restore(void)
+{
+    g_autofree char *bios = NULL;
+    g_autofree char *ckpt = NULL;
+    g_autofree char *dir = NULL;
+    QTestState *qts;
+
+    bios = riscv_boot_write_bios(guest_code, ARRAY_SIZE(guest_code));
+    dir = g_path_get_dirname(bios);
+    ckpt = g_build_filename(dir, "boot.ckpt", NULL);
+
+    /* First boot: the marker writes the checkpoint and returns 0 */
+    qts = checkpoint_boot(bios, ckpt);
+    g_assert_cmphex(qtest_readl(qts, RESULT_ADDR), ==, 0);
+    g_assert(g_file_test(ckpt, G_FILE_TEST_EXISTS));
+    qtest_quit(qts);
+
+    /* Second boot: resume after the marker with RAM restored */
+    qts = checkpoint_boot(bios, ckpt);
+    g_assert_cmphex(qtest_readl(qts, RESULT_ADDR), ==, 0);
+    g_assert_cmphex(qtest_readl(qts, DATA_ADDR), ==, DATA_MAGIC);
+    qtest_quit(qts);
+
+    unlink(ckpt);
+    riscv_boot_remove_bios(bios);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+
+    if (!qtest_has_accel("tcg")) {
+        g_test_skip("TCG is required to run the guest");
+        return 0;
+    }
+
+    qtest_add_func("/riscv-checkpoint/save-restore", test_save_restore);
+
+    return g_test_run();
+}
@@ -0,0 +1,106 @@
+/*
+ * QTest testcase for the RISC-V PMU cache and branch model
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2 or later, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qemu/osdep.h"
+#include "riscv-boot-helpers.h"
+
+#define BRANCHES_ADDR           (RISCV_DRAM_BASE + 0x100)
+#define L1D_READS_ADDR          (RISCV_DRAM_BASE + 0x108)
+#define MCAUSE_ADDR             (RISCV_DRAM_BASE + 0x110)
+#define DONE_ADDR               (RISCV_DRAM_BASE + 0x118)
+
+#define LOOP_COUNT              100
+#define MCAUSE_LCOFI            0x800000000000000dULL
+
+/*
+ * Count branch-instructions in mhpmcounter3 and L1D read accesses in
+ * mhpmcounter4 over a loop of LOOP_COUNT loads and branches, and store
+ * both.  Then preset mhpmcounter3 16 branches short of wrapping, enable
+ * LCOFI and branch on; the trap handler stores mcause and
+ * RISCV_BOOT_DONE_MAGIC.
+ */
+static const uint32_t guest_code[] = {
+    0x00000297,     /* auipc t0, 0 */
+    0x00000317,     /* auipc t1, 0 */
+    0x06c30313,     /* addi t1, t1, handler - 4 */
+    0x30531073,     /* csrw mtvec, t1 */
+    0x00500313,     /* li t1, 5 (branch-instructions) */
+    0x32331073,     /* csrw mhpmevent3, t1 */
+    0x00010337,     /* li t1, 0x10000 (L1D read access) */
+    0x32431073,     /* csrw mhpmevent4, t1 */
+    0xb0301073,     /* csrw mhpmcounter3, zero */
+    0xb0401073,     /* csrw mhpmcounter4, zero */
+    0x32001073,     /* csrw mcountinhibit, zero */
+    0x06400393,     /* li t2, LOOP_COUNT */
+    0x2002be03,     /* 1: ld t3, 0x200(t0) */
+    0xfff38393,     /* addi t2, t2, -1 */
+    0xfe039ce3,     /* bnez t2, 1b */
+    0xb0302373,     /* csrr t1, mhpmcounter3 */
+    0x1062b023,     /* sd t1, 0x100(t0) */
+    0xb0402373,     /* csrr t1, mhpmcounter4 */
+    0x1062b423,     /* sd t1, 0x108(t0) */
+    0xff000313,     /* li t1, -16 */
+    0xb0331073,     /* csrw mhpmcounter3, t1 */
+    0x00002337,     /* li t1, MIP_LCOFIP */
+    0x30432073,     /* csrs mie, t1 */
+    0x30046073,     /* csrsi mstatus, MSTATUS_MIE */
+    0x06400393,     /* li t2, LOOP_COUNT */
+    0xfff38393,     /* 2: addi t2, t2, -1 */
+    0xfe039ee3,     /* bnez t2, 2b */
+    0x0000006f,     /* j . */
+    /* handler: */
+    0x34202373,     /* csrr t1, mcause */
+    0x1062b823,     /* sd t1, 0x110(t0) */
+    0x12300313,     /* li t1, RISCV_BOOT_DONE_MAGIC */
+    0x1062ac23,     /* sw t1, 0x118(t0) */
+    0x0000006f,     /* j . */
+};
+
+static void test_events(void)
+{
+    g_autofree char *bios = NULL;
+    QTestState *qts;
+
+    bios = riscv_boot_write_bios(guest_code, ARRAY_SIZE(guest_code));
+
+    /* A period of 1 flushes every branch and samples every access */
+    qts = qtest_initf("-M virt -bios %s -accel tcg "
+                      "-cpu rv64,sscofpmf=true,pmu-cache-model=true,"
+                      "pmu-sample-period=1", bios);
+    riscv_boot_wait_done(qts, DONE_ADDR);
+
+    g_assert_cmpuint(qtest_readq(qts, BRANCHES_ADDR), ==, LOOP_COUNT);
+    g_assert_cmpuint(qtest_readq(qts, L1D_READS_ADDR), >=, LOOP_COUNT);
+    g_assert_cmphex(qtest_readq(qts, MCAUSE_ADDR), ==, MCAUSE_LCOFI);
+
+    qtest_quit(qts);
+
+    riscv_boot_remove_bios(bios);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+
+    if (!qtest_has_accel("tcg")) {
+        g_test_skip("TCG is required to run the guest");
+        return 0;
+    }
+
+    qtest_add_func("/riscv-pmu-model/events", test_events);
+
+    return g_test_run();
+}
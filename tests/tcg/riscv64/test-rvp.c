@@ -0,0 +1,181 @@
+/*
+ * Test the inline expansion of the P extension 8-bit and 16-bit add/sub
+ * instructions against a lane-by-lane reference.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RVP_OP(NAME, FUNCT7)                                    \
+static uint64_t NAME(uint64_t a, uint64_t b)                    \
+{                                                               \
+    uint64_t d;                                                 \
+    asm volatile(".insn r 0x77, 0x0, " #FUNCT7 ", %0, %1, %2"   \
+                 : "=r"(d) : "r"(a), "r"(b));                   \
+    return d;                                                   \
+}
+
+RVP_OP(add16, 0x20)
+RVP_OP(radd16, 0x00)
+RVP_OP(uradd16, 0x10)
+RVP_OP(kadd16, 0x08)
+RVP_OP(ukadd16, 0x18)
+RVP_OP(sub16, 0x21)
+RVP_OP(rsub16, 0x01)
+RVP_OP(ursub16, 0x11)
+RVP_OP(ksub16, 0x09)
+RVP_OP(uksub16, 0x19)
+RVP_OP(add8, 0x24)
+RVP_OP(radd8, 0x04)
+RVP_OP(uradd8, 0x14)
+RVP_OP(kadd8, 0x0c)
+RVP_OP(ukadd8, 0x1c)
+RVP_OP(sub8, 0x25)
+RVP_OP(rsub8, 0x05)
+RVP_OP(ursub8, 0x15)
+RVP_OP(ksub8, 0x0d)
+RVP_OP(uksub8, 0x1d)
+
+enum { WRAP, HALVE, SATURATE };
+
+typedef struct {
+    const char *name;
+    uint64_t (*fn)(uint64_t, uint64_t);
+    int bits;
+    bool sign;
+    bool sub;
+    int mode;
+} RVPTest;
+
+static const RVPTest tests[] = {
+    { "add16", add16, 16, false, false, WRAP },
+    { "radd16", radd16, 16, true, false, HALVE },
+    { "uradd16", uradd16, 16, false, false, HALVE },
+    { "kadd16", kadd16, 16, true, false, SATURATE },
+    { "ukadd16", ukadd16, 16, false, false, SATURATE },
+    { "sub16", sub16, 16, false, true, WRAP },
+    { "rsub16", rsub16, 16, true, true, HALVE },
+    { "ursub16", ursub16, 16, false, true, HALVE },
+    { "ksub16", ksub16, 16, true, true, SATURATE },
+    { "uksub16", uksub16, 16, false, true, SATURATE },
+    { "add8", add8, 8, false, false, WRAP },
+    { "radd8", radd8, 8, true, false, HALVE },
+    { "uradd8", uradd8, 8, false, false, HALVE },
+    { "kadd8", kadd8, 8, true, false, SATURATE },
+    { "ukadd8", ukadd8, 8, false, false, SATURATE },
+    { "sub8", sub8, 8, false, true, WRAP },
+    { "rsub8", rsub8, 8, true, true, HALVE },
+    { "ursub8", ursub8, 8, false, true, HALVE },
+    { "ksub8", ksub8, 8, true, true, SATURATE },
+    { "uksub8", uksub8, 8, false, true, SATURATE },
+};
+
+static uint64_t read_vxsat(void)
+{
+    uint64_t v;
+
+    asm volatile("csrr %0, 0x009" : "=r"(v));
+    return v;
+}
+
+static void clear_vxsat(void)
+{
+    asm volatile("csrw 0x009, zero");
+}
+
+static int64_t lane(const RVPTest *t, uint64_t x, int i)
+{
+    uint64_t mask = (1ull << t->bits) - 1;
+    int64_t v = (x >> (i * t->bits)) & mask;
+
+    if (t->sign && (v >> (t->bits - 1))) {
+        v -= 1ll << t->bits;
+    }
+    return v;
+}
+
+static uint64_t reference(const RVPTest *t, uint64_t a, uint64_t b,
+                          bool *sat)
+{
+    uint64_t mask = (1ull << t->bits) - 1;
+    int64_t max = t->sign ? (int64_t)(mask >> 1) : (int64_t)mask;
+    int64_t min = t->sign ? -max - 1 : 0;
+    uint64_t res = 0;
+    int i;
+
+    *sat = false;
+    for (i = 0; i < 64 / t->bits; i++) {
+        int64_t x = lane(t, a, i), y = lane(t, b, i);
+        int64_t r = t->sub ? x - y : x + y;
+
+        if (t->mode == HALVE) {
+            r >>= 1;
+        } else if (t->mode == SATURATE && (r > max || r < min)) {
+            r = r > max ? max : min;
+            *sat = true;
+        }
+        res |= ((uint64_t)r & mask) << (i * t->bits);
+    }
+    return res;
+}
+
+static const uint64_t edge[] = {
+    0, 1, 0x7f, 0x80, 0xff, 0x7fff, 0x8000, 0xffff,
+    0x7f7f7f7f7f7f7f7full, 0x8080808080808080ull,
+    0x7fff7fff7fff7fffull, 0x8000800080008000ull,
+    0xffffffffffffffffull, 0x0123456789abcdefull,
+};
+
+static uint64_t rand64(void)
+{
+    return ((uint64_t)random() << 42) ^ ((uint64_t)random() << 21) ^ random();
+}
+
+static int check(const RVPTest *t, uint64_t a, uint64_t b)
+{
+    uint64_t expect, got, vxsat;
+    bool sat;
+
+    expect = reference(t, a, b, &sat);
+    clear_vxsat();
+    got = t->fn(a, b);
+    vxsat = read_vxsat();
+
+    if (got != expect || (t->mode == SATURATE && vxsat != sat)) {
+        printf("%s(0x%016llx, 0x%016llx) = 0x%016llx vxsat %llu, "
+               "expected 0x%016llx vxsat %d\n", t->name,
+               (unsigned long long)a, (unsigned long long)b,
+               (unsigned long long)got, (unsigned long long)vxsat,
+               (unsigned long long)expect, sat);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int err = 0;
+    int i, j, k;
+
+    srandom(1);
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        const RVPTest *t = &tests[i];
+
+        for (j = 0; j < sizeof(edge) / sizeof(edge[0]); j++) {
+            for (k = 0; k < sizeof(edge) / sizeof(edge[0]); k++) {
+                err |= check(t, edge[j], edge[k]);
+            }
+        }
+        for (j = 0; j < 10000; j++) {
+            uint64_t a = rand64();
+            uint64_t b = rand64();
+
+            err |= check(t, a, b);
+        }
+    }
+    return err;
+}
@@ -0,0 +1,218 @@
+/*
+ * Microbenchmark for the RVV integer OPIVV/OPIVX helpers.
+ *
+ * Time vadd/vand/vmul in their .vv and .vx forms at every SEW, with and
+ * without a mask, and check each result against a scalar reference.
+ * Each chunk is loaded once and the operation repeated REPS times in
+ * registers, so that the time is dominated by the helper under test.
+ *
+ * Usage: test-rvv-bench [iterations]
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NELEMS          1024
+#define REPS            8
+#define STR(x)          #x
+#define XSTR(x)         STR(x)
+#define DEFAULT_ITERS   20
+
+static uint8_t mask[NELEMS / 8];
+
+/*
+ * One strip-mined pass over n elements with LMUL=8: v8 = a, v16 = b,
+ * v24 = d, then REPS times "vd = v8 OP v16" under the mask (if any),
+ * and store v24 back to d.  Masked-off elements are undisturbed.
+ */
+#define RVV_VV(NAME, SEW, T, INSN, MASKED)                              \
+static void NAME(T *d, const T *a, const T *b, size_t n)                \
+{                                                                       \
+    const uint8_t *m = mask;                                            \
+    size_t vl;                                                          \
+                                                                        \
+    for (; n > 0; n -= vl, a += vl, b += vl, d += vl, m += vl / 8) {    \
+        asm volatile("vsetvli %0, %1, e" #SEW ", m8, ta, mu\n\t"        \
+                     "vle" #SEW ".v v8, (%2)\n\t"                       \
+                     "vle" #SEW ".v v16, (%3)\n\t"                      \
+                     "vle" #SEW ".v v24, (%4)\n\t"                      \
+                     "vlm.v v0, (%5)\n\t"                               \
+                     ".rept " XSTR(REPS) "\n\t"                         \
+                     INSN ".vv v24, v8, v16" MASKED "\n\t"              \
+                     ".endr\n\t"                                        \
+                     "vse" #SEW ".v v24, (%4)"                          \
+                     : "=&r"(vl)                                        \
+                     : "r"(n), "r"(a), "r"(b), "r"(d), "r"(m)           \
+                     : "memory");                                       \
+    }                                                                   \
+}
+
+#define RVV_VX(NAME, SEW, T, INSN, MASKED)                              \
+static void NAME(T *d, const T *a, T b, size_t n)                       \
+{                                                                       \
+    const uint8_t *m = mask;                                            \
+    size_t vl;                                                          \
+                                                                        \
+    for (; n > 0; n -= vl, a += vl, d += vl, m += vl / 8) {             \
+        asm volatile("vsetvli %0, %1, e" #SEW ", m8, ta, mu\n\t"        \
+                     "vle" #SEW ".v v8, (%2)\n\t"                       \
+                     "vle" #SEW ".v v24, (%4)\n\t"                      \
+                     "vlm.v v0, (%5)\n\t"                               \
+                     ".rept " XSTR(REPS) "\n\t"                         \
+                     INSN ".vx v24, v8, %3" MASKED "\n\t"               \
+                     ".endr\n\t"                                        \
+                     "vse" #SEW ".v v24, (%4)"                          \
+                     : "=&r"(vl)                                        \
+                     : "r"(n), "r"(a), "r"((uint64_t)b), "r"(d), "r"(m) \
+                     : "memory");                                       \
+    }                                                                   \
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int iters = DEFAULT_ITERS;
+static int errors;
+
+static void report(const char *name, int masked, double start)
+{
+    double ns = (now() - start) * 1e9 / ((double)iters * NELEMS * REPS);
+
+    printf("%-12s %-8s %8.3f ns/element\n", name,
+           masked ? "masked" : "unmasked", ns);
+}
+
+/*
+ * For one (op, SEW) pair, instantiate the four asm variants and a
+ * function that times and checks each of them.
+ */
+#define RVV_BENCH(OP, SEW, T, EXPR)                                     \
+RVV_VV(OP##_vv_e##SEW, SEW, T, #OP, "")                                 \
+RVV_VV(OP##_vv_e##SEW##_m, SEW, T, #OP, ", v0.t")                       \
+RVV_VX(OP##_vx_e##SEW, SEW, T, #OP, "")                                 \
+RVV_VX(OP##_vx_e##SEW##_m, SEW, T, #OP, ", v0.t")                       \
+                                                                        \
+static T OP##_e##SEW(T x, T y)                                          \
+{                                                                       \
+    return EXPR;                                                        \
+}                                                                       \
+                                                                        \
+static void check_##OP##_e##SEW(const char *name, const T *d,           \
+                                const T *a, const T *b, T s,            \
+                                int vx, int masked)                     \
+{                                                                       \
+    int i;                                                              \
+                                                                        \
+    for (i = 0; i < NELEMS; i++) {                                      \
+        T old = (T)(i * 0x9e3779b97f4a7c15ull);                         \
+        T want = OP##_e##SEW(a[i], vx ? s : b[i]);                      \
+                                                                        \
+        if (masked && !(mask[i / 8] & (1 << (i % 8)))) {                \
+            want = old;                                                 \
+        }                                                               \
+        if (d[i] != want) {                                             \
+            printf("FAIL: %s%s element %d: %#llx != %#llx\n", name,     \
+                   masked ? " masked" : "", i,                          \
+                   (unsigned long long)d[i], (unsigned long long)want); \
+            errors++;                                                   \
+            return;                                                     \
+        }                                                               \
+    }                                                                   \
+}                                                                       \
+                                                                        \
+static void bench_##OP##_e##SEW(void)                                   \
+{                                                                       \
+    static T a[NELEMS], b[NELEMS], d[NELEMS];                           \
+    T s = (T)0x5a5a5a5a5a5a5a5aull;                                     \
+    double start;                                                       \
+    int masked, it, i;                                                  \
+                                                                        \
+    for (i = 0; i < NELEMS; i++) {                                      \
+        a[i] = (T)(i * 0x0123456789abcdefull + 1);                      \
+        b[i] = (T)(i * 0xfedcba9876543210ull + 3);                      \
+    }                                                                   \
+    for (masked = 0; masked < 2; masked++) {                            \
+        for (i = 0; i < NELEMS; i++) {                                  \
+            d[i] = (T)(i * 0x9e3779b97f4a7c15ull);                      \
+        }                                                               \
+        start = now();                                                  \
+        for (it = 0; it < iters; it++) {                                \
+            if (masked) {                                               \
+                OP##_vv_e##SEW##_m(d, a, b, NELEMS);                    \
+            } else {                                                    \
+                OP##_vv_e##SEW(d, a, b, NELEMS);                        \
+            }                                                           \
+        }                                                               \
+        report(#OP ".vv e" #SEW, masked, start);                        \
+        check_##OP##_e##SEW(#OP ".vv e" #SEW, d, a, b, s, 0, masked);   \
+                                                                        \
+        for (i = 0; i < NELEMS; i++) {                                  \
+            d[i] = (T)(i * 0x9e3779b97f4a7c15ull);                      \
+        }                                                               \
+        start = now();                                                  \
+        for (it = 0; it < iters; it++) {                                \
+            if (masked) {                                               \
+                OP##_vx_e##SEW##_m(d, a, s, NELEMS);                    \
+            } else {                                                    \
+                OP##_vx_e##SEW(d, a, s, NELEMS);                        \
+            }                                                           \
+        }                                                               \
+        report(#OP ".vx e" #SEW, masked, start);                        \
+        check_##OP##_e##SEW(#OP ".vx e" #SEW, d, a, b, s, 1, masked);   \
+    }                                                                   \
+}
+
+#define RVV_BENCH_ALL_SEW(OP, EXPR)                                     \
+RVV_BENCH(OP, 8, uint8_t, EXPR)                                         \
+RVV_BENCH(OP, 16, uint16_t, EXPR)                                       \
+RVV_BENCH(OP, 32, uint32_t, EXPR)                                       \
+RVV_BENCH(OP, 64, uint64_t, EXPR)
+
+RVV_BENCH_ALL_SEW(vadd, x + y)
+RVV_BENCH_ALL_SEW(vand, x & y)
+RVV_BENCH_ALL_SEW(vmul, (uint64_t)x * y)
+
+static void (*const benches[])(void) = {
+    bench_vadd_e8, bench_vadd_e16, bench_vadd_e32, bench_vadd_e64,
+    bench_vand_e8, bench_vand_e16, bench_vand_e32, bench_vand_e64,
+    bench_vmul_e8, bench_vmul_e16, bench_vmul_e32, bench_vmul_e64,
+};
+
+int main(int argc, char **argv)
+{
+    size_t i;
+
+    if (argc > 1) {
+        iters = atoi(argv[1]);
+        if (iters <= 0) {
+            fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Every third element is active */
+    for (i = 0; i < NELEMS; i++) {
+        if (i % 3 == 0) {
+            mask[i / 8] |= 1 << (i % 8);
+        }
+    }
+
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        benches[i]();
+    }
+
+    if (errors) {
+        printf("%d failures\n", errors);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+/*
+ * Timer list heap ordering tests
+ *
+ * This work is licensed under the terms of the GNU LGPL, version 2 or later.
+ * See the COPYING.LIB file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/timer.h"
+
+#define NTIMERS         64
+#define NOT_ARMED       -1
+/* Far enough from now that these timers never expire during a test */
+#define FAR_FUTURE      (INT64_MAX / 2)
+
+typedef struct TestTimer {
+    QEMUTimer timer;
+    int index;
+    /* Reference model: expire time (or NOT_ARMED) and arming order */
+    int64_t expire;
+    uint64_t seq;
+} TestTimer;
+
+static QEMUTimerListGroup tlg;
+static QEMUTimerList *timer_list;
+static TestTimer timers[NTIMERS];
+static uint64_t next_seq;
+static GArray *fired;
+
+static void notify_cb(void *opaque, QEMUClockType type)
+{
+}
+
+static void timer_cb(void *opaque)
+{
+    TestTimer *t = opaque;
+
+    g_assert_cmpint(t->expire, !=, NOT_ARMED);
+    t->expire = NOT_ARMED;
+    g_array_append_val(fired, t->index);
+}
+
+static void timers_init(void)
+{
+    int i;
+
+    timerlistgroup_init(&tlg, notify_cb, NULL);
+    timer_list = tlg.tl[QEMU_CLOCK_REALTIME];
+    fired = g_array_new(false, false, sizeof(int));
+    next_seq = 0;
+    for (i = 0; i < NTIMERS; i++) {
+        timer_init_full(&timers[i].timer, &tlg, QEMU_CLOCK_REALTIME,
+                        SCALE_NS, 0, timer_cb, &timers[i]);
+        timers[i].index = i;
+        timers[i].expire = NOT_ARMED;
+    }
+}
+
+static void timers_cleanup(void)
+{
+    int i;
+
+    for (i = 0; i < NTIMERS; i++) {
+        timer_del(&timers[i].timer);
+        timer_deinit(&timers[i].timer);
+    }
+    timerlistgroup_deinit(&tlg);
+    g_array_free(fired, true);
+}
+
+static void model_mod(int i, int64_t expire)
+{
+    timer_mod_ns(&timers[i].timer, expire);
+    timers[i].expire = expire;
+    timers[i].seq = next_seq++;
+}
+
+static void model_mod_anticipate(int i, int64_t expire)
+{
+    timer_mod_anticipate_ns(&timers[i].timer, expire);
+    if (timers[i].expire == NOT_ARMED || timers[i].expire > expire) {
+        timers[i].expire = expire;
+        timers[i].seq = next_seq++;
+    }
+}
+
+static void model_del(int i)
+{
+    timer_del(&timers[i].timer);
+    timers[i].expire = NOT_ARMED;
+}
+
+static void check_pending(void)
+{
+    int i;
+
+    for (i = 0; i < NTIMERS; i++) {
+        g_assert_cmpint(timer_pending(&timers[i].timer), ==,
+                        timers[i].expire != NOT_ARMED);
+        g_assert_cmpint(timer_expire_time_ns(&timers[i].timer), ==,
+                        timers[i].expire);
+    }
+}
+
+static gint model_cmp(gconstpointer a, gconstpointer b)
+{
+    const TestTimer *ta = &timers[*(const int *)a];
+    const TestTimer *tb = &timers[*(const int *)b];
+
+    if (ta->expire != tb->expire) {
+        return ta->expire < tb->expire ? -1 : 1;
+    }
+    return ta->seq < tb->seq ? -1 : ta->seq > tb->seq;
+}
+
+/*
+ * Run the expired timers and check that exactly the armed timers that are
+ * not in the far future fired, earliest expire time first and, among
+ * equal expire times, in the order they were armed.
+ */
+static void run_and_check(void)
+{
+    g_autoptr(GArray) expected = g_array_new(false, false, sizeof(int));
+    int i;
+
+    for (i = 0; i < NTIMERS; i++) {
+        if (timers[i].expire != NOT_ARMED && timers[i].expire < FAR_FUTURE) {
+            g_array_append_val(expected, i);
+        }
+    }
+    g_array_sort(expected, model_cmp);
+
+    g_array_set_size(fired, 0);
+    g_assert_cmpint(timerlist_run_timers(timer_list), ==, expected->len > 0);
+    g_assert_cmpint(fired->len, ==, expected->len);
+    for (i = 0; i < expected->len; i++) {
+        g_assert_cmpint(g_array_index(fired, int, i), ==,
+                        g_array_index(expected, int, i));
+    }
+    check_pending();
+}
+
+static void test_expire_order(void)
+{
+    int i;
+
+    timers_init();
+    /* Sixteen distinct expire times, four timers each */
+    for (i = 0; i < NTIMERS; i++) {
+        model_mod(i, (i * 37) % 16 + 1);
+    }
+    check_pending();
+    run_and_check();
+    g_assert_false(timerlist_has_timers(timer_list));
+    timers_cleanup();
+}
+
+static void test_same_expire(void)
+{
+    int i;
+
+    timers_init();
+    for (i = 0; i < NTIMERS; i++) {
+        model_mod(i, 1);
+    }
+    /* Re-arming at the same time moves a timer behind the others */
+    model_mod(3, 1);
+    model_mod(0, 1);
+    /* Anticipating to a later time leaves it where it is */
+    model_mod_anticipate(7, 2);
+    model_del(5);
+    model_del(NTIMERS - 1);
+    check_pending();
+    run_and_check();
+    timers_cleanup();
+}
+
+static void test_mod_del(void)
+{
+    int round, op, i;
+
+    timers_init();
+    for (round = 0; round < 20; round++) {
+        for (op = 0; op < 500; op++) {
+            int64_t expire = g_test_rand_int_range(1, 9);
+
+            i = g_test_rand_int_range(0, NTIMERS);
+            switch (g_test_rand_int_range(0, 4)) {
+            case 0:
+                model_mod(i, expire);
+                break;
+            case 1:
+                model_mod_anticipate(i, expire);
+                break;
+            case 2:
+                model_mod(i, FAR_FUTURE + expire);
+                break;
+            default:
+                model_del(i);
+                break;
+            }
+        }
+        check_pending();
+        g_assert_cmpint(timerlist_expired(timer_list), ==,
+                        timerlist_deadline_ns(timer_list) == 0);
+        run_and_check();
+    }
+    timers_cleanup();
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    init_clocks(NULL);
+
+    g_test_add_func("/timer-heap/expire-order", test_expire_order);
+    g_test_add_func("/timer-heap/same-expire", test_same_expire);
+    g_test_add_func("/timer-heap/mod-del", test_mod_del);
+
+    return g_test_run();
+}
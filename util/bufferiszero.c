@@ -203,6 +203,72 @@ buffer_zero_avx512(const void *buf, size_t len)
 # define INIT_ACCEL    buffer_zero_sse2
 #endif
 
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+/* Note that this requires len >= 64.  */
+
+static bool buffer_zero_neon(const void *buf, size_t len)
+{
+    uint64x2_t t = vld1q_u64(buf);
+    const uint64x2_t *p = (uint64x2_t *)(((uintptr_t)buf + 5 * 16) & -16);
+    const uint64x2_t *e = (uint64x2_t *)(((uintptr_t)buf + len) & -16);
+
+    /* Loop over 16-byte aligned blocks of 64.  */
+    while (likely(p <= e)) {
+        __builtin_prefetch(p);
+        /* The maximum across lanes is only zero if all bytes are zero.  */
+        if (unlikely(vmaxvq_u32(vreinterpretq_u32_u64(t)) != 0)) {
+            return false;
+        }
+        t = p[-4] | p[-3] | p[-2] | p[-1];
+        p += 4;
+    }
+
+    /* Finish the aligned tail.  */
+    t |= e[-3];
+    t |= e[-2];
+    t |= e[-1];
+
+    /* Finish the unaligned tail.  */
+    t |= vld1q_u64(buf + len - 16);
+
+    return vmaxvq_u32(vreinterpretq_u32_u64(t)) == 0;
+}
+
+# define INIT_USED     0
+# define INIT_LENGTH   0
+# define INIT_ACCEL    buffer_zero_int
+
+#elif defined(CONFIG_RVV_OPT)
+#include <riscv_vector.h>
+
+static bool __attribute__((target("arch=+v")))
+buffer_zero_rvv(const void *buf, size_t len)
+{
+    const uint8_t *p = buf;
+
+    /* Strip-mine over the buffer with the widest register group.  */
+    while (len) {
+        size_t vl = __riscv_vsetvl_e8m8(len);
+        vuint8m8_t v = __riscv_vle8_v_u8m8(p, vl);
+        vbool1_t nz = __riscv_vmsne_vx_u8m8_b1(v, 0, vl);
+
+        if (__riscv_vfirst_m_b1(nz, vl) >= 0) {
+            return false;
+        }
+        p += vl;
+        len -= vl;
+    }
+    return true;
+}
+
+# define INIT_USED     0
+# define INIT_LENGTH   0
+# define INIT_ACCEL    buffer_zero_int
+#endif
+
+#ifdef INIT_ACCEL
 static unsigned used_accel = INIT_USED;
 static unsigned length_to_accel = INIT_LENGTH;
 static bool (*buffer_accel)(const void *, size_t) = INIT_ACCEL;
@@ -223,7 +289,13 @@ select_accel_cpuinfo(unsigned info)
         { CPUINFO_AVX2,    128, buffer_zero_avx2 },
         { CPUINFO_SSE4,     64, buffer_zero_sse4 },
 #endif
+#if defined(CONFIG_AVX512F_OPT) || defined(CONFIG_AVX2_OPT) || defined(__SSE2__)
         { CPUINFO_SSE2,     64, buffer_zero_sse2 },
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+        { CPUINFO_ASIMD,    64, buffer_zero_neon },
+#elif defined(CONFIG_RVV_OPT)
+        { CPUINFO_RVV,      64, buffer_zero_rvv },
+#endif
         { CPUINFO_ALWAYS,    0, buffer_zero_int },
     };
 
@@ -237,12 +309,12 @@ select_accel_cpuinfo(unsigned info)
     return 0;
 }
 
-#if defined(CONFIG_AVX512F_OPT) || defined(CONFIG_AVX2_OPT)
+#if INIT_USED == 0
 static void __attribute__((constructor)) init_accel(void)
 {
     used_accel = select_accel_cpuinfo(cpuinfo_init());
 }
-#endif /* CONFIG_AVX2_OPT */
+#endif /* INIT_USED == 0 */
 
 bool test_buffer_is_zero_next_accel(void)
 {
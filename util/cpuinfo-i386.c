@@ -44,6 +44,9 @@ unsigned __attribute__((constructor)) cpuinfo_init(void)
         /* Our AES support requires PSHUFB as well. */
         info |= ((c & bit_AES) && (c & bit_SSSE3) ? CPUINFO_AES : 0);
 
+        /* Likewise the SHA-256 message schedule requires PALIGNR. */
+        info |= ((b7 & bit_SHA) && (c & bit_SSSE3) ? CPUINFO_SHA : 0);
+
         /* For AVX features, we must check available and usable. */
         if ((c & bit_AVX) && (c & bit_OSXSAVE)) {
             unsigned bv = xgetbv_low(0);
@@ -0,0 +1,44 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ * Host specific cpu identification for RISC-V.
+ */
+
+#include "qemu/osdep.h"
+#include "host/cpuinfo.h"
+
+#ifdef CONFIG_LINUX
+# ifdef CONFIG_GETAUXVAL
+#  include <sys/auxv.h>
+# else
+#  include "elf.h"
+# endif
+#endif
+
+/* Single letter extensions are reported as bits in AT_HWCAP. */
+#define RISCV_HWCAP_ISA(x)      (1ul << ((x) - 'A'))
+
+unsigned cpuinfo;
+
+/* Called both as constructor and (possibly) via other constructors. */
+unsigned __attribute__((constructor)) cpuinfo_init(void)
+{
+    unsigned info = cpuinfo;
+
+    if (info) {
+        return info;
+    }
+
+    info = CPUINFO_ALWAYS;
+
+#ifdef CONFIG_LINUX
+    /*
+     * The kernel only reports V when it also saves and restores the
+     * vector state, so this is sufficient to use it in userspace.
+     */
+    unsigned long hwcap = qemu_getauxval(AT_HWCAP);
+    info |= (hwcap & RISCV_HWCAP_ISA('V') ? CPUINFO_RVV : 0);
+#endif
+
+    cpuinfo = info;
+    return info;
+}
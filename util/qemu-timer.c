@@ -61,12 +61,21 @@ static QEMUClock qemu_clocks[QEMU_CLOCK_MAX];
  * used by different AioContexts / threads. Each clock also has
  * a list of the QEMUTimerLists associated with it, in order that
  * reenabling the clock can call all the notifiers.
+ *
+ * The armed timers are kept in a binary min-heap, so that arming and
+ * deleting a timer is O(log n) in the number of armed timers.  Timers
+ * with the same expire_time fire in the order they were armed.
+ * active_timers always points to the earliest timer, or is NULL.
  */
 
 struct QEMUTimerList {
     QEMUClock *clock;
     QemuMutex active_timers_lock;
     QEMUTimer *active_timers;
+    QEMUTimer **heap;
+    unsigned heap_len;
+    unsigned heap_size;
+    uint64_t heap_seq;
     QLIST_ENTRY(QEMUTimerList) list;
     QEMUTimerListNotifyCB *notify_cb;
     void *notify_opaque;
@@ -117,6 +126,7 @@ void timerlist_free(QEMUTimerList *timer_list)
         QLIST_REMOVE(timer_list, list);
     }
     qemu_mutex_destroy(&timer_list->active_timers_lock);
+    g_free(timer_list->heap);
     g_free(timer_list);
 }
 
@@ -247,6 +257,28 @@ int64_t timerlist_deadline_ns(QEMUTimerList *timer_list)
  * ignore whether or not the clock should be used in deadline
  * calculations.
  */
+static bool timer_before(QEMUTimer *a, QEMUTimer *b)
+{
+    return a->expire_time < b->expire_time ||
+           (a->expire_time == b->expire_time && a->heap_seq < b->heap_seq);
+}
+
+/* The earliest armed timer that has no attributes outside @attr_mask */
+static QEMUTimer *timerlist_first_with_attrs(QEMUTimerList *timer_list,
+                                             int attr_mask)
+{
+    QEMUTimer *ts = NULL, *t;
+    unsigned i;
+
+    for (i = 0; i < timer_list->heap_len; i++) {
+        t = timer_list->heap[i];
+        if (!(t->attributes & ~attr_mask) && (!ts || timer_before(t, ts))) {
+            ts = t;
+        }
+    }
+    return ts;
+}
+
 int64_t qemu_clock_deadline_ns_all(QEMUClockType type, int attr_mask)
 {
     int64_t deadline = -1;
@@ -267,8 +299,8 @@ int64_t qemu_clock_deadline_ns_all(QEMUClockType type, int attr_mask)
         qemu_mutex_lock(&timer_list->active_timers_lock);
         ts = timer_list->active_timers;
         /* Skip all external timers */
-        while (ts && (ts->attributes & ~attr_mask)) {
-            ts = ts->next;
+        if (ts && (ts->attributes & ~attr_mask)) {
+            ts = timerlist_first_with_attrs(timer_list, attr_mask);
         }
         if (!ts) {
             qemu_mutex_unlock(&timer_list->active_timers_lock);
@@ -378,43 +410,91 @@ void timer_deinit(QEMUTimer *ts)
     ts->timer_list = NULL;
 }
 
-static void timer_del_locked(QEMUTimerList *timer_list, QEMUTimer *ts)
+static void timerlist_heap_set(QEMUTimerList *timer_list, unsigned i,
+                               QEMUTimer *ts)
 {
-    QEMUTimer **pt, *t;
+    timer_list->heap[i] = ts;
+    ts->heap_index = i;
+}
 
-    ts->expire_time = -1;
-    pt = &timer_list->active_timers;
-    for(;;) {
-        t = *pt;
-        if (!t)
-            break;
-        if (t == ts) {
-            qatomic_set(pt, t->next);
+static void timerlist_heap_up(QEMUTimerList *timer_list, unsigned i)
+{
+    QEMUTimer *ts = timer_list->heap[i];
+    unsigned parent;
+
+    while (i) {
+        parent = (i - 1) / 2;
+        if (!timer_before(ts, timer_list->heap[parent])) {
             break;
         }
-        pt = &t->next;
+        timerlist_heap_set(timer_list, i, timer_list->heap[parent]);
+        i = parent;
     }
+    timerlist_heap_set(timer_list, i, ts);
 }
 
-static bool timer_mod_ns_locked(QEMUTimerList *timer_list,
-                                QEMUTimer *ts, int64_t expire_time)
+static void timerlist_heap_down(QEMUTimerList *timer_list, unsigned i)
 {
-    QEMUTimer **pt, *t;
+    QEMUTimer *ts = timer_list->heap[i];
+    unsigned child;
 
-    /* add the timer in the sorted list */
-    pt = &timer_list->active_timers;
     for (;;) {
-        t = *pt;
-        if (!timer_expired_ns(t, expire_time)) {
+        child = 2 * i + 1;
+        if (child >= timer_list->heap_len) {
             break;
         }
-        pt = &t->next;
+        if (child + 1 < timer_list->heap_len &&
+            timer_before(timer_list->heap[child + 1],
+                         timer_list->heap[child])) {
+            child++;
+        }
+        if (!timer_before(timer_list->heap[child], ts)) {
+            break;
+        }
+        timerlist_heap_set(timer_list, i, timer_list->heap[child]);
+        i = child;
+    }
+    timerlist_heap_set(timer_list, i, ts);
+}
+
+static void timer_del_locked(QEMUTimerList *timer_list, QEMUTimer *ts)
+{
+    QEMUTimer *last;
+    unsigned i;
+
+    if (ts->expire_time < 0) {
+        /* not armed, hence not in the heap */
+        return;
+    }
+    ts->expire_time = -1;
+
+    i = ts->heap_index;
+    last = timer_list->heap[--timer_list->heap_len];
+    if (last != ts) {
+        timerlist_heap_set(timer_list, i, last);
+        timerlist_heap_up(timer_list, i);
+        timerlist_heap_down(timer_list, last->heap_index);
+    }
+    qatomic_set(&timer_list->active_timers,
+                timer_list->heap_len ? timer_list->heap[0] : NULL);
+}
+
+static bool timer_mod_ns_locked(QEMUTimerList *timer_list,
+                                QEMUTimer *ts, int64_t expire_time)
+{
+    /* add the timer to the heap */
+    if (timer_list->heap_len == timer_list->heap_size) {
+        timer_list->heap_size = MAX(timer_list->heap_size * 2, 16);
+        timer_list->heap = g_renew(QEMUTimer *, timer_list->heap,
+                                   timer_list->heap_size);
     }
     ts->expire_time = MAX(expire_time, 0);
-    ts->next = *pt;
-    qatomic_set(pt, ts);
+    ts->heap_seq = timer_list->heap_seq++;
+    timerlist_heap_set(timer_list, timer_list->heap_len++, ts);
+    timerlist_heap_up(timer_list, ts->heap_index);
+    qatomic_set(&timer_list->active_timers, timer_list->heap[0]);
 
-    return pt == &timer_list->active_timers;
+    return timer_list->heap[0] == ts;
 }
 
 static void timerlist_rearm(QEMUTimerList *timer_list)
@@ -565,9 +645,7 @@ bool timerlist_run_timers(QEMUTimerList *timer_list)
         }
 
         /* remove timer from the list before calling the callback */
-        timer_list->active_timers = ts->next;
-        ts->next = NULL;
-        ts->expire_time = -1;
+        timer_del_locked(timer_list, ts);
         cb = ts->cb;
         opaque = ts->opaque;
 